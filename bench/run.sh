@@ -0,0 +1,32 @@
+#!/bin/sh
+# runs every benchmark program with each engine, printing wall-clock seconds,
+# then reports front end (scanner and parser) throughput on a generated script.
+# usage: bench/run.sh [path to sing]
+SING=${1:-build/sing}
+
+for program in bench/*.sg; do
+    for engine in tree closure; do
+        start=$(date +%s.%N)
+        "$SING" --engine=$engine "$program" > /dev/null || exit 1
+        end=$(date +%s.%N)
+        awk -v p="$(basename "$program")" -v e="$engine" -v s="$start" -v t="$end" \
+            'BEGIN { printf "%-16s %-8s %7.3fs\n", p, e, t - s }'
+    done
+done
+
+# front end throughput on a generated script of PARSE_BLOCKS blocks that never run
+PARSE_BLOCKS=${PARSE_BLOCKS:-20000}
+SOURCE=$(mktemp)
+awk -v n="$PARSE_BLOCKS" 'BEGIN {
+    for (i = 0; i < n; i++) {
+        printf "can (wrong) {\n    chope a%d = %d lah\n    chope b = a%d * 2 + 3 lah\n", i, i, i
+        printf "    print (a%d + b) * (a%d - b) / 4 lah\n}\n", i, i
+    }
+}' > "$SOURCE"
+"$SING" --time-phases "$SOURCE" 2>&1 > /dev/null | awk -v size="$(wc -c < "$SOURCE")" \
+    '/\[time\] parse / { printf "%-16s %-10s %8.2f MB/s (%d KB)\n", "generated", "scan+parse", $5, size / 1024 }'
+SCANBENCH=$(dirname "$SING")/scanbench
+if [ -x "$SCANBENCH" ]; then
+    printf "%-16s %-10s %s\n" "generated" "scan" "$("$SCANBENCH" "$SOURCE")"
+fi
+rm -f "$SOURCE"
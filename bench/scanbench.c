@@ -0,0 +1,48 @@
+// scanner throughput on its own: scans a file over and over for about a
+// second and prints MB/s. usage: scanbench file.sg
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "frontend/scanner.h"
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: scanbench file.sg\n");
+        return 64;
+    }
+    FILE* file = fopen(argv[1], "rb");
+    if (file == NULL) {
+        fprintf(stderr, "scanbench: cannot open %s\n", argv[1]);
+        return 74;
+    }
+    fseek(file, 0L, SEEK_END);
+    size_t size = ftell(file);
+    rewind(file);
+    char* source = malloc(size + 1);
+    size = fread(source, 1, size, file);
+    source[size] = '\0';
+    fclose(file);
+
+    long tokens = 0;
+    int rounds = 0;
+    clock_t start = clock();
+    double seconds = 0;
+    do {
+        Scanner scanner;
+        initScanner(&scanner, source);
+        for (;;) {
+            Token token = scanToken(&scanner);
+            freeToken(token);
+            tokens++;
+            if (token.type == TOKEN_EOF) break;
+        }
+        rounds++;
+        seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    } while (seconds < 1.0);
+
+    printf("%.2f MB/s, %.1f M tokens/s (%s)\n", size * (double)rounds / seconds / 1e6, tokens / seconds / 1e6, scannerFastPath());
+    free(source);
+    return 0;
+}
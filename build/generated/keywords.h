@@ -0,0 +1,28 @@
+// generated by tools/genkeywords.c from src/frontend/keywords.def, do not edit
+
+#define KEYWORD_TABLE_SIZE 32
+
+// start and length of the identifier just scanned, length > 0
+#define KEYWORD_HASH(start, length) \
+    ((((unsigned char)(start)[0]) * 1u + ((unsigned char)(start)[(length) - 1]) * 11u + (unsigned)(length) * 4u) & 31u)
+
+static const Keyword keywords[KEYWORD_TABLE_SIZE] = {
+    [25] = { "and", 3, 3, TOKEN_AND },
+    [19] = { "cabut", 5, 5, TOKEN_CABUT },
+    [9] = { "can", 3, 3, TOKEN_CAN },
+    [23] = { "cannot", 6, 6, TOKEN_CANNOT },
+    [10] = { "carry on", 5, 8, TOKEN_CARRY_ON },
+    [14] = { "chope", 5, 5, TOKEN_CHOPE },
+    [27] = { "correct", 7, 7, TOKEN_CORRECT },
+    [17] = { "do again from", 2, 13, TOKEN_DO_AGAIN_FROM },
+    [1] = { "howdo", 5, 5, TOKEN_HOWDO },
+    [11] = { "keep doing", 4, 10, TOKEN_KEEP_DOING },
+    [16] = { "lah", 3, 3, TOKEN_LAH },
+    [30] = { "nil", 3, 3, TOKEN_NIL },
+    [29] = { "or", 2, 2, TOKEN_OR },
+    [0] = { "print", 5, 5, TOKEN_PRINT },
+    [4] = { "return", 6, 6, TOKEN_RETURN },
+    [13] = { "super", 5, 5, TOKEN_SUPER },
+    [21] = { "this", 4, 4, TOKEN_THIS },
+    [24] = { "wrong", 5, 5, TOKEN_WRONG },
+};
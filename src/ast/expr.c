@@ -1,49 +1,68 @@
 #include "expr.h"
 #include "../runtime/memory.h"
+#include "pool.h"
 #include <stdarg.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+const char* staticTypeName(StaticType type) {
+    switch (type) {
+        case STATIC_NUMBER:
+            return "number";
+        case STATIC_STRING:
+            return "string";
+        case STATIC_BOOL:
+            return "bool";
+        case STATIC_NIL:
+            return "nil";
+        default:
+            return "something";
+    }
+}
+
 static Expr* allocateExpr(ExprType type) {
-    Expr* expr = ALLOCATE(Expr, 1);
+    Expr* expr = poolAllocate(sizeof(Expr));
     if (expr != NULL) {
         expr->type = type;
+        expr->staticType = STATIC_UNKNOWN;
     }
     return expr;
 }
 
-Expr* newAssignExpr(Token name, Expr* value) {
+Expr* newAssignExpr(TokenIndex name, Expr* value) {
     Expr* expr = allocateExpr(EXPR_ASSIGN);
     if (expr == NULL) return NULL;
     expr->as.assign.name = name;
-    expr->as.assign.value = value;
+    expr->as.assign.value = nodeIndex(value);
+    expr->as.assign.upvalue = -1;
     return expr;
 }
 
-Expr* newLogicalExpr(Expr* left, Token oper, Expr* right) {
+Expr* newLogicalExpr(Expr* left, TokenIndex oper, Expr* right) {
     Expr* expr = allocateExpr(EXPR_LOGICAL);
     if (expr == NULL) return NULL;
-    expr->as.logical.left = left;
+    expr->as.logical.left = nodeIndex(left);
     expr->as.logical.oper = oper;
-    expr->as.logical.right = right;
+    expr->as.logical.right = nodeIndex(right);
     return expr;
 }
 
-Expr* newBinaryExpr(Expr* left, Token oper, Expr* right) {
+Expr* newBinaryExpr(Expr* left, TokenIndex oper, Expr* right) {
     Expr* expr = allocateExpr(EXPR_BINARY);
     if (expr == NULL) return NULL;
-    expr->as.binary.left = left;
+    expr->as.binary.left = nodeIndex(left);
     expr->as.binary.oper = oper;
-    expr->as.binary.right = right;
+    expr->as.binary.right = nodeIndex(right);
+    expr->as.binary.generic = false;
     return expr;
 }
 
 Expr* newGroupingExpr(Expr* expression) {
     Expr* expr = allocateExpr(EXPR_GROUPING);
     if (expr == NULL) return NULL;
-    expr->as.grouping.expression = expression;
+    expr->as.grouping.expression = nodeIndex(expression);
     return expr;
 }
 
@@ -70,7 +89,6 @@ Expr* newLiteralStringExpr(char* value) {
     // copy for now, can look into immutability and stuff later but not impt now
     char* valueCopy = ALLOCATE(char, strlen(value) + 1);
     if (valueCopy == NULL) {
-        FREE(Expr, expr);
         return NULL;
     }
     strcpy(valueCopy, value);
@@ -85,28 +103,35 @@ Expr* newLiteralNilExpr() {
     return expr;
 }
 
-Expr* newUnaryExpr(Token oper, Expr* right) {
+Expr* newUnaryExpr(TokenIndex oper, Expr* right) {
     Expr* expr = allocateExpr(EXPR_UNARY);
     if (expr == NULL) return NULL;
     expr->as.unary.oper = oper;
-    expr->as.unary.right = right;
+    expr->as.unary.right = nodeIndex(right);
     return expr;
 }
 
-Expr* newVariableExpr(Token name) {
+Expr* newVariableExpr(TokenIndex name) {
     Expr* expr = allocateExpr(EXPR_VARIABLE);
     if (expr == NULL) return NULL;
     expr->as.variable.name = name;
+    expr->as.variable.global = false;
+    expr->as.variable.slot = -1;
+    expr->as.variable.upvalue = -1;
     return expr;
 }
 
-Expr* newCallExpr(Expr* callee, Token paren, int arg_count, Expr** arguments) {
+Expr* newCallExpr(Expr* callee, TokenIndex paren, int arg_count, Expr** arguments) {
     Expr* expr = allocateExpr(EXPR_CALL);
     if (expr == NULL) return NULL;
-    expr->as.call.callee = callee;
+    expr->as.call.callee = nodeIndex(callee);
     expr->as.call.paren = paren;
     expr->as.call.arg_count = arg_count;
-    expr->as.call.arguments = arguments;
+    NodeIndex* indices = arg_count > 0 ? poolAllocate(sizeof(NodeIndex) * arg_count) : NULL;
+    for (int i = 0; i < arg_count; i++) {
+        indices[i] = nodeIndex(arguments[i]);
+    }
+    expr->as.call.arguments = nodeIndex(indices);
     return expr;
 }
 
@@ -117,16 +142,24 @@ void freeExpr(Expr* expr) {
         case EXPR_ASSIGN: {
             // free the RHS expression,
             // IMPORTANT: but not the name token (owned by scanner/parser)
-            freeExpr(expr->as.assign.value);
+            freeExpr(AS_EXPR(expr->as.assign.value));
             break;
         }
-        case EXPR_BINARY: {
-            freeExpr(expr->as.binary.left);
-            freeExpr(expr->as.binary.right);
+        case EXPR_BINARY:
+        case EXPR_BINARY_VAR_CONST:
+        case EXPR_BINARY_CONST_VAR:
+        case EXPR_BINARY_VAR_VAR: {
+            freeExpr(AS_EXPR(expr->as.binary.left));
+            freeExpr(AS_EXPR(expr->as.binary.right));
+            break;
+        }
+        case EXPR_LOGICAL: {
+            freeExpr(AS_EXPR(expr->as.logical.left));
+            freeExpr(AS_EXPR(expr->as.logical.right));
             break;
         }
         case EXPR_GROUPING: {
-            freeExpr(expr->as.grouping.expression);
+            freeExpr(AS_EXPR(expr->as.grouping.expression));
             break;
         }
         case EXPR_LITERAL: {
@@ -138,7 +171,7 @@ void freeExpr(Expr* expr) {
             break;
         }
         case EXPR_UNARY: {
-            freeExpr(expr->as.unary.right);
+            freeExpr(AS_EXPR(expr->as.unary.right));
             break;
         }
         case EXPR_VARIABLE: {
@@ -146,11 +179,10 @@ void freeExpr(Expr* expr) {
             break;
         }
         case EXPR_CALL:
-            freeExpr(expr->as.call.callee);
+            freeExpr(AS_EXPR(expr->as.call.callee));
             for (int i = 0; i < expr->as.call.arg_count; i++) {
-                freeExpr(expr->as.call.arguments[i]);
+                freeExpr(CALL_ARGUMENT(&expr->as.call, i));
             }
-            free(expr->as.call.arguments);
             break;
 
         // Add default case to handle potential future types or errors
@@ -160,8 +192,7 @@ void freeExpr(Expr* expr) {
             break;
     }
 
-    // Finally, free the expression node itself
-    FREE(Expr, expr);
+    // the node itself lives in the AST pool, see pool.h
 }
 
 typedef struct {
@@ -224,14 +255,17 @@ void parenthesize(StringBuilder* sb, const char* name, int count, ...) {
 
 void printExprInternal(StringBuilder* sb, Expr* expr) {
     switch (expr->type) {
-        case EXPR_BINARY: {
+        case EXPR_BINARY:
+        case EXPR_BINARY_VAR_CONST:
+        case EXPR_BINARY_CONST_VAR:
+        case EXPR_BINARY_VAR_VAR: {
             char op[2] = { 0 };
-            op[0] = *expr->as.binary.oper.start;
-            parenthesize(sb, op, 2, expr->as.binary.left, expr->as.binary.right);
+            op[0] = *TOKEN_AT(expr->as.binary.oper)->start;
+            parenthesize(sb, op, 2, AS_EXPR(expr->as.binary.left), AS_EXPR(expr->as.binary.right));
             break;
         }
         case EXPR_GROUPING: {
-            parenthesize(sb, "group", 1, expr->as.grouping.expression);
+            parenthesize(sb, "group", 1, AS_EXPR(expr->as.grouping.expression));
             break;
         }
         case EXPR_LITERAL: {
@@ -260,8 +294,8 @@ void printExprInternal(StringBuilder* sb, Expr* expr) {
         }
         case EXPR_UNARY: {
             char op[2] = { 0 };
-            op[0] = *expr->as.unary.oper.start;
-            parenthesize(sb, op, 1, expr->as.unary.right);
+            op[0] = *TOKEN_AT(expr->as.unary.oper)->start;
+            parenthesize(sb, op, 1, AS_EXPR(expr->as.unary.right));
             break;
         }
         default: {
@@ -280,21 +314,24 @@ static void printExprRecursive(Expr* expr, char* buffer, size_t* pos, size_t cap
     int written = 0;
     switch (expr->type) {
         case EXPR_ASSIGN: {
-            Token name = expr->as.assign.name;
+            Token name = *TOKEN_AT(expr->as.assign.name);
             // Use snprintf safely
             written = snprintf(buffer + *pos, capacity - *pos, "(= %.*s ", name.length, name.start);
             if (written < 0 || (size_t)written >= capacity - *pos) return; // Check for error/truncation
             *pos += written;
-            printExprRecursive(expr->as.assign.value, buffer, pos, capacity);
+            printExprRecursive(AS_EXPR(expr->as.assign.value), buffer, pos, capacity);
             if (*pos < capacity - 1)
                 buffer[(*pos)++] = ')';
             else
                 return;
             break;
         }
-        case EXPR_BINARY: {
+        case EXPR_BINARY:
+        case EXPR_BINARY_VAR_CONST:
+        case EXPR_BINARY_CONST_VAR:
+        case EXPR_BINARY_VAR_VAR: {
             // Determine operator string
-            switch (expr->as.binary.oper.type) {
+            switch (TOKEN_AT(expr->as.binary.oper)->type) {
                 case TOKEN_PLUS:
                     opStr = "+";
                     break;
@@ -332,12 +369,29 @@ static void printExprRecursive(Expr* expr, char* buffer, size_t* pos, size_t cap
             written = snprintf(buffer + *pos, capacity - *pos, "(%s ", opStr);
             if (written < 0 || (size_t)written >= capacity - *pos) return;
             *pos += written;
-            printExprRecursive(expr->as.binary.left, buffer, pos, capacity);
+            printExprRecursive(AS_EXPR(expr->as.binary.left), buffer, pos, capacity);
+            if (*pos < capacity - 1)
+                buffer[(*pos)++] = ' ';
+            else
+                return;
+            printExprRecursive(AS_EXPR(expr->as.binary.right), buffer, pos, capacity);
+            if (*pos < capacity - 1)
+                buffer[(*pos)++] = ')';
+            else
+                return;
+            break;
+        }
+        case EXPR_LOGICAL: {
+            opStr = (TOKEN_AT(expr->as.logical.oper)->type == TOKEN_AND) ? "and" : "or";
+            written = snprintf(buffer + *pos, capacity - *pos, "(%s ", opStr);
+            if (written < 0 || (size_t)written >= capacity - *pos) return;
+            *pos += written;
+            printExprRecursive(AS_EXPR(expr->as.logical.left), buffer, pos, capacity);
             if (*pos < capacity - 1)
                 buffer[(*pos)++] = ' ';
             else
                 return;
-            printExprRecursive(expr->as.binary.right, buffer, pos, capacity);
+            printExprRecursive(AS_EXPR(expr->as.logical.right), buffer, pos, capacity);
             if (*pos < capacity - 1)
                 buffer[(*pos)++] = ')';
             else
@@ -348,7 +402,7 @@ static void printExprRecursive(Expr* expr, char* buffer, size_t* pos, size_t cap
             written = snprintf(buffer + *pos, capacity - *pos, "(group ");
             if (written < 0 || (size_t)written >= capacity - *pos) return;
             *pos += written;
-            printExprRecursive(expr->as.grouping.expression, buffer, pos, capacity);
+            printExprRecursive(AS_EXPR(expr->as.grouping.expression), buffer, pos, capacity);
             if (*pos < capacity - 1)
                 buffer[(*pos)++] = ')';
             else
@@ -381,11 +435,11 @@ static void printExprRecursive(Expr* expr, char* buffer, size_t* pos, size_t cap
             break;
         }
         case EXPR_UNARY: {
-            opStr = (expr->as.unary.oper.type == TOKEN_MINUS) ? "-" : "!";
+            opStr = (TOKEN_AT(expr->as.unary.oper)->type == TOKEN_MINUS) ? "-" : "!";
             written = snprintf(buffer + *pos, capacity - *pos, "(%s ", opStr);
             if (written < 0 || (size_t)written >= capacity - *pos) return;
             *pos += written;
-            printExprRecursive(expr->as.unary.right, buffer, pos, capacity);
+            printExprRecursive(AS_EXPR(expr->as.unary.right), buffer, pos, capacity);
             if (*pos < capacity - 1)
                 buffer[(*pos)++] = ')';
             else
@@ -393,7 +447,7 @@ static void printExprRecursive(Expr* expr, char* buffer, size_t* pos, size_t cap
             break;
         }
         case EXPR_VARIABLE: {
-            Token name = expr->as.variable.name;
+            Token name = *TOKEN_AT(expr->as.variable.name);
             written = snprintf(buffer + *pos, capacity - *pos, "%.*s", name.length, name.start);
             if (written < 0 || (size_t)written >= capacity - *pos) return;
             *pos += written;
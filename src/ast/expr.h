@@ -2,6 +2,7 @@
 #define expr_h
 
 #include "../frontend/scanner.h"
+#include "pool.h"
 #include <stdbool.h> // Include for bool type used in LiteralExpr
 
 typedef enum {
@@ -12,45 +13,65 @@ typedef enum {
     EXPR_LITERAL,
     EXPR_UNARY,
     EXPR_VARIABLE, // New: Variable access like x
-    EXPR_CALL // New: Function call expression
+    EXPR_CALL, // New: Function call expression
+    // binary nodes the tree-walker rewrote itself into after their first run,
+    // reading number operands straight out of the node. payload is still as.binary.
+    EXPR_BINARY_VAR_CONST, // x < 10
+    EXPR_BINARY_CONST_VAR, // 1 - x
+    EXPR_BINARY_VAR_VAR // a + b
 } ExprType;
 
 // Forward declaration needed for nested expressions
 typedef struct Expr Expr;
 
+// Type of an expression's value as proven by the type inference pass.
+// STATIC_UNKNOWN means the interpreter has to check at runtime.
+typedef enum {
+    STATIC_UNKNOWN,
+    STATIC_NUMBER,
+    STATIC_BOOL,
+    STATIC_STRING,
+    STATIC_NIL
+} StaticType;
+
+// "number", "string", ... for messages
+const char* staticTypeName(StaticType type);
+
 // --- Expression Struct Definitions ---
 
 // Assignment: identifier = value
 typedef struct {
-    Token name; // The variable token (identifier)
-    Expr* value; // The expression being assigned
+    TokenIndex name; // The variable token (identifier)
+    NodeIndex value; // The expression being assigned
+    int upvalue; // see VariableExpr
 } AssignExpr;
 
 // Binary: left op right
 typedef struct {
-    Expr* left;
-    Token oper;
-    Expr* right;
+    NodeIndex left;
+    TokenIndex oper;
+    NodeIndex right;
 } LogicalExpr;
 
 // Binary: left op right
 typedef struct {
-    Expr* left;
-    Token oper;
-    Expr* right;
+    NodeIndex left;
+    TokenIndex oper;
+    NodeIndex right;
+    bool generic; // never specialize again, shape did not fit or a guard failed
 } BinaryExpr;
 
 // Call:
 typedef struct {
-    Expr* callee;
-    Token paren; // closing parenthesis for error reporting
+    NodeIndex callee;
+    TokenIndex paren; // closing parenthesis for error reporting
     int arg_count;
-    Expr** arguments;
+    NodeIndex arguments; // arg_count indices of Exprs, one after another, see CALL_ARGUMENT
 } CallExpr;
 
 // Grouping: ( expression )
 typedef struct {
-    Expr* expression;
+    NodeIndex expression;
 } GroupingExpr;
 
 // Literal: number, string, true, false, nil
@@ -67,18 +88,22 @@ typedef struct {
 
 // Unary: op right
 typedef struct {
-    Token oper;
-    Expr* right;
+    TokenIndex oper;
+    NodeIndex right;
 } UnaryExpr;
 
 // Variable: identifier
 typedef struct {
-    Token name; // The variable token (identifier)
+    TokenIndex name; // The variable token (identifier)
+    bool global; // the resolver found no local it could mean
+    int slot; // global only: where the interpreter found it, -1 until then
+    int upvalue; // a local of an enclosing function: which of the running function's upvalues, else -1
 } VariableExpr;
 
 // --- Main Expression Struct (using a tagged union) ---
 struct Expr {
     ExprType type;
+    StaticType staticType;
     union {
         AssignExpr assign; // New
         LogicalExpr logical;
@@ -91,18 +116,24 @@ struct Expr {
     } as;
 };
 
+// the Expr at index, NULL for 0. children are stored as indices, see pool.h
+#define AS_EXPR(index) ((Expr*)NODE_AT(index))
+
+// the i'th argument of a CallExpr*
+#define CALL_ARGUMENT(call, i) AS_EXPR(((NodeIndex*)NODE_AT((call)->arguments))[i])
+
 // --- Constructor Functions ---
-Expr* newAssignExpr(Token name, Expr* value);
-Expr* newLogicalExpr(Expr* left, Token oper, Expr* right);
-Expr* newBinaryExpr(Expr* left, Token oper, Expr* right);
-Expr* newCallExpr(Expr* callee, Token paren, int arg_count, Expr** arguments);
+Expr* newAssignExpr(TokenIndex name, Expr* value);
+Expr* newLogicalExpr(Expr* left, TokenIndex oper, Expr* right);
+Expr* newBinaryExpr(Expr* left, TokenIndex oper, Expr* right);
+Expr* newCallExpr(Expr* callee, TokenIndex paren, int arg_count, Expr** arguments); // copies arguments
 Expr* newGroupingExpr(Expr* expression);
 Expr* newLiteralNumberExpr(double value);
 Expr* newLiteralBooleanExpr(bool value);
 Expr* newLiteralStringExpr(char* value); // Assumes value is already managed/copied if needed
 Expr* newLiteralNilExpr();
-Expr* newUnaryExpr(Token oper, Expr* right);
-Expr* newVariableExpr(Token name);
+Expr* newUnaryExpr(TokenIndex oper, Expr* right);
+Expr* newVariableExpr(TokenIndex name);
 
 // --- Memory Management ---
 void freeExpr(Expr* expr);
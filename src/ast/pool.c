@@ -0,0 +1,153 @@
+// mmap and MAP_ANONYMOUS are not C99
+#define _DEFAULT_SOURCE
+
+#include "pool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../runtime/memory.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define POOL_MMAP
+#include <sys/mman.h>
+#endif
+
+#define ALIGNMENT 8 // nodes hold nothing wider than doubles and pointers
+#define COMMIT_STEP (1024 * 1024)
+#define SMALLEST_REGION ((size_t)64 * 1024 * 1024)
+
+// address space for a whole region is taken at once so what is in it never
+// moves. with mmap only the part in use costs memory
+typedef struct {
+    char* base;
+    size_t reserved; // bytes of address space the region may grow into
+    size_t committed; // bytes of it usable so far
+} Region;
+
+static Region nodes = { NULL, 0, 0 };
+static Region tokens = { NULL, 0, 0 };
+
+char* astNodes = NULL;
+Token* astTokens = NULL;
+static size_t used = ALIGNMENT; // the first slot is index 0, no node
+static TokenIndex tokenCount = 1; // the same for tokens
+
+static size_t alignUp(size_t size) {
+    return (size + ALIGNMENT - 1) & ~(size_t)(ALIGNMENT - 1);
+}
+
+// the largest that can be had, up to largest bytes. without mmap, as much as
+// malloc will give.
+static void reserveRegion(Region* region, size_t largest) {
+    for (size_t size = largest; size >= SMALLEST_REGION; size /= 2) {
+#ifdef POOL_MMAP
+        void* base = mmap(NULL, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (base == MAP_FAILED) continue;
+        region->committed = 0;
+#else
+        void* base = malloc(size);
+        if (base == NULL) continue;
+        region->committed = size;
+#endif
+        region->base = base;
+        region->reserved = size;
+        return;
+    }
+    fprintf(stderr, "Aiyo die already lah: Cannot reserve memory for the AST leh!\n");
+    exit(1);
+}
+
+static void commitUpTo(Region* region, size_t size) {
+    if (size > region->reserved) {
+        fprintf(stderr, "Aiyo die already lah: AST too big, no more space for nodes sia...\n");
+        exit(1);
+    }
+#ifdef POOL_MMAP
+    size_t target = (size + COMMIT_STEP - 1) / COMMIT_STEP * COMMIT_STEP;
+    if (target > region->reserved) target = region->reserved;
+    if (mprotect(region->base + region->committed, target - region->committed, PROT_READ | PROT_WRITE) != 0) {
+        fprintf(stderr, "Aiyo die already lah: Memory allocation fail leh! No more space for nodes sia...\n");
+        exit(1);
+    }
+    region->committed = target;
+#endif
+}
+
+static void releaseRegion(Region* region) {
+    if (region->base == NULL) return;
+#ifdef POOL_MMAP
+    munmap(region->base, region->reserved);
+#else
+    free(region->base);
+#endif
+    region->base = NULL;
+    region->reserved = region->committed = 0;
+}
+
+void* poolAllocate(size_t size) {
+    if (nodes.base == NULL) {
+        reserveRegion(&nodes, (size_t)UINT32_MAX * ALIGNMENT); // all a NodeIndex can reach
+        astNodes = nodes.base;
+    }
+    size = alignUp(size);
+    if (used + size > nodes.committed) commitUpTo(&nodes, used + size);
+    void* pointer = astNodes + used;
+    used += size;
+    memset(pointer, 0, size);
+    return pointer;
+}
+
+TokenIndex poolTokens(int count) {
+    if (count == 0) return 0;
+    if (tokens.base == NULL) {
+        reserveRegion(&tokens, (size_t)UINT32_MAX * sizeof(Token));
+        astTokens = (Token*)tokens.base;
+    }
+    size_t size = ((size_t)tokenCount + count) * sizeof(Token);
+    if (size > tokens.committed) commitUpTo(&tokens, size);
+    TokenIndex first = tokenCount;
+    tokenCount += count;
+    memset(&astTokens[first], 0, sizeof(Token) * count);
+    return first;
+}
+
+TokenIndex poolToken(Token token) {
+    TokenIndex index = poolTokens(1);
+    astTokens[index] = token;
+    return index;
+}
+
+PoolMark poolMark() {
+    PoolMark mark;
+    mark.used = used;
+    mark.tokens = tokenCount;
+    return mark;
+}
+
+void poolRelease(PoolMark mark) {
+    used = mark.used;
+    tokenCount = mark.tokens;
+}
+
+// freeAstPool stops here, see keepAstPool
+static PoolMark kept = { ALIGNMENT, 1 };
+
+void freeAstPool() {
+    poolRelease(kept);
+}
+
+void keepAstPool() {
+    kept = poolMark();
+}
+
+void freeKeptAstPool() {
+    kept.used = ALIGNMENT;
+    kept.tokens = 1;
+    freeAstPool();
+    releaseRegion(&nodes);
+    releaseRegion(&tokens);
+    astNodes = NULL;
+    astTokens = NULL;
+}
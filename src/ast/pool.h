@@ -0,0 +1,75 @@
+#ifndef sg_pool_h
+#define sg_pool_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../frontend/scanner.h"
+
+// every Expr, Stmt and StmtList node lives in one array, the node region,
+// and nodes refer to each other by their 32-bit index into it instead of by
+// pointer. nodes parsed one after another sit next to each other and a
+// reference costs half a pointer. the region is reserved up front and never
+// moves, so an Expr* or Stmt* stays valid for as long as its node does.
+// nodes are never freed one by one (freeExpr and freeStmt only free what the
+// nodes own), the whole region goes at once.
+//
+// the tokens nodes keep (names, operators, keywords for error lines) live
+// the same way in a second array, the token region, and a node holds a
+// TokenIndex instead of the 32 byte Token. the scanner hands the parser one
+// token at a time, so only the tokens some node keeps end up in it.
+
+// where a node starts, in 8 byte units from the start of the region. 0 is
+// no node, like NULL.
+typedef uint32_t NodeIndex;
+
+// which token in the token region. 0 is no token.
+typedef uint32_t TokenIndex;
+
+extern char* astNodes; // start of the node region
+extern Token* astTokens; // start of the token region
+
+// the node at index, NULL for 0. a macro like the AS_ ones in object.h, the
+// interpreter goes through one for every child it visits
+#define NODE_AT(index) ((index) == 0 ? NULL : (void*)(astNodes + (size_t)(index) * 8))
+
+// the Token* at index
+#define TOKEN_AT(index) (&astTokens[index])
+
+static inline NodeIndex nodeIndex(const void* node) {
+    return node == NULL ? 0 : (NodeIndex)(((const char*)node - astNodes) / 8);
+}
+
+void* poolAllocate(size_t size);
+
+// count zeroed tokens one after another in the token region, the index of the
+// first. 0 if count is 0.
+TokenIndex poolTokens(int count);
+
+// a copy of token in the token region
+TokenIndex poolToken(Token token);
+
+// free every node and token allocated so far, except kept ones. call after
+// the AST is done with.
+void freeAstPool();
+
+// keep every node allocated so far when freeAstPool runs, e.g. the functions
+// restored from a heap image, which every program after them may call
+void keepAstPool();
+
+// free everything, kept nodes too
+void freeKeptAstPool();
+
+// a point in the pool to free back to, for dropping the nodes of one
+// statement while keeping everything allocated before it
+typedef struct {
+    size_t used;
+    TokenIndex tokens;
+} PoolMark;
+
+PoolMark poolMark();
+
+// free every node and token allocated since mark
+void poolRelease(PoolMark mark);
+
+#endif
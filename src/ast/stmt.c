@@ -1,132 +1,206 @@
 #include "stmt.h"
 #include "expr.h"
+#include "pool.h"
+#include "../runtime/memory.h"
 #include <stdlib.h>
+#include <string.h>
 
 // creation of statements. i think we can probably refactor this but idk if keeping it separate for now is better in case
 // we gta do more specific stuff
 Stmt* newExpressionStmt(Expr* expression) {
-    Stmt* stmt = (Stmt*)malloc(sizeof(Stmt));
+    Stmt* stmt = poolAllocate(sizeof(Stmt));
     stmt->type = STMT_EXPRESSION;
-    stmt->as.expression.expression = expression;
+    stmt->as.expression.expression = nodeIndex(expression);
     return stmt;
 }
 
 Stmt* newIfStmt(Expr* condition, Stmt* thenBranch, Stmt* elseBranch) {
-    Stmt* stmt = (Stmt*)malloc(sizeof(Stmt));
+    Stmt* stmt = poolAllocate(sizeof(Stmt));
     stmt->type = STMT_IF;
-    stmt->as.ifStmt.condition = condition;
-    stmt->as.ifStmt.thenBranch = thenBranch;
-    stmt->as.ifStmt.elseBranch = elseBranch;
+    stmt->as.ifStmt.condition = nodeIndex(condition);
+    stmt->as.ifStmt.thenBranch = nodeIndex(thenBranch);
+    stmt->as.ifStmt.elseBranch = nodeIndex(elseBranch);
     return stmt;
 }
 
 Stmt* newPrintStmt(Expr* expression) {
-    Stmt* stmt = (Stmt*)malloc(sizeof(Stmt));
+    Stmt* stmt = poolAllocate(sizeof(Stmt));
     stmt->type = STMT_PRINT;
-    stmt->as.print.expression = expression;
+    stmt->as.print.expression = nodeIndex(expression);
     return stmt;
 }
 
 Stmt* newWhileStmt(Expr* condition, Stmt* body) {
-    Stmt* stmt = (Stmt*)malloc(sizeof(Stmt));
+    Stmt* stmt = poolAllocate(sizeof(Stmt));
     stmt->type = STMT_WHILE;
-    stmt->as.whileStmt.condition = condition;
-    stmt->as.whileStmt.body = body;
+    stmt->as.whileStmt.condition = nodeIndex(condition);
+    stmt->as.whileStmt.body = nodeIndex(body);
+    stmt->as.whileStmt.increment = 0;
     return stmt;
 }
 
-Stmt* newVarStmt(Token name, Expr* initializer) {
-    Stmt* stmt = (Stmt*)malloc(sizeof(Stmt));
+Stmt* newVarStmt(TokenIndex name, Expr* initializer) {
+    Stmt* stmt = poolAllocate(sizeof(Stmt));
     stmt->type = STMT_VAR;
     stmt->as.var.name = name;
-    stmt->as.var.initializer = initializer;
+    stmt->as.var.initializer = nodeIndex(initializer);
+    stmt->as.var.declaredType = STATIC_UNKNOWN;
     return stmt;
 }
 
 Stmt* newBlockStmt(StmtList* statements) {
-    Stmt* stmt = (Stmt*)malloc(sizeof(Stmt));
+    Stmt* stmt = poolAllocate(sizeof(Stmt));
     stmt->type = STMT_BLOCK;
-    stmt->as.block.statements = statements;
+    stmt->as.block.statements = nodeIndex(statements);
+    stmt->as.block.localCount = 0;
+    stmt->as.block.captured = false;
     return stmt;
 }
 
-StmtList* newStmtList(Stmt* stmt, StmtList* next) {
-    StmtList* list = (StmtList*)malloc(sizeof(StmtList));
-    list->stmt = stmt;
-    list->next = next;
+StmtList* newStmtList(NodeIndex* stmts, int count) {
+    if (count == 0) return NULL;
+    StmtList* list = poolAllocate(sizeof(StmtList) + sizeof(NodeIndex) * count);
+    list->count = count;
+    memcpy(list->stmts, stmts, sizeof(NodeIndex) * count);
     return list;
 }
 
-Stmt* newFunctionStmt(Token name, int param_count, Token* params, StmtList* body) {
-    Stmt* stmt = (Stmt*)malloc(sizeof(Stmt));
+void initStmtListBuilder(StmtListBuilder* builder) {
+    builder->stmts = NULL;
+    builder->count = 0;
+    builder->capacity = 0;
+}
+
+void addStmt(StmtListBuilder* builder, Stmt* stmt) {
+    if (builder->count >= builder->capacity) {
+        int oldCapacity = builder->capacity;
+        builder->capacity = GROW_CAPACITY(oldCapacity);
+        builder->stmts = GROW_ARRAY(NodeIndex, builder->stmts, oldCapacity, builder->capacity);
+    }
+    builder->stmts[builder->count++] = nodeIndex(stmt);
+}
+
+StmtList* buildStmtList(StmtListBuilder* builder) {
+    StmtList* list = newStmtList(builder->stmts, builder->count);
+    freeStmtListBuilder(builder);
+    return list;
+}
+
+void freeStmtListBuilder(StmtListBuilder* builder) {
+    FREE_ARRAY(NodeIndex, builder->stmts, builder->capacity);
+    initStmtListBuilder(builder);
+}
+
+Stmt* newFunctionStmt(TokenIndex name, int param_count, Token* params, StmtList* body) {
+    Stmt* stmt = poolAllocate(sizeof(Stmt));
     if (stmt == NULL) return NULL;
     stmt->type = STMT_FUNCTION;
-    stmt->as.function.name = name;
-    stmt->as.function.param_count = param_count;
-    stmt->as.function.params = params;
-    stmt->as.function.body = body;
+    FunctionStmt* function = poolAllocate(sizeof(FunctionStmt));
+    stmt->as.function = nodeIndex(function);
+    function->name = name;
+    function->param_count = param_count;
+    function->params = poolTokens(param_count);
+    for (int i = 0; i < param_count; i++) {
+        *TOKEN_AT(function->params + i) = params[i];
+    }
+    function->paramTypes = NULL;
+    function->returnType = STATIC_UNKNOWN;
+    function->compiled = NULL;
+    function->body = nodeIndex(body);
+    function->upvalues = NULL;
+    function->upvalueCount = 0;
+    function->localCount = 0;
+    function->captured = false;
+    function->lazy = (LazyBody) { NULL, 0, NULL, 0 };
+    function->pure = false;
     return stmt;
 }
 
-Stmt* newReturnStmt(Token keyword, Expr* value) {
-    Stmt* stmt = (Stmt*)malloc(sizeof(Stmt));
+Stmt* newReturnStmt(TokenIndex keyword, Expr* value) {
+    Stmt* stmt = poolAllocate(sizeof(Stmt));
     if (stmt == NULL) return NULL;
     stmt->type = STMT_RETURN;
     stmt->as.return_stmt.keyword = keyword;
-    stmt->as.return_stmt.value = value;
+    stmt->as.return_stmt.value = nodeIndex(value);
+    return stmt;
+}
+
+Stmt* newJumpStmt(StmtType type, TokenIndex keyword) {
+    Stmt* stmt = poolAllocate(sizeof(Stmt));
+    if (stmt == NULL) return NULL;
+    stmt->type = type;
+    stmt->as.jump.keyword = keyword;
     return stmt;
 }
 
-// free a statement (and any expressions it contains)
+// free what a statement owns (and any expressions it contains).
+// the node itself lives in the AST pool, see pool.h
 void freeStmt(Stmt* stmt) {
     if (stmt == NULL) return;
 
     switch (stmt->type) {
         case STMT_EXPRESSION:
-            freeExpr(stmt->as.expression.expression);
+            freeExpr(AS_EXPR(stmt->as.expression.expression));
             break;
         case STMT_IF:
-            freeExpr(stmt->as.ifStmt.condition);
-            freeStmt(stmt->as.ifStmt.thenBranch);
-            freeStmt(stmt->as.ifStmt.elseBranch);
+            freeExpr(AS_EXPR(stmt->as.ifStmt.condition));
+            freeStmt(AS_STMT(stmt->as.ifStmt.thenBranch));
+            freeStmt(AS_STMT(stmt->as.ifStmt.elseBranch));
             break;
         case STMT_PRINT:
-            freeExpr(stmt->as.print.expression);
+            freeExpr(AS_EXPR(stmt->as.print.expression));
             break;
         case STMT_VAR:
-            if (stmt->as.var.initializer != NULL) {
-                freeExpr(stmt->as.var.initializer);
-            }
+            freeExpr(AS_EXPR(stmt->as.var.initializer));
             break;
         case STMT_BLOCK:
-            freeStmtList(stmt->as.block.statements);
+            freeStmtList(AS_STMT_LIST(stmt->as.block.statements));
             break;
         case STMT_FUNCTION:
-            free(stmt->as.function.params);
-            freeStmtList(stmt->as.function.body);
+            free(AS_FUNCTION_STMT(stmt)->paramTypes);
+            free(AS_FUNCTION_STMT(stmt)->lazy.assigned);
+            free(AS_FUNCTION_STMT(stmt)->upvalues);
+            freeStmtList(AS_STMT_LIST(AS_FUNCTION_STMT(stmt)->body));
             break;
         case STMT_RETURN:
-            if (stmt->as.return_stmt.value != NULL) {
-                freeExpr(stmt->as.return_stmt.value);
-            }
+            freeExpr(AS_EXPR(stmt->as.return_stmt.value));
             break;
         case STMT_WHILE:
-            freeExpr(stmt->as.whileStmt.condition);
-            freeStmt(stmt->as.whileStmt.body);
+            freeExpr(AS_EXPR(stmt->as.whileStmt.condition));
+            freeStmt(AS_STMT(stmt->as.whileStmt.body));
+            freeExpr(AS_EXPR(stmt->as.whileStmt.increment));
+            break;
+        case STMT_BREAK:
+        case STMT_CONTINUE:
             break;
     }
-
-    free(stmt);
 }
 
 // free a statement list
 void freeStmtList(StmtList* list) {
-    if (list == NULL) return;
-
-    // recursing through and freeing sub-statements first
-    freeStmtList(list->next);
+    // the list itself stays in the pool
+    for (int i = 0; i < STMT_COUNT(list); i++) {
+        freeStmt(LIST_STMT(list, i));
+    }
+}
 
-    // then we free the current and list node
-    freeStmt(list->stmt);
-    free(list);
+bool declaresFunction(Stmt* stmt) {
+    if (stmt == NULL) return false;
+    switch (stmt->type) {
+        case STMT_FUNCTION:
+            return true;
+        case STMT_BLOCK: {
+            StmtList* list = AS_STMT_LIST(stmt->as.block.statements);
+            for (int i = 0; i < STMT_COUNT(list); i++) {
+                if (declaresFunction(LIST_STMT(list, i))) return true;
+            }
+            return false;
+        }
+        case STMT_IF:
+            return declaresFunction(AS_STMT(stmt->as.ifStmt.thenBranch)) || declaresFunction(AS_STMT(stmt->as.ifStmt.elseBranch));
+        case STMT_WHILE:
+            return declaresFunction(AS_STMT(stmt->as.whileStmt.body));
+        default:
+            return false;
+    }
 }
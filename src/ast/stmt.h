@@ -13,57 +13,97 @@ typedef enum {
     STMT_BLOCK,
     STMT_FUNCTION,
     STMT_RETURN,
+    STMT_BREAK,
+    STMT_CONTINUE,
 } StmtType;
 
 typedef struct Stmt Stmt;
 typedef struct StmtList StmtList;
 
-// statement list, this is a linked list of statements
+// statement list, the indices of its statements one after another in the
+// node region. an empty list is NULL (index 0), see STMT_COUNT
 struct StmtList {
-    Stmt* stmt;
-    StmtList* next;
+    int count;
+    NodeIndex stmts[];
 };
 
 typedef struct {
-    Expr* expression;
+    NodeIndex expression;
 } ExpressionStmt;
 
 typedef struct {
-    Expr* condition;
-    Stmt* thenBranch;
-    Stmt* elseBranch;
+    NodeIndex condition;
+    NodeIndex thenBranch;
+    NodeIndex elseBranch;
 } IfStmt;
 
 typedef struct {
-    Expr* expression;
+    NodeIndex expression;
 } PrintStmt;
 
 typedef struct {
-    Expr* condition;
-    Stmt* body;
+    NodeIndex condition;
+    NodeIndex body;
+    NodeIndex increment; // a `do again from` loop's, runs after the body and on `carry on`. 0 if none
 } WhileStmt;
 
 typedef struct {
-    Token name;
-    Expr* initializer;
+    TokenIndex name;
+    NodeIndex initializer;
+    StaticType declaredType; // from a ": type" annotation, STATIC_UNKNOWN if none
 } VarStmt;
 
+// localCount and captured come from the resolver, they decide where the
+// scope's environment goes (see pushFrame)
 typedef struct {
-    StmtList* statements;
+    NodeIndex statements; // a StmtList
+    int localCount; // locals declared in it
+    bool captured; // a function declared in it uses one of them
 } BlockStmt;
 
+// a function body the parser skipped over, to be parsed on the first call
+// (see parseFunctionBody)
+typedef struct {
+    const char* start; // its '{', NULL once the body is parsed
+    int line;
+    Token* assigned; // names it assigns to, the analyses need them up front
+    int assignedCount;
+} LazyBody;
+
+// a local of an enclosing function (or of a block outside any function) that
+// a function uses. filled in by the resolver, see ObjUpvalue for the rest.
 typedef struct {
     Token name;
+    bool local; // declared in the scopes right around the function, found by name when it is made
+    int index; // otherwise: which upvalue of the enclosing function it is
+} Upvalue;
+
+typedef struct {
+    TokenIndex name;
     int param_count;
-    Token* params;
-    StmtList* body;
+    TokenIndex params; // param_count tokens one after another
+    StaticType* paramTypes; // NULL when no parameter is annotated
+    StaticType returnType; // STATIC_UNKNOWN when not annotated
+    NodeIndex body; // a StmtList
+    Upvalue* upvalues;
+    int upvalueCount;
+    int localCount; // parameters and locals of the body, like BlockStmt's
+    bool captured;
+    LazyBody lazy; // lazy.start is set while body is still unparsed
+    bool pure; // set by the optimizer: only reads its parameters and calls other pure functions
+    struct CompiledStmt* compiled; // body as built by the closure engine on the first call
 } FunctionStmt;
 
 typedef struct {
-    Token keyword;
-    Expr* value;
+    TokenIndex keyword;
+    NodeIndex value;
 } ReturnStmt;
 
+// `cabut` (break) and `carry on` (continue), for the innermost loop
+typedef struct {
+    TokenIndex keyword;
+} JumpStmt;
+
 struct Stmt {
     StmtType type;
     union {
@@ -73,26 +113,57 @@ struct Stmt {
         WhileStmt whileStmt;
         VarStmt var;
         BlockStmt block;
-        FunctionStmt function;
+        NodeIndex function; // a FunctionStmt, see AS_FUNCTION
         ReturnStmt return_stmt;
+        JumpStmt jump;
     } as;
 };
 
+// the Stmt or StmtList at index, NULL for 0
+#define AS_STMT(index) ((Stmt*)NODE_AT(index))
+#define AS_STMT_LIST(index) ((StmtList*)NODE_AT(index))
+
+// a function declaration's FunctionStmt. it is most of the size of any
+// statement, so it sits in a node of its own
+#define AS_FUNCTION_STMT(stmt) ((FunctionStmt*)NODE_AT((stmt)->as.function))
+
+#define STMT_COUNT(list) ((list) == NULL ? 0 : (list)->count)
+// the i'th statement of list
+#define LIST_STMT(list, i) AS_STMT((list)->stmts[i])
+
 // create new statements
 Stmt* newExpressionStmt(Expr* expression);
 Stmt* newIfStmt(Expr* condition, Stmt* thenBranch, Stmt* elseBranch);
 Stmt* newPrintStmt(Expr* expression);
 Stmt* newWhileStmt(Expr* condition, Stmt* body);
-Stmt* newVarStmt(Token name, Expr* initializer);
+Stmt* newVarStmt(TokenIndex name, Expr* initializer);
 Stmt* newBlockStmt(StmtList* statements);
-Stmt* newFunctionStmt(Token name, int param_count, Token* params, StmtList* body);
-Stmt* newReturnStmt(Token keyword, Expr* value);
+Stmt* newFunctionStmt(TokenIndex name, int param_count, Token* params, StmtList* body); // copies params
+Stmt* newReturnStmt(TokenIndex keyword, Expr* value);
+Stmt* newJumpStmt(StmtType type, TokenIndex keyword); // STMT_BREAK or STMT_CONTINUE
+
+// a list of the count statements at stmts, NULL if count is 0
+StmtList* newStmtList(NodeIndex* stmts, int count);
 
-// create a new statement list node
-StmtList* newStmtList(Stmt* stmt, StmtList* next);
+// statements gathered for a list whose length isn't known yet
+typedef struct {
+    NodeIndex* stmts;
+    int count;
+    int capacity;
+} StmtListBuilder;
+
+void initStmtListBuilder(StmtListBuilder* builder);
+void addStmt(StmtListBuilder* builder, Stmt* stmt);
+// the list built so far, and the builder is freed
+StmtList* buildStmtList(StmtListBuilder* builder);
+void freeStmtListBuilder(StmtListBuilder* builder);
 
 // freeing stuff
 void freeStmt(Stmt* stmt);
 void freeStmtList(StmtList* list);
 
+// whether running stmt can create a function object, i.e. it is or holds a
+// function declaration. such statements must outlive their execution.
+bool declaresFunction(Stmt* stmt);
+
 #endif
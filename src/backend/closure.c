@@ -0,0 +1,664 @@
+#include "closure.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../runtime/memory.h"
+#include "../runtime/object.h"
+#include "interpreter.h"
+
+// --- Compiled Nodes ---
+
+typedef struct CompiledExpr CompiledExpr;
+typedef struct CompiledStmt CompiledStmt;
+
+typedef Value (*ExprHandler)(CompiledExpr* node);
+typedef bool (*TestHandler)(CompiledExpr* node); // conditions, see Test Handlers
+typedef Completion (*StmtHandler)(CompiledStmt* node);
+
+struct CompiledExpr {
+    ExprHandler run;
+    TestHandler test;
+    Expr* expr; // source node, for tokens in error messages
+    CompiledExpr* left; // also the unary operand, the callee and the assigned value
+    CompiledExpr* right;
+    CompiledExpr** arguments;
+    Value constant; // literals
+};
+
+struct CompiledStmt {
+    StmtHandler run;
+    Stmt* stmt;
+    CompiledExpr* expr; // expression, condition, initializer or return value
+    CompiledExpr* increment; // loops
+    CompiledStmt* body; // then branch or loop body
+    CompiledStmt* elseBranch;
+    CompiledStmt** statements; // block
+    int count;
+};
+
+// everything compiled is freed in one go
+static void** allocations = NULL;
+static int allocationCount = 0;
+static int allocationCapacity = 0;
+
+// function bodies cached on their declarations, reset when freeing
+static Stmt** compiledFunctions = NULL;
+static int compiledFunctionCount = 0;
+static int compiledFunctionCapacity = 0;
+
+static void* allocateCompiled(size_t size) {
+    if (allocationCount >= allocationCapacity) {
+        int oldCapacity = allocationCapacity;
+        allocationCapacity = GROW_CAPACITY(oldCapacity);
+        allocations = GROW_ARRAY(void*, allocations, oldCapacity, allocationCapacity);
+    }
+    void* pointer = reallocate(NULL, size);
+    memset(pointer, 0, size);
+    allocations[allocationCount++] = pointer;
+    return pointer;
+}
+
+// --- Operands ---
+// binary handlers come in one variant per operand kind on each side, so
+// reading a variable or a number literal needs no call to another handler
+
+typedef enum {
+    OPERAND_ANY,
+    OPERAND_VARIABLE,
+    OPERAND_NUMBER
+} OperandKind;
+
+static OperandKind operandKind(Expr* expr) {
+    while (expr->type == EXPR_GROUPING) {
+        expr = AS_EXPR(expr->as.grouping.expression);
+    }
+    if (expr->type == EXPR_VARIABLE) return OPERAND_VARIABLE;
+    if (expr->type == EXPR_LITERAL && expr->as.literal.type == TOKEN_NUMBER) return OPERAND_NUMBER;
+    return OPERAND_ANY;
+}
+
+static inline bool loadVariable(CompiledExpr* node, Value* out) {
+    Value* value = findVariable(node->expr);
+    if (value == NULL) {
+        readVariable(node->expr); // reports it
+        return false;
+    }
+    *out = *value;
+    return true;
+}
+
+// fail is what the handler returns when loading goes wrong
+#define LOAD_Any(side, out, fail)            \
+    Value out = node->side->run(node->side); \
+    if (runtimeErrorOccurred) return fail;
+
+#define LOAD_Variable(side, out, fail) \
+    Value out;                         \
+    if (!loadVariable(node->side, &out)) return fail;
+
+#define LOAD_Number(side, out, fail) Value out = node->side->constant;
+
+// --- Binary Handlers ---
+
+#define OPERATOR (TOKEN_AT(node->expr->as.binary.oper))
+
+#define NUMBERS_OR_RETURN(fail, a, b)           \
+    if (!IS_NUMBER(a) || !IS_NUMBER(b)) {       \
+        checkNumberOperands(OPERATOR, (a), (b)); \
+        return fail;                            \
+    }
+#define NUMBERS_OR_FAIL(a, b) NUMBERS_OR_RETURN(NIL_VAL, a, b)
+
+#define ADD(a, b)                                                                \
+    if (IS_NUMBER(a) && IS_NUMBER(b)) return NUMBER_VAL(AS_NUMBER(a) + AS_NUMBER(b)); \
+    return addValues(OPERATOR, (a), (b));
+#define SUBTRACT(a, b) \
+    NUMBERS_OR_FAIL(a, b) return NUMBER_VAL(AS_NUMBER(a) - AS_NUMBER(b));
+#define MULTIPLY(a, b) \
+    NUMBERS_OR_FAIL(a, b) return NUMBER_VAL(AS_NUMBER(a) * AS_NUMBER(b));
+#define DIVIDE(a, b)                                     \
+    NUMBERS_OR_FAIL(a, b)                                \
+    if (AS_NUMBER(b) == 0) {                             \
+        runtimeError(OPERATOR, "Division by zero.");     \
+        return NIL_VAL;                                  \
+    }                                                    \
+    return NUMBER_VAL(AS_NUMBER(a) / AS_NUMBER(b));
+#define GREATER(a, b) \
+    NUMBERS_OR_FAIL(a, b) return BOOL_VAL(AS_NUMBER(a) > AS_NUMBER(b));
+#define GREATER_EQUAL(a, b) \
+    NUMBERS_OR_FAIL(a, b) return BOOL_VAL(AS_NUMBER(a) >= AS_NUMBER(b));
+#define LESS(a, b) \
+    NUMBERS_OR_FAIL(a, b) return BOOL_VAL(AS_NUMBER(a) < AS_NUMBER(b));
+#define LESS_EQUAL(a, b) \
+    NUMBERS_OR_FAIL(a, b) return BOOL_VAL(AS_NUMBER(a) <= AS_NUMBER(b));
+#define EQUAL(a, b) return BOOL_VAL(valuesEqual((a), (b)));
+#define NOT_EQUAL(a, b) return BOOL_VAL(!valuesEqual((a), (b)));
+
+#define BINARY_HANDLER(name, leftKind, rightKind, compute)         \
+    static Value name##leftKind##rightKind(CompiledExpr* node) { \
+        LOAD_##leftKind(left, a, NIL_VAL)                        \
+        LOAD_##rightKind(right, b, NIL_VAL)                      \
+        compute(a, b)                                            \
+    }
+
+// all nine variants of a handler, one per operand kind on each side
+#define HANDLER_VARIANTS(handler, name, compute)  \
+    handler(name, Any, Any, compute)              \
+    handler(name, Any, Variable, compute)         \
+    handler(name, Any, Number, compute)           \
+    handler(name, Variable, Any, compute)         \
+    handler(name, Variable, Variable, compute)    \
+    handler(name, Variable, Number, compute)      \
+    handler(name, Number, Any, compute)           \
+    handler(name, Number, Variable, compute)      \
+    handler(name, Number, Number, compute)
+
+// and the table to pick one from, indexed by OperandKind
+#define HANDLER_TABLE(type, name)                                            \
+    static const type name##Handlers[3][3] = {                               \
+        { name##AnyAny, name##AnyVariable, name##AnyNumber },                \
+        { name##VariableAny, name##VariableVariable, name##VariableNumber }, \
+        { name##NumberAny, name##NumberVariable, name##NumberNumber },       \
+    };
+
+#define BINARY_HANDLERS(name, compute)                \
+    HANDLER_VARIANTS(BINARY_HANDLER, name, compute) \
+    HANDLER_TABLE(ExprHandler, name)
+
+BINARY_HANDLERS(add, ADD)
+BINARY_HANDLERS(subtract, SUBTRACT)
+BINARY_HANDLERS(multiply, MULTIPLY)
+BINARY_HANDLERS(divide, DIVIDE)
+BINARY_HANDLERS(greater, GREATER)
+BINARY_HANDLERS(greaterEqual, GREATER_EQUAL)
+BINARY_HANDLERS(less, LESS)
+BINARY_HANDLERS(lessEqual, LESS_EQUAL)
+BINARY_HANDLERS(equal, EQUAL)
+BINARY_HANDLERS(notEqual, NOT_EQUAL)
+
+// --- Other Expression Handlers ---
+
+static Value constantHandler(CompiledExpr* node) {
+    return node->constant;
+}
+
+static Value variableHandler(CompiledExpr* node) {
+    Value value = NIL_VAL;
+    loadVariable(node, &value);
+    return value;
+}
+
+static Value negateHandler(CompiledExpr* node) {
+    LOAD_Any(left, right, NIL_VAL)
+    if (!IS_NUMBER(right)) {
+        checkNumberOperand(TOKEN_AT(node->expr->as.unary.oper), right);
+        return NIL_VAL;
+    }
+    return NUMBER_VAL(-AS_NUMBER(right));
+}
+
+static Value notHandler(CompiledExpr* node) {
+    LOAD_Any(left, right, NIL_VAL)
+    return BOOL_VAL(!isTruthy(right));
+}
+
+static Value andHandler(CompiledExpr* node) {
+    LOAD_Any(left, left, NIL_VAL)
+    if (!isTruthy(left)) return left;
+    return node->right->run(node->right);
+}
+
+static Value orHandler(CompiledExpr* node) {
+    LOAD_Any(left, left, NIL_VAL)
+    if (isTruthy(left)) return left;
+    return node->right->run(node->right);
+}
+
+static Value assignHandler(CompiledExpr* node) {
+    LOAD_Any(left, value, NIL_VAL)
+    return assignVariable(node->expr, value);
+}
+
+// most calls have a handful of arguments, keep those off the heap
+#define STACK_ARGUMENTS 8
+
+static Value callHandler(CompiledExpr* node) {
+    LOAD_Any(left, callee, NIL_VAL)
+
+    int count = node->expr->as.call.arg_count;
+    Value stackArguments[STACK_ARGUMENTS];
+    Value* arguments = count <= STACK_ARGUMENTS ? stackArguments : ALLOCATE(Value, count);
+
+    Value result = NIL_VAL;
+    for (int i = 0; i < count; i++) {
+        arguments[i] = node->arguments[i]->run(node->arguments[i]);
+        if (runtimeErrorOccurred) goto done;
+    }
+    result = callValue(node->expr, callee, arguments);
+
+done:
+    if (arguments != stackArguments) FREE_ARRAY(Value, arguments, count);
+    return result;
+}
+
+static Value unknownExprHandler(CompiledExpr* node) {
+    runtimeError(NULL, "Interpreter error: Unknown expression type %d.", node->expr->type);
+    return NIL_VAL;
+}
+
+// --- Test Handlers ---
+// can and keep doing only need a yes or no. every node also gets a test
+// handler giving that as a C bool: comparisons skip building a BOOL_VAL,
+// and/or/not turn into branches, the rest unwrap their value. after a
+// runtime error the answer means nothing, so branches stop evaluating.
+
+#define TEST_HANDLER(name, leftKind, rightKind, compute)          \
+    static bool name##leftKind##rightKind(CompiledExpr* node) { \
+        LOAD_##leftKind(left, a, false)                         \
+        LOAD_##rightKind(right, b, false)                       \
+        compute(a, b)                                           \
+    }
+
+#define TEST_HANDLERS(name, compute)                \
+    HANDLER_VARIANTS(TEST_HANDLER, name, compute) \
+    HANDLER_TABLE(TestHandler, name)
+
+#define IS_GREATER(a, b) \
+    NUMBERS_OR_RETURN(false, a, b) return AS_NUMBER(a) > AS_NUMBER(b);
+#define IS_GREATER_EQUAL(a, b) \
+    NUMBERS_OR_RETURN(false, a, b) return AS_NUMBER(a) >= AS_NUMBER(b);
+#define IS_LESS(a, b) \
+    NUMBERS_OR_RETURN(false, a, b) return AS_NUMBER(a) < AS_NUMBER(b);
+#define IS_LESS_EQUAL(a, b) \
+    NUMBERS_OR_RETURN(false, a, b) return AS_NUMBER(a) <= AS_NUMBER(b);
+#define IS_EQUAL(a, b) return valuesEqual((a), (b));
+#define IS_NOT_EQUAL(a, b) return !valuesEqual((a), (b));
+
+TEST_HANDLERS(greaterTest, IS_GREATER)
+TEST_HANDLERS(greaterEqualTest, IS_GREATER_EQUAL)
+TEST_HANDLERS(lessTest, IS_LESS)
+TEST_HANDLERS(lessEqualTest, IS_LESS_EQUAL)
+TEST_HANDLERS(equalTest, IS_EQUAL)
+TEST_HANDLERS(notEqualTest, IS_NOT_EQUAL)
+
+static bool truthyTest(CompiledExpr* node) {
+    return isTruthy(node->run(node));
+}
+
+static bool constantTest(CompiledExpr* node) {
+    return isTruthy(node->constant);
+}
+
+static bool notTest(CompiledExpr* node) {
+    return !node->left->test(node->left);
+}
+
+static bool andTest(CompiledExpr* node) {
+    if (!node->left->test(node->left) || runtimeErrorOccurred) return false;
+    return node->right->test(node->right);
+}
+
+static bool orTest(CompiledExpr* node) {
+    if (node->left->test(node->left)) return true;
+    if (runtimeErrorOccurred) return false;
+    return node->right->test(node->right);
+}
+
+// --- Expression Compiler ---
+
+static CompiledExpr* compileExpr(Expr* expr) {
+    // groupings only matter to the parser
+    while (expr->type == EXPR_GROUPING) {
+        expr = AS_EXPR(expr->as.grouping.expression);
+    }
+
+    CompiledExpr* node = allocateCompiled(sizeof(CompiledExpr));
+    node->expr = expr;
+    node->test = truthyTest;
+
+    switch (expr->type) {
+        case EXPR_LITERAL:
+            node->run = constantHandler;
+            node->test = constantTest;
+            switch (expr->as.literal.type) {
+                case TOKEN_NUMBER:
+                    node->constant = NUMBER_VAL(expr->as.literal.value.number);
+                    break;
+                case TOKEN_STRING: {
+                    // strings are immutable, one object per literal is enough
+                    const char* chars = expr->as.literal.value.string;
+                    node->constant = OBJ_VAL(copyString(chars, strlen(chars)));
+                    break;
+                }
+                case TOKEN_CORRECT:
+                    node->constant = BOOL_VAL(true);
+                    break;
+                case TOKEN_WRONG:
+                    node->constant = BOOL_VAL(false);
+                    break;
+                default:
+                    node->constant = NIL_VAL;
+                    break;
+            }
+            break;
+        case EXPR_VARIABLE:
+            node->run = variableHandler;
+            break;
+        case EXPR_UNARY:
+            node->left = compileExpr(AS_EXPR(expr->as.unary.right));
+            if (TOKEN_AT(expr->as.unary.oper)->type == TOKEN_MINUS) {
+                node->run = negateHandler;
+            } else {
+                node->run = notHandler;
+                node->test = notTest;
+            }
+            break;
+        case EXPR_LOGICAL:
+            node->left = compileExpr(AS_EXPR(expr->as.logical.left));
+            node->right = compileExpr(AS_EXPR(expr->as.logical.right));
+            if (TOKEN_AT(expr->as.logical.oper)->type == TOKEN_AND) {
+                node->run = andHandler;
+                node->test = andTest;
+            } else {
+                node->run = orHandler;
+                node->test = orTest;
+            }
+            break;
+        case EXPR_BINARY: {
+            node->left = compileExpr(AS_EXPR(expr->as.binary.left));
+            node->right = compileExpr(AS_EXPR(expr->as.binary.right));
+            OperandKind left = operandKind(AS_EXPR(expr->as.binary.left));
+            OperandKind right = operandKind(AS_EXPR(expr->as.binary.right));
+            switch (TOKEN_AT(expr->as.binary.oper)->type) {
+                case TOKEN_PLUS:
+                    node->run = addHandlers[left][right];
+                    break;
+                case TOKEN_MINUS:
+                    node->run = subtractHandlers[left][right];
+                    break;
+                case TOKEN_STAR:
+                    node->run = multiplyHandlers[left][right];
+                    break;
+                case TOKEN_SLASH:
+                    node->run = divideHandlers[left][right];
+                    break;
+                case TOKEN_GREATER:
+                    node->run = greaterHandlers[left][right];
+                    node->test = greaterTestHandlers[left][right];
+                    break;
+                case TOKEN_GREATER_EQUAL:
+                    node->run = greaterEqualHandlers[left][right];
+                    node->test = greaterEqualTestHandlers[left][right];
+                    break;
+                case TOKEN_LESS:
+                    node->run = lessHandlers[left][right];
+                    node->test = lessTestHandlers[left][right];
+                    break;
+                case TOKEN_LESS_EQUAL:
+                    node->run = lessEqualHandlers[left][right];
+                    node->test = lessEqualTestHandlers[left][right];
+                    break;
+                case TOKEN_EQUAL_EQUAL:
+                    node->run = equalHandlers[left][right];
+                    node->test = equalTestHandlers[left][right];
+                    break;
+                case TOKEN_BANG_EQUAL:
+                    node->run = notEqualHandlers[left][right];
+                    node->test = notEqualTestHandlers[left][right];
+                    break;
+                default:
+                    node->run = unknownExprHandler;
+                    break;
+            }
+            break;
+        }
+        case EXPR_ASSIGN:
+            node->left = compileExpr(AS_EXPR(expr->as.assign.value));
+            node->run = assignHandler;
+            break;
+        case EXPR_CALL: {
+            node->left = compileExpr(AS_EXPR(expr->as.call.callee));
+            int count = expr->as.call.arg_count;
+            if (count > 0) {
+                node->arguments = allocateCompiled(sizeof(CompiledExpr*) * count);
+                for (int i = 0; i < count; i++) {
+                    node->arguments[i] = compileExpr(CALL_ARGUMENT(&expr->as.call, i));
+                }
+            }
+            node->run = callHandler;
+            break;
+        }
+        default:
+            node->run = unknownExprHandler;
+            break;
+    }
+    return node;
+}
+
+// --- Statement Handlers ---
+
+static Completion runStatements(CompiledStmt* block, Environment* environment) {
+    Environment* previous = currentEnvironment;
+    currentEnvironment = environment;
+
+    Completion completion = COMPLETION_NORMAL;
+    for (int i = 0; i < block->count && !runtimeErrorOccurred && completion == COMPLETION_NORMAL; i++) {
+        completion = block->statements[i]->run(block->statements[i]);
+    }
+
+    currentEnvironment = previous;
+    freeEnvironment(environment);
+    return completion;
+}
+
+static Completion expressionHandler(CompiledStmt* node) {
+    node->expr->run(node->expr);
+    return COMPLETION_NORMAL;
+}
+
+static Completion printHandler(CompiledStmt* node) {
+    Value value = node->expr->run(node->expr);
+    if (runtimeErrorOccurred) return COMPLETION_NORMAL;
+    printValue(value);
+    printf("\n");
+    return COMPLETION_NORMAL;
+}
+
+static Completion varHandler(CompiledStmt* node) {
+    Value value = NIL_VAL;
+    if (node->expr != NULL) {
+        value = node->expr->run(node->expr);
+        if (runtimeErrorOccurred) return COMPLETION_NORMAL;
+    }
+    defineVariable(node->stmt, value);
+    return COMPLETION_NORMAL;
+}
+
+static Completion blockHandler(CompiledStmt* node) {
+    Environment frame;
+    Environment* environment = node->stmt->as.block.captured
+        ? newEnclosedEnvironment(currentEnvironment)
+        : pushFrame(&frame, currentEnvironment, node->stmt->as.block.localCount);
+    if (environment == NULL) {
+        runtimeError(NULL, "Memory error creating block environment.");
+        return COMPLETION_NORMAL;
+    }
+    if (node->stmt->as.block.captured) defineAhead(environment, AS_STMT_LIST(node->stmt->as.block.statements));
+    return runStatements(node, environment);
+}
+
+static Completion ifHandler(CompiledStmt* node) {
+    bool condition = node->expr->test(node->expr);
+    if (runtimeErrorOccurred) return COMPLETION_NORMAL;
+    if (condition) {
+        return node->body->run(node->body);
+    } else if (node->elseBranch != NULL) {
+        return node->elseBranch->run(node->elseBranch);
+    }
+    return COMPLETION_NORMAL;
+}
+
+static Completion whileHandler(CompiledStmt* node) {
+    for (;;) {
+        bool condition = node->expr->test(node->expr);
+        if (runtimeErrorOccurred || !condition) return COMPLETION_NORMAL;
+        Completion completion = node->body->run(node->body);
+        if (runtimeErrorOccurred || completion == COMPLETION_BREAK) return COMPLETION_NORMAL;
+        if (completion == COMPLETION_RETURN) return completion;
+        if (node->increment != NULL) node->increment->run(node->increment);
+    }
+}
+
+static Completion functionHandler(CompiledStmt* node) {
+    defineFunction(node->stmt);
+    return COMPLETION_NORMAL;
+}
+
+static Completion returnHandler(CompiledStmt* node) {
+    Value value = NIL_VAL;
+    if (node->expr != NULL) {
+        value = node->expr->run(node->expr);
+        if (runtimeErrorOccurred) return COMPLETION_NORMAL;
+    }
+    return_value = value;
+    return COMPLETION_RETURN;
+}
+
+static Completion breakHandler(CompiledStmt* node) {
+    (void)node;
+    return COMPLETION_BREAK;
+}
+
+static Completion continueHandler(CompiledStmt* node) {
+    (void)node;
+    return COMPLETION_CONTINUE;
+}
+
+static Completion unknownStmtHandler(CompiledStmt* node) {
+    runtimeError(NULL, "Interpreter error: Unknown statement type %d.", node->stmt->type);
+    return COMPLETION_NORMAL;
+}
+
+// --- Statement Compiler ---
+
+static CompiledStmt* compileStmt(Stmt* stmt);
+
+static void compileStatements(CompiledStmt* node, StmtList* list) {
+    node->count = STMT_COUNT(list);
+    if (node->count == 0) return;
+
+    node->statements = allocateCompiled(sizeof(CompiledStmt*) * node->count);
+    for (int i = 0; i < node->count; i++) {
+        node->statements[i] = compileStmt(LIST_STMT(list, i));
+    }
+}
+
+static CompiledStmt* compileStmt(Stmt* stmt) {
+    CompiledStmt* node = allocateCompiled(sizeof(CompiledStmt));
+    node->stmt = stmt;
+
+    switch (stmt->type) {
+        case STMT_EXPRESSION:
+            node->expr = compileExpr(AS_EXPR(stmt->as.expression.expression));
+            node->run = expressionHandler;
+            break;
+        case STMT_PRINT:
+            node->expr = compileExpr(AS_EXPR(stmt->as.print.expression));
+            node->run = printHandler;
+            break;
+        case STMT_VAR:
+            if (stmt->as.var.initializer != 0) {
+                node->expr = compileExpr(AS_EXPR(stmt->as.var.initializer));
+            }
+            node->run = varHandler;
+            break;
+        case STMT_BLOCK:
+            compileStatements(node, AS_STMT_LIST(stmt->as.block.statements));
+            node->run = blockHandler;
+            break;
+        case STMT_IF:
+            node->expr = compileExpr(AS_EXPR(stmt->as.ifStmt.condition));
+            node->body = compileStmt(AS_STMT(stmt->as.ifStmt.thenBranch));
+            if (stmt->as.ifStmt.elseBranch != 0) {
+                node->elseBranch = compileStmt(AS_STMT(stmt->as.ifStmt.elseBranch));
+            }
+            node->run = ifHandler;
+            break;
+        case STMT_WHILE:
+            node->expr = compileExpr(AS_EXPR(stmt->as.whileStmt.condition));
+            node->body = compileStmt(AS_STMT(stmt->as.whileStmt.body));
+            if (stmt->as.whileStmt.increment != 0) {
+                node->increment = compileExpr(AS_EXPR(stmt->as.whileStmt.increment));
+            }
+            node->run = whileHandler;
+            break;
+        case STMT_FUNCTION:
+            // the body is compiled when it is first called
+            node->run = functionHandler;
+            break;
+        case STMT_RETURN:
+            if (stmt->as.return_stmt.value != 0) {
+                node->expr = compileExpr(AS_EXPR(stmt->as.return_stmt.value));
+            }
+            node->run = returnHandler;
+            break;
+        case STMT_BREAK:
+            node->run = breakHandler;
+            break;
+        case STMT_CONTINUE:
+            node->run = continueHandler;
+            break;
+        default:
+            node->run = unknownStmtHandler;
+            break;
+    }
+    return node;
+}
+
+// --- Entry Points ---
+
+void runCompiled(StmtList* statements) {
+    // top-level statements run in the current environment, not a new block
+    for (int i = 0; i < STMT_COUNT(statements) && !runtimeErrorOccurred; i++) {
+        CompiledStmt* node = compileStmt(LIST_STMT(statements, i));
+        node->run(node);
+    }
+}
+
+Completion runCompiledBody(Stmt* function, Environment* environment) {
+    CompiledStmt* body = AS_FUNCTION_STMT(function)->compiled;
+    if (body == NULL) {
+        body = allocateCompiled(sizeof(CompiledStmt));
+        body->stmt = function;
+        compileStatements(body, AS_STMT_LIST(AS_FUNCTION_STMT(function)->body));
+        AS_FUNCTION_STMT(function)->compiled = body;
+
+        if (compiledFunctionCount >= compiledFunctionCapacity) {
+            int oldCapacity = compiledFunctionCapacity;
+            compiledFunctionCapacity = GROW_CAPACITY(oldCapacity);
+            compiledFunctions = GROW_ARRAY(Stmt*, compiledFunctions, oldCapacity, compiledFunctionCapacity);
+        }
+        compiledFunctions[compiledFunctionCount++] = function;
+    }
+    return runStatements(body, environment);
+}
+
+void freeCompiledCode() {
+    for (int i = 0; i < compiledFunctionCount; i++) {
+        AS_FUNCTION_STMT(compiledFunctions[i])->compiled = NULL;
+    }
+    FREE_ARRAY(Stmt*, compiledFunctions, compiledFunctionCapacity);
+    compiledFunctions = NULL;
+    compiledFunctionCount = 0;
+    compiledFunctionCapacity = 0;
+
+    for (int i = 0; i < allocationCount; i++) {
+        reallocate(allocations[i], 0);
+    }
+    FREE_ARRAY(void*, allocations, allocationCapacity);
+    allocations = NULL;
+    allocationCount = 0;
+    allocationCapacity = 0;
+}
@@ -0,0 +1,23 @@
+#ifndef sg_closure_h
+#define sg_closure_h
+
+#include "../ast/stmt.h"
+#include "environment.h"
+#include "interpreter.h"
+
+// the closure engine (--engine=closure). every node is compiled once into a
+// struct holding a pointer to the C function that runs it, picked by operator
+// and operand kind, so running it needs no switch on node types.
+
+// compile statements and run them
+void runCompiled(StmtList* statements);
+
+// run a function body in environment, compiling it on the first call.
+// environment is freed afterwards, like executeBlock does. says how the
+// body finished.
+Completion runCompiledBody(Stmt* function, Environment* environment);
+
+// free all compiled code. call together with freeing the AST it came from.
+void freeCompiledCode();
+
+#endif
@@ -9,6 +9,10 @@
 
 #define INITIAL_CAPACITY 8
 
+// entries, shared by every frame; frames that don't fit anymore keep their
+// entries on the heap instead
+#define FRAME_STACK_SIZE 65536
+
 // Helper to initialize the entry array within an environment
 static void initEntries(Environment* environment, int capacity) {
     // printf("Initializing environment entries with capacity: %d\n", capacity);
@@ -23,11 +27,11 @@ static void initEntries(Environment* environment, int capacity) {
     }
     environment->capacity = capacity;
     environment->count = 0;
-    // initialize entry names to NULL for safe freeing
     for (int i = 0; i < capacity; i++) {
         // set to default values
-        environment->entries[i].name = NULL;
+        environment->entries[i].name = NO_SYMBOL;
         environment->entries[i].value = NIL_VAL;
+        environment->entries[i].type = STATIC_UNKNOWN;
     }
 }
 
@@ -44,6 +48,11 @@ Environment* newEnvironment() {
         return NULL;
     }
     environment->enclosing = NULL;
+    environment->index = NULL;
+    environment->indexCapacity = 0;
+    environment->openUpvalues = NULL;
+    environment->frame = -1;
+    environment->stacked = false;
     return environment;
 }
 
@@ -60,26 +69,103 @@ Environment* newEnclosedEnvironment(Environment* enclosing) {
         return NULL;
     }
     environment->enclosing = enclosing;
+    environment->index = NULL;
+    environment->indexCapacity = 0;
+    environment->openUpvalues = NULL;
+    environment->frame = -1;
+    environment->stacked = false;
     return environment;
 }
 
+// --- Frames ---
+
+static Entry* frameStack = NULL;
+static int frameTop = 0;
+
+Environment* pushFrame(Environment* frame, Environment* enclosing, int slots) {
+    if (frameStack == NULL) {
+        frameStack = ALLOCATE(Entry, FRAME_STACK_SIZE);
+        if (frameStack == NULL) {
+            fprintf(stderr, "Memory problem lah: Cannot allocate frame stack leh.\n");
+            return NULL;
+        }
+    }
+
+    frame->frame = frameTop;
+    if (slots <= FRAME_STACK_SIZE - frameTop) {
+        // nothing reads past count, the entries need no clearing
+        frame->entries = &frameStack[frameTop];
+        frame->capacity = slots;
+        frame->count = 0;
+        frame->stacked = true;
+        frameTop += slots;
+    } else {
+        initEntries(frame, slots < INITIAL_CAPACITY ? INITIAL_CAPACITY : slots);
+        if (frame->capacity == 0) return NULL;
+        frame->stacked = false;
+    }
+    frame->enclosing = enclosing;
+    frame->index = NULL;
+    frame->indexCapacity = 0;
+    frame->openUpvalues = NULL;
+    return frame;
+}
+
+void freeFrames() {
+    FREE_ARRAY(Entry, frameStack, FRAME_STACK_SIZE);
+    frameStack = NULL;
+    frameTop = 0;
+}
+
 // Free an environment and its entries
 void freeEnvironment(Environment* environment) {
     if (environment == NULL) return;
-    for (int i = 0; i < environment->count; i++) {
-        // free the copied variable name string
-        if (environment->entries[i].name != NULL) {
-            FREE(char, environment->entries[i].name);
-        }
+    // nothing should have captured a frame, but an upvalue must never dangle
+    for (ObjUpvalue* upvalue = environment->openUpvalues; upvalue != NULL; upvalue = upvalue->next) {
+        upvalue->closed = *upvalue->location;
+        upvalue->location = &upvalue->closed;
+    }
+    if (environment->frame >= 0) {
+        if (!environment->stacked) FREE_ARRAY(Entry, environment->entries, environment->capacity);
+        frameTop = environment->frame;
+        return;
     }
     if (environment->capacity > 0) {
         FREE_ARRAY(Entry, environment->entries, environment->capacity);
     }
+    FREE_ARRAY(int, environment->index, environment->indexCapacity);
 
     FREE(Environment, environment);
 }
 
+// a frame holding more locals than the resolver counted (the optimizer's
+// temporaries). the innermost one can grow in place, others move to the heap.
+static bool growFrame(Environment* frame) {
+    int newCapacity = frame->capacity < INITIAL_CAPACITY ? INITIAL_CAPACITY : frame->capacity * 2;
+    int end = frame->frame + frame->capacity;
+    if (end == frameTop && newCapacity <= FRAME_STACK_SIZE - frame->frame) {
+        frame->capacity = newCapacity;
+        frameTop = frame->frame + newCapacity;
+        return true;
+    }
+
+    Entry* newEntries = ALLOCATE(Entry, newCapacity);
+    if (newEntries == NULL) {
+        fprintf(stderr, "Memory problem lah: Cannot move frame entries to the heap leh.\n");
+        return false;
+    }
+    memcpy(newEntries, frame->entries, sizeof(Entry) * frame->count);
+    frame->entries = newEntries;
+    frame->capacity = newCapacity;
+    frame->stacked = false;
+    for (ObjUpvalue* upvalue = frame->openUpvalues; upvalue != NULL; upvalue = upvalue->next) {
+        upvalue->location = &newEntries[upvalue->slot].value;
+    }
+    return true;
+}
+
 static bool growCapacity(Environment* environment) {
+    if (environment->stacked) return growFrame(environment);
     int oldCapacity = environment->capacity;
 
     // just grow by 2x for now, can improve later
@@ -93,25 +179,88 @@ static bool growCapacity(Environment* environment) {
 
     // initialize new slots
     for (int i = oldCapacity; i < newCapacity; i++) {
-        newEntries[i].name = NULL;
+        newEntries[i].name = NO_SYMBOL;
         newEntries[i].value = NIL_VAL;
+        newEntries[i].type = STATIC_UNKNOWN;
     }
 
     environment->entries = newEntries;
     environment->capacity = newCapacity;
+    for (ObjUpvalue* upvalue = environment->openUpvalues; upvalue != NULL; upvalue = upvalue->next) {
+        upvalue->location = &newEntries[upvalue->slot].value;
+    }
     return true;
 }
 
-bool environmentDefine(Environment* environment, const char* name, Value value) {
-    if (environment == NULL || name == NULL) return false;
+// --- Global Index ---
 
-    // Check if variable already exists in the current scope for redefinition
+// symbols are consecutive, multiplying spreads them over the whole table
+static int homeSlot(SymbolId name, int capacity) {
+    return (int)((name * 2654435769u) & (uint32_t)(capacity - 1));
+}
+
+// the index slot holding name, or the free one where it would go
+static int findIndexSlot(Environment* environment, SymbolId name) {
+    int mask = environment->indexCapacity - 1;
+    for (int slot = homeSlot(name, environment->indexCapacity);; slot = (slot + 1) & mask) {
+        int entry = environment->index[slot];
+        if (entry < 0 || environment->entries[entry].name == name) return slot;
+    }
+}
+
+static bool growIndex(Environment* environment) {
+    int capacity = environment->indexCapacity < 16 ? 16 : environment->indexCapacity * 2;
+    int* index = ALLOCATE(int, capacity);
+    if (index == NULL) {
+        fprintf(stderr, "Memory problem lah: Cannot grow global variable index leh.\n");
+        return false;
+    }
+    for (int i = 0; i < capacity; i++) {
+        index[i] = -1;
+    }
+    FREE_ARRAY(int, environment->index, environment->indexCapacity);
+    environment->index = index;
+    environment->indexCapacity = capacity;
+    for (int entry = 0; entry < environment->count; entry++) {
+        index[findIndexSlot(environment, environment->entries[entry].name)] = entry;
+    }
+    return true;
+}
+
+int environmentSlot(Environment* environment, SymbolId name) {
+    if (environment->indexCapacity == 0) return -1;
+    return environment->index[findIndexSlot(environment, name)];
+}
+
+// the entry number of name in this environment alone, -1 if not there
+static int findEntry(Environment* environment, SymbolId name) {
+    if (environment->enclosing == NULL) return environmentSlot(environment, name);
     for (int i = 0; i < environment->count; i++) {
-        if (environment->entries[i].name != NULL && strcmp(environment->entries[i].name, name) == 0) {
-            // Overwrite existing variable in this scope
-            environment->entries[i].value = value;
-            return true;
-        }
+        if (environment->entries[i].name == name) return i;
+    }
+    return -1;
+}
+
+// --- Definitions and Lookups ---
+
+bool environmentDefine(Environment* environment, SymbolId name, Value value) {
+    return environmentDefineTyped(environment, name, value, STATIC_UNKNOWN);
+}
+
+bool environmentDefineTyped(Environment* environment, SymbolId name, Value value, StaticType type) {
+    if (environment == NULL || name == NO_SYMBOL) return false;
+
+    // Check if variable already exists in the current scope for redefinition
+    int existing = findEntry(environment, name);
+    if (existing >= 0) {
+        // Overwrite existing variable in this scope, the new declaration's type wins
+        environment->entries[existing].value = value;
+        environment->entries[existing].type = type;
+        return true;
+    }
+    bool global = environment->enclosing == NULL;
+    if (global && 2 * (environment->count + 1) > environment->indexCapacity && !growIndex(environment)) {
+        return false;
     }
 
     // if not redefining, add a new entry. grow capacity if needed.
@@ -123,89 +272,65 @@ bool environmentDefine(Environment* environment, const char* name, Value value)
     }
 
     // Add the new variable
-    char* nameCopy = ALLOCATE(char, strlen(name) + 1);
-    if (nameCopy == NULL) {
-        fprintf(stderr, "Memory problem lah: Cannot allocate variable name copy ok?.\n");
-        return false;
-    }
-    strcpy(nameCopy, name);
-
-    environment->entries[environment->count].name = nameCopy;
+    environment->entries[environment->count].name = name;
     environment->entries[environment->count].value = value;
+    environment->entries[environment->count].type = type;
+    if (global) environment->index[findIndexSlot(environment, name)] = environment->count;
     environment->count++;
     return true;
 }
 
-static char* tokenToString(Token* token) {
-    if (token == NULL || token->start == NULL) return NULL;
-    char* lexeme = malloc(token->length + 1); // + 1 for null terminator
-    if (lexeme == NULL) return NULL;
-    strncpy(lexeme, token->start, token->length);
-    lexeme[token->length] = '\0';
-    return lexeme;
-}
-
-// get a variable's value. checks current scope then enclosing scopes.
-bool environmentGet(Environment* environment, Token* nameToken, Value* outValue) {
-    if (environment == NULL || nameToken == NULL || outValue == NULL) return false;
+ObjUpvalue* environmentCapture(Environment* environment, SymbolId name) {
+    for (; environment != NULL && environment->enclosing != NULL; environment = environment->enclosing) {
+        int slot = findEntry(environment, name);
+        if (slot < 0) continue;
 
-    char* name = tokenToString(nameToken);
-    if (name == NULL) {
-        fprintf(stderr, "Memory problem lah: Got issue when processing variable name token sia.\n");
-        return false;
-    }
-
-    // check current scope
-    for (int i = 0; i < environment->count; i++) {
-        if (environment->entries[i].name != NULL && strcmp(environment->entries[i].name, name) == 0) {
-            *outValue = environment->entries[i].value;
-            free(name); // free the copied name string
-            return true;
+        for (ObjUpvalue* upvalue = environment->openUpvalues; upvalue != NULL; upvalue = upvalue->next) {
+            if (upvalue->slot == slot) return upvalue;
         }
+        Entry* entry = &environment->entries[slot];
+        ObjUpvalue* upvalue = newUpvalue(&entry->value, entry->type, slot);
+        upvalue->next = environment->openUpvalues;
+        environment->openUpvalues = upvalue;
+        return upvalue;
     }
+    return NULL;
+}
 
-    // if not found, check enclosing scope (recursive)
-    if (environment->enclosing != NULL) {
-        bool found = environmentGet(environment->enclosing, nameToken, outValue);
-        free(name); // free the name allocated in this call regardless of find result
-        return found;
-    }
-
-    // printf("Variable '%s' not found in any scope.\n", name);
-    free(name);
-    return false;
+// get a variable's value. checks current scope then enclosing scopes.
+bool environmentGet(Environment* environment, Token* nameToken, Value* outValue) {
+    if (outValue == NULL) return false;
+    Entry* entry = environmentFind(environment, nameToken);
+    if (entry == NULL) return false;
+    *outValue = entry->value;
+    return true;
 }
 
 // assign a value to an *existing* variable. checks current scope then enclosing.
 bool environmentAssign(Environment* environment, Token* nameToken, Value value) {
     // NOTE: if we decide to support CONSTANTS, can check here?
+    Entry* entry = environmentFind(environment, nameToken);
+    if (entry == NULL) return false;
+    entry->value = value;
+    return true;
+}
 
-    if (environment == NULL || nameToken == NULL) return false;
-
-    char* name = tokenToString(nameToken);
-    if (name == NULL) {
-        fprintf(stderr, "Memory problem lah: Processing variable name token for assignment also got problem leh.\n");
-        return false;
-    }
+// find the entry for a name. checks current scope then enclosing.
+Entry* environmentFind(Environment* environment, Token* nameToken) {
+    if (environment == NULL || nameToken == NULL) return NULL;
 
-    // check current scope first
-    for (int i = 0; i < environment->count; i++) {
-        if (environment->entries[i].name != NULL && strcmp(environment->entries[i].name, name) == 0) {
-            environment->entries[i].value = value;
-            free(name); // free the copied name string
-            return true;
+    SymbolId name = nameToken->symbol;
+    for (; environment->enclosing != NULL; environment = environment->enclosing) {
+        for (int i = 0; i < environment->count; i++) {
+            if (environment->entries[i].name == name) return &environment->entries[i];
         }
     }
-
-    // if not found, try assigning in enclosing scope (recursive)
-    if (environment->enclosing != NULL) {
-        bool assigned = environmentAssign(environment->enclosing, nameToken, value);
-        free(name); // free the name allocated in this call regardless of assignment result
-        return assigned;
+    // the global one, probing its index in place: this is the hot path
+    if (environment->indexCapacity == 0) return NULL;
+    int mask = environment->indexCapacity - 1;
+    for (int slot = homeSlot(name, environment->indexCapacity);; slot = (slot + 1) & mask) {
+        int entry = environment->index[slot];
+        if (entry < 0) return NULL;
+        if (environment->entries[entry].name == name) return &environment->entries[entry];
     }
-
-    // variable not found in any scope for assignment
-    printf("Variable '%s' not found in any scope for assignment.\n", name);
-    free(name);
-    return false;
-}
\ No newline at end of file
+}
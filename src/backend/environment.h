@@ -3,15 +3,19 @@
 
 #include "../runtime/object.h"  
 #include "../frontend/scanner.h"
+#include "../ast/expr.h"
 
 // forward declare environment struct for the pointer in itself
 typedef struct Environment Environment;
 
-// using a simple dynamic array for entries
-// alternatives: hash table (better performance), linked list (simpler?).
+// entries sit in a dynamic array in the order they were defined. local
+// scopes are small and just scan it. the global one also keeps an index, an
+// open addressing table from symbol to entry number, because every lookup
+// that isn't local ends there, however many globals there are.
 typedef struct {
-    char* name;  // Variable name (key)
+    SymbolId name;  // Variable name (key), see frontend/symbol.h
     Value value; // Variable value
+    StaticType type; // declared type, STATIC_UNKNOWN if the variable is not annotated
 } Entry;
 
 struct Environment {
@@ -19,6 +23,11 @@ struct Environment {
     int capacity;
     Entry* entries; // dynamic array of entries
     Environment* enclosing; // pointer to outer scope's environment, NULL if global
+    int* index; // global only: entry numbers by symbol, -1 in free slots
+    int indexCapacity; // a power of two, at most half full
+    ObjUpvalue* openUpvalues; // captured entries, closed when it is freed
+    int frame; // frames only: the frame stack top to go back to, -1 for heap environments
+    bool stacked; // its entries are on the frame stack
 };
 
 // initialize a new top-level (global) environment
@@ -27,12 +36,42 @@ Environment* newEnvironment();
 // initialize a new nested environment linked to an outer one
 Environment* newEnclosedEnvironment(Environment* enclosing);
 
-// free an environment and its entries (but not recursively freeing enclosing)
+// a nested environment for a scope the resolver proved nothing captures (see
+// BlockStmt.captured): frame is the caller's, usually a local variable, and
+// the entries go on the frame stack with room for slots of them. scopes end
+// innermost first, so freeing it again just moves the stack top back.
+Environment* pushFrame(Environment* frame, Environment* enclosing, int slots);
+
+// free an environment and its entries (but not recursively freeing enclosing),
+// or pop it if it is a frame. variables functions captured from it live on in
+// their upvalues.
 void freeEnvironment(Environment* environment);
 
+// free the frame stack, once no frame is left
+void freeFrames();
+
 // define (or re-define) a variable in the *current* environment scope.
-// name ownership is taken (environment will free it).
-bool environmentDefine(Environment* environment, const char* name, Value value);
+bool environmentDefine(Environment* environment, SymbolId name, Value value);
+
+// same, for a variable or parameter with a type annotation. the caller checks
+// that value has the declared type.
+bool environmentDefineTyped(Environment* environment, SymbolId name, Value value, StaticType type);
+
+// find the entry a name refers to. checks current scope then enclosing scopes.
+// returns NULL if not found. the pointer is only good until the next define
+// in that environment.
+Entry* environmentFind(Environment* environment, Token* nameToken);
+
+// where name is in a global environment's entries, -1 if it isn't defined
+// there. an entry keeps its number for good, redefining it reuses it, so
+// code can hold on to the number; the entries array itself can move when it
+// grows.
+int environmentSlot(Environment* environment, SymbolId name);
+
+// the upvalue for the local variable name, as seen from environment: the
+// same one for every function that captures that variable while its scope
+// runs. globals are never captured. NULL if there is no such local.
+ObjUpvalue* environmentCapture(Environment* environment, SymbolId name);
 
 // get a variable's value. checks current scope then enclosing scopes recursively.
 // returns true if found (value copied to *outValue), false otherwise.
@@ -0,0 +1,368 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../ast/pool.h"
+#include "../frontend/analysis.h"
+#include "../frontend/cache.h"
+#include "../frontend/source.h"
+#include "../runtime/memory.h"
+#include "../runtime/object.h"
+#include "environment.h"
+#include "image.h"
+#include "interpreter.h"
+
+#define IMAGE_VERSION 2
+
+static const char IMAGE_MAGIC[4] = {'S', 'G', 'I', '\0'};
+
+// in native byte order, like caches. the sections follow in this order. the
+// source is followed by a '\0', so function bodies the parser skipped can be
+// parsed right where they are.
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t astVersion; // AST_FORMAT_VERSION of the functions section
+    uint32_t globalCount;
+    uint64_t sourceLength; // the script the functions were declared in
+    uint64_t functionsLength; // their declarations, from encodeStatements
+    uint64_t globalsLength;
+    uint64_t payloadHash; // of the three sections
+} ImageHeader;
+
+// how a global's value is stored
+typedef enum {
+    IMAGE_NIL,
+    IMAGE_BOOL,
+    IMAGE_NUMBER,
+    IMAGE_STRING,
+    IMAGE_FUNCTION // index of its declaration in the functions section
+} ImageValue;
+
+// --- Saving ---
+
+typedef struct {
+    uint8_t* bytes;
+    size_t count;
+    size_t capacity;
+} Buffer;
+
+static void append(Buffer* buffer, const void* bytes, size_t size) {
+    if (buffer->capacity - buffer->count < size) {
+        size_t capacity = buffer->capacity;
+        while (capacity - buffer->count < size) {
+            capacity = GROW_CAPACITY(capacity);
+        }
+        buffer->bytes = GROW_ARRAY(uint8_t, buffer->bytes, buffer->capacity, capacity);
+        buffer->capacity = capacity;
+    }
+    memcpy(buffer->bytes + buffer->count, bytes, size);
+    buffer->count += size;
+}
+
+static void appendByte(Buffer* buffer, uint8_t value) {
+    append(buffer, &value, 1);
+}
+
+static void appendLength(Buffer* buffer, uint32_t value) {
+    append(buffer, &value, sizeof(value));
+}
+
+// the declarations functions are saved from, each once
+typedef struct {
+    Stmt** declarations;
+    int count;
+    int capacity;
+} Declarations;
+
+static uint32_t declarationIndex(Declarations* saved, Stmt* declaration) {
+    for (int i = 0; i < saved->count; i++) {
+        if (saved->declarations[i] == declaration) return (uint32_t)i;
+    }
+    if (saved->count >= saved->capacity) {
+        int oldCapacity = saved->capacity;
+        saved->capacity = GROW_CAPACITY(oldCapacity);
+        saved->declarations = GROW_ARRAY(Stmt*, saved->declarations, oldCapacity, saved->capacity);
+    }
+    saved->declarations[saved->count] = declaration;
+    return (uint32_t)saved->count++;
+}
+
+// the globals section. false if some global can't be saved.
+static bool appendGlobals(Buffer* globals, uint32_t* count, Declarations* saved) {
+    for (int i = 0; i < globalEnvironment->count; i++) {
+        Entry* entry = &globalEnvironment->entries[i];
+        Value value = entry->value;
+        ImageValue kind;
+        if (IS_NIL(value)) {
+            kind = IMAGE_NIL;
+        } else if (IS_BOOL(value)) {
+            kind = IMAGE_BOOL;
+        } else if (IS_NUMBER(value)) {
+            kind = IMAGE_NUMBER;
+        } else if (AS_OBJ(value)->type == OBJ_STRING) {
+            kind = IMAGE_STRING;
+        } else if (AS_OBJ(value)->type == OBJ_FUNCTION) {
+            if (AS_FUNCTION(value)->upvalueCount > 0) {
+                fprintf(stderr, "Aiyo, cannot snapshot '%s' lah, its function uses variables from the block around it.\n", symbolName(entry->name));
+                return false;
+            }
+            kind = IMAGE_FUNCTION;
+        } else {
+            continue; // natives, every interpreter defines those itself
+        }
+
+        const char* name = symbolName(entry->name);
+        uint32_t nameLength = (uint32_t)strlen(name);
+        appendLength(globals, nameLength);
+        append(globals, name, nameLength);
+        appendByte(globals, (uint8_t)entry->type);
+        appendByte(globals, (uint8_t)kind);
+        switch (kind) {
+            case IMAGE_NIL:
+                break;
+            case IMAGE_BOOL:
+                appendByte(globals, AS_BOOL(value));
+                break;
+            case IMAGE_NUMBER:
+                append(globals, &AS_NUMBER(value), sizeof(double));
+                break;
+            case IMAGE_STRING: {
+                ObjString* string = (ObjString*)AS_OBJ(value);
+                appendLength(globals, (uint32_t)string->length);
+                append(globals, string->chars, string->length);
+                break;
+            }
+            case IMAGE_FUNCTION:
+                appendLength(globals, declarationIndex(saved, AS_FUNCTION(value)->declaration));
+                break;
+        }
+        (*count)++;
+    }
+    return true;
+}
+
+static bool writeImage(const char* imagePath, ImageHeader* header, const char* source,
+                       const uint8_t* functions, const uint8_t* globals) {
+    FILE* file = fopen(imagePath, "wb");
+    if (file == NULL) return false;
+    bool written = fwrite(header, sizeof(*header), 1, file) == 1 &&
+                   fwrite(source, 1, header->sourceLength, file) == header->sourceLength &&
+                   fputc('\0', file) != EOF &&
+                   fwrite(functions, 1, header->functionsLength, file) == header->functionsLength &&
+                   fwrite(globals, 1, header->globalsLength, file) == header->globalsLength;
+    return fclose(file) == 0 && written;
+}
+
+bool saveImage(const char* imagePath, const char* source, size_t sourceLength) {
+    Buffer globals = {NULL, 0, 0};
+    Declarations saved = {NULL, 0, 0};
+    uint32_t globalCount = 0;
+    if (!appendGlobals(&globals, &globalCount, &saved)) {
+        FREE_ARRAY(Stmt*, saved.declarations, saved.capacity);
+        FREE_ARRAY(uint8_t, globals.bytes, globals.capacity);
+        return false;
+    }
+
+    // skipped bodies are saved as such when they are in source. ones from an
+    // earlier image are parsed now, their text won't be in this one.
+    for (int i = 0; i < saved.count; i++) {
+        const char* start = AS_FUNCTION_STMT(saved.declarations[i])->lazy.start;
+        if (start != NULL && (start < source || start >= source + sourceLength) &&
+            !loadFunctionBody(saved.declarations[i])) {
+            FREE_ARRAY(Stmt*, saved.declarations, saved.capacity);
+            FREE_ARRAY(uint8_t, globals.bytes, globals.capacity);
+            return false;
+        }
+    }
+
+    // the declarations as a statement list, for encodeStatements
+    StmtListBuilder builder;
+    initStmtListBuilder(&builder);
+    for (int i = 0; i < saved.count; i++) {
+        addStmt(&builder, saved.declarations[i]);
+    }
+    StmtList* functions = buildStmtList(&builder);
+    size_t functionsLength = 0;
+    uint8_t* functionBytes = encodeStatements(functions, source, sourceLength, &functionsLength);
+
+    ImageHeader header;
+    memcpy(header.magic, IMAGE_MAGIC, sizeof(header.magic));
+    header.version = IMAGE_VERSION;
+    header.astVersion = AST_FORMAT_VERSION;
+    header.globalCount = globalCount;
+    header.sourceLength = sourceLength;
+    header.functionsLength = functionsLength;
+    header.globalsLength = globals.count;
+    uint64_t hashes[3] = {hashBytes(source, sourceLength), hashBytes(functionBytes, functionsLength),
+                          hashBytes(globals.bytes, globals.count)};
+    header.payloadHash = hashBytes(hashes, sizeof(hashes));
+
+    bool written = functionBytes != NULL && writeImage(imagePath, &header, source, functionBytes, globals.bytes);
+    if (!written) fprintf(stderr, "Aiyo, cannot write image \"%s\" lah.\n", imagePath);
+
+    FREE_ARRAY(uint8_t, functionBytes, functionsLength);
+    FREE_ARRAY(Stmt*, saved.declarations, saved.capacity);
+    FREE_ARRAY(uint8_t, globals.bytes, globals.capacity);
+    return written;
+}
+
+// --- Loading ---
+
+// the mapped image. function tokens point into the source inside it.
+static Source image = {NULL, 0, 0};
+static StmtList* imageFunctions = NULL;
+
+// reads of the globals section. once anything is off, failed is set and the
+// rest reads as zeroes.
+typedef struct {
+    const uint8_t* at;
+    const uint8_t* end;
+    bool failed;
+} Reader;
+
+static const uint8_t* take(Reader* reader, size_t size) {
+    static const uint8_t zeroes[sizeof(double)] = {0};
+    if (reader->failed || (size_t)(reader->end - reader->at) < size) {
+        reader->failed = true;
+        return zeroes;
+    }
+    const uint8_t* bytes = reader->at;
+    reader->at += size;
+    return bytes;
+}
+
+static uint32_t takeLength(Reader* reader) {
+    uint32_t value;
+    memcpy(&value, take(reader, sizeof(value)), sizeof(value));
+    return value;
+}
+
+static bool defineGlobals(Reader* reader, uint32_t count, Stmt** functions, int functionCount) {
+    for (uint32_t i = 0; i < count && !reader->failed; i++) {
+        uint32_t nameLength = takeLength(reader);
+        if ((size_t)(reader->end - reader->at) < nameLength) return false;
+        SymbolId name = internSymbol((const char*)take(reader, nameLength), nameLength);
+        uint8_t type = *take(reader, 1);
+        uint8_t kind = *take(reader, 1);
+
+        Value value = NIL_VAL;
+        switch (kind) {
+            case IMAGE_NIL:
+                break;
+            case IMAGE_BOOL:
+                value = BOOL_VAL(*take(reader, 1) != 0);
+                break;
+            case IMAGE_NUMBER: {
+                double number;
+                memcpy(&number, take(reader, sizeof(double)), sizeof(double));
+                value = NUMBER_VAL(number);
+                break;
+            }
+            case IMAGE_STRING: {
+                uint32_t length = takeLength(reader);
+                if ((size_t)(reader->end - reader->at) < length) {
+                    reader->failed = true;
+                    break;
+                }
+                value = OBJ_VAL(copyString((const char*)take(reader, length), (int)length));
+                break;
+            }
+            case IMAGE_FUNCTION: {
+                uint32_t index = takeLength(reader);
+                if (index >= (uint32_t)functionCount) {
+                    reader->failed = true;
+                    break;
+                }
+                value = OBJ_VAL(newFunction(functions[index]));
+                break;
+            }
+            default:
+                reader->failed = true;
+                break;
+        }
+        if (type > STATIC_NIL) reader->failed = true;
+        if (!reader->failed) environmentDefineTyped(globalEnvironment, name, value, (StaticType)type);
+    }
+    return !reader->failed && reader->at == reader->end;
+}
+
+bool loadImage(const char* imagePath) {
+    if (!loadSource(&image, imagePath)) return false;
+
+    ImageHeader header;
+    const uint8_t* bytes = (const uint8_t*)image.text;
+    bool valid = image.length >= sizeof(header);
+    if (valid) {
+        memcpy(&header, bytes, sizeof(header));
+        valid = memcmp(header.magic, IMAGE_MAGIC, sizeof(header.magic)) == 0 &&
+                header.version == IMAGE_VERSION && header.astVersion == AST_FORMAT_VERSION &&
+                header.sourceLength < image.length - sizeof(header) &&
+                bytes[sizeof(header) + header.sourceLength] == '\0' &&
+                header.functionsLength <= image.length - sizeof(header) - header.sourceLength - 1 &&
+                header.globalsLength == image.length - sizeof(header) - header.sourceLength - 1 - header.functionsLength;
+    }
+
+    const char* source = NULL;
+    const uint8_t* functionBytes = NULL;
+    const uint8_t* globals = NULL;
+    if (valid) {
+        source = (const char*)bytes + sizeof(header);
+        functionBytes = (const uint8_t*)source + header.sourceLength + 1;
+        globals = functionBytes + header.functionsLength;
+        uint64_t hashes[3] = {hashBytes(source, header.sourceLength), hashBytes(functionBytes, header.functionsLength),
+                              hashBytes(globals, header.globalsLength)};
+        valid = header.payloadHash == hashBytes(hashes, sizeof(hashes));
+    }
+
+    StmtList* functions = NULL;
+    if (valid) {
+        valid = decodeStatements(functionBytes, header.functionsLength, source, header.sourceLength, &functions);
+    }
+    if (!valid) {
+        fprintf(stderr, "Aiyo, \"%s\" is not an image this sing can use lah.\n", imagePath);
+        freeImage();
+        return false;
+    }
+
+    int functionCount = STMT_COUNT(functions);
+    Stmt** declarations = ALLOCATE(Stmt*, functionCount > 0 ? functionCount : 1);
+    for (int i = 0; i < functionCount; i++) {
+        // whether they stay pure depends on what the next program does with
+        // the names they call, which the optimizer never sees together
+        declarations[i] = LIST_STMT(functions, i);
+        AS_FUNCTION_STMT(declarations[i])->pure = false;
+    }
+
+    Reader reader = {globals, globals + header.globalsLength, false};
+    valid = defineGlobals(&reader, header.globalCount, declarations, functionCount);
+    FREE_ARRAY(Stmt*, declarations, functionCount);
+    if (!valid) {
+        fprintf(stderr, "Aiyo, \"%s\" is not an image this sing can use lah.\n", imagePath);
+        freeStmtList(functions);
+        freeImage();
+        return false;
+    }
+
+    // every program from now on may call them
+    keepAstPool();
+    setPrelude(functions);
+    imageFunctions = functions;
+    return true;
+}
+
+bool loadImageBodies() {
+    for (int i = 0; i < STMT_COUNT(imageFunctions); i++) {
+        if (!loadFunctionBody(LIST_STMT(imageFunctions, i))) return false;
+    }
+    keepAstPool(); // with the bodies
+    return true;
+}
+
+void freeImage() {
+    setPrelude(NULL);
+    imageFunctions = NULL;
+    freeKeptAstPool();
+    if (image.text != NULL) freeSource(&image);
+}
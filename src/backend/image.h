@@ -0,0 +1,29 @@
+#ifndef sg_image_h
+#define sg_image_h
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// heap images: the globals a script leaves behind, saved by --snapshot so a
+// later run can start from them (--image) instead of running the script
+// again. numbers, booleans, nil, strings and functions without upvalues are
+// saved. functions come with their declarations and the script's source,
+// which stays mapped and is pointed into like any parsed source.
+
+// save the global environment as it is now, after running the program in
+// source. says why and returns false if it can't be saved.
+bool saveImage(const char* imagePath, const char* source, size_t sourceLength);
+
+// define the globals saved in imagePath. says why and returns false if the
+// image can't be used.
+bool loadImage(const char* imagePath);
+
+// parse every function body in the loaded image that was left for its first
+// call, for runs that free the AST as they go (the REPL). false after a
+// syntax error.
+bool loadImageBodies();
+
+// unmap the loaded image and free its functions, once nothing runs anymore
+void freeImage();
+
+#endif
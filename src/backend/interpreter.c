@@ -9,26 +9,29 @@
 #include "../ast/expr.h"
 #include "../ast/stmt.h"
 #include "../frontend/scanner.h"
+#include "../runtime/memo.h"
 #include "../runtime/memory.h"
 #include "../runtime/object.h"
+#include "closure.h"
 #include "environment.h"
 #include <time.h>
 
 // --- Global State ---
-static Environment* globalEnvironment = NULL;
-static Environment* currentEnvironment = NULL;
-static bool runtimeErrorOccurred = false;
-static bool had_return = false;
-static Value return_value = NIL_VAL;
+Environment* globalEnvironment = NULL;
+Environment* currentEnvironment = NULL;
+ObjFunction* currentFunction = NULL;
+bool runtimeErrorOccurred = false;
+Value return_value = NIL_VAL;
+static bool memoizationEnabled = false;
+static Engine engine = ENGINE_TREE;
 
 // ===== Forward Declarations for Static Helpers =====
 static Value evaluateExpr(Expr* expr);
-static void executeStmt(Stmt* stmt);
-static void executeBlock(StmtList* statements, Environment* environment);
-static bool isTruthy(Value value);
-static void checkNumberOperand(Token* operatorToken, Value operand);
-static void checkNumberOperands(Token* operatorToken, Value left, Value right);
+static bool evaluateCondition(Expr* expr);
+static Completion executeStmt(Stmt* stmt);
+static Completion executeBlock(StmtList* statements, Environment* environment);
 static Value callFunction(ObjFunction* function, Value* arguments, int arg_count);
+static Value invokeFunction(ObjFunction* function, Value* arguments, int arg_count);
 static Value visitCallExpr(Expr* expr);
 static Value clockNative(struct Interpreter* interpreter, int arg_count, Value* args);
 
@@ -45,7 +48,7 @@ void initInterpreter() {
         if (clockFn != NULL) {
             clockFn->arity = 0;
             clockFn->function = clockNative;
-            environmentDefine(globalEnvironment, "clock", OBJ_VAL(clockFn));
+            environmentDefine(globalEnvironment, internSymbol("clock", 5), OBJ_VAL(clockFn));
         }
     }
     currentEnvironment = globalEnvironment;
@@ -58,6 +61,27 @@ void freeInterpreter() {
         globalEnvironment = NULL;
         currentEnvironment = NULL;
     }
+    freeFrames();
+    freeMemoTables();
+}
+
+void setMemoization(bool enabled) { memoizationEnabled = enabled; }
+
+void setEngine(Engine selected) { engine = selected; }
+
+// --- Lazily Parsed Bodies ---
+
+static BodyLoader bodyLoader = NULL;
+
+void setBodyLoader(BodyLoader loader) { bodyLoader = loader; }
+
+bool loadFunctionBody(Stmt* function) {
+    if (AS_FUNCTION_STMT(function)->lazy.start == NULL) return true;
+    if (bodyLoader == NULL || !bodyLoader(function)) {
+        runtimeErrorOccurred = true; // the loader already said what is wrong
+        return false;
+    }
+    return true;
 }
 
 // --- Runtime Error Handling ---
@@ -85,33 +109,37 @@ void resetRuntimeError() { runtimeErrorOccurred = false; }
 
 // Main entry point for executing code
 void interpretStatements(StmtList* statements) {
-    StmtList* current = statements;
-    while (current != NULL && !runtimeErrorOccurred) {
-        executeStmt(current->stmt);
-        current = current->next;
+    if (engine == ENGINE_CLOSURE) {
+        runCompiled(statements);
+        return;
+    }
+
+    // a top-level return just ends the statement it is in
+    for (int i = 0; i < STMT_COUNT(statements) && !runtimeErrorOccurred; i++) {
+        executeStmt(LIST_STMT(statements, i));
     }
 }
 
 // Executes a single statement
-static void executeStmt(Stmt* stmt) {
-    if (stmt == NULL || runtimeErrorOccurred) return;
+static Completion executeStmt(Stmt* stmt) {
+    if (stmt == NULL || runtimeErrorOccurred) return COMPLETION_NORMAL;
 
     switch (stmt->type) {
         case STMT_EXPRESSION: {
-            evaluateExpr(stmt->as.expression.expression); // Evaluate for side effects
+            evaluateExpr(AS_EXPR(stmt->as.expression.expression)); // Evaluate for side effects
             break;
         }
         case STMT_IF: {
-            if (isTruthy(evaluateExpr(stmt->as.ifStmt.condition))) {
-                executeStmt(stmt->as.ifStmt.thenBranch);
-            } else if (stmt->as.ifStmt.elseBranch != NULL) {
-                executeStmt(stmt->as.ifStmt.elseBranch);
+            if (evaluateCondition(AS_EXPR(stmt->as.ifStmt.condition))) {
+                return executeStmt(AS_STMT(stmt->as.ifStmt.thenBranch));
+            } else if (stmt->as.ifStmt.elseBranch != 0) {
+                return executeStmt(AS_STMT(stmt->as.ifStmt.elseBranch));
             }
             break;
         }
         case STMT_PRINT: {
-            Value value = evaluateExpr(stmt->as.print.expression);
-            if (runtimeErrorOccurred) return;
+            Value value = evaluateExpr(AS_EXPR(stmt->as.print.expression));
+            if (runtimeErrorOccurred) return COMPLETION_NORMAL;
             printValue(value);
             printf("\n");
             // TODO: Handle freeing potential heap objects from value (e.g.,
@@ -119,156 +147,267 @@ static void executeStmt(Stmt* stmt) {
             break;
         }
         case STMT_WHILE: {
-            while (isTruthy(evaluateExpr(stmt->as.whileStmt.condition))) {
-                executeStmt(stmt->as.whileStmt.body);
+            while (evaluateCondition(AS_EXPR(stmt->as.whileStmt.condition))) {
+                Completion completion = executeStmt(AS_STMT(stmt->as.whileStmt.body));
+                if (completion == COMPLETION_BREAK || runtimeErrorOccurred) break;
+                if (completion == COMPLETION_RETURN) return completion;
+                if (stmt->as.whileStmt.increment != 0) {
+                    evaluateExpr(AS_EXPR(stmt->as.whileStmt.increment));
+                }
             }
             break;
         }
         case STMT_VAR: {
             Value value = NIL_VAL; // Default value
-            if (stmt->as.var.initializer != NULL) {
-                value = evaluateExpr(stmt->as.var.initializer);
-                if (runtimeErrorOccurred) return;
+            if (stmt->as.var.initializer != 0) {
+                value = evaluateExpr(AS_EXPR(stmt->as.var.initializer));
+                if (runtimeErrorOccurred) return COMPLETION_NORMAL;
             }
-            // Get a temporary C string for the variable name
-            char* name = malloc(stmt->as.var.name.length + 1);
-            if (name == NULL) {
-                runtimeError(&stmt->as.var.name,
-                             "Memory error processing variable name.");
-                return;
-            }
-            strncpy(name, stmt->as.var.name.start, stmt->as.var.name.length);
-            name[stmt->as.var.name.length] = '\0';
-
-            if (!environmentDefine(currentEnvironment, name, value)) {
-                runtimeError(&stmt->as.var.name,
-                             "Memory error defining variable '%s'.", name);
-            }
-            free(name);
+            defineVariable(stmt, value);
             break;
         }
         case STMT_BLOCK: {
             // creates a new environment for the block, enclosing the current one
-            Environment* blockEnvironment = newEnclosedEnvironment(currentEnvironment);
+            Environment frame;
+            Environment* blockEnvironment = stmt->as.block.captured
+                ? newEnclosedEnvironment(currentEnvironment)
+                : pushFrame(&frame, currentEnvironment, stmt->as.block.localCount);
             if (blockEnvironment == NULL) {
                 runtimeError(NULL, "Memory error creating block environment.");
-                return;
+                return COMPLETION_NORMAL;
             }
-            // executes the block's statements in the new environment
-            executeBlock(stmt->as.block.statements, blockEnvironment);
-            // environment is freed within executeBlock after execution
-            break;
+            if (stmt->as.block.captured) defineAhead(blockEnvironment, AS_STMT_LIST(stmt->as.block.statements));
+            // executes the block's statements in the new environment,
+            // which is freed within executeBlock after execution
+            return executeBlock(AS_STMT_LIST(stmt->as.block.statements), blockEnvironment);
         }
-        case STMT_FUNCTION: {
-            // create function object with the current environment as closure
-            ObjFunction* function = newFunction(stmt, currentEnvironment);
-            if (function == NULL) {
-                runtimeError(&stmt->as.function.name, "Memory error creating function.");
-                return;
-            }
-
-            char* name = malloc(stmt->as.function.name.length + 1);
-            if (name == NULL) {
-                runtimeError(&stmt->as.function.name, "Memory error processing function name.");
-                return;
-            }
-            strncpy(name, stmt->as.function.name.start, stmt->as.function.name.length);
-            name[stmt->as.function.name.length] = '\0';
-
-            environmentDefine(currentEnvironment, name, OBJ_VAL(function));
-            free(name);
+        case STMT_FUNCTION:
+            defineFunction(stmt);
             break;
-        }
         case STMT_RETURN: {
             Value value = NIL_VAL;
-            if (stmt->as.return_stmt.value != NULL) {
-                value = evaluateExpr(stmt->as.return_stmt.value);
-                if (runtimeErrorOccurred) return;
+            if (stmt->as.return_stmt.value != 0) {
+                value = evaluateExpr(AS_EXPR(stmt->as.return_stmt.value));
+                if (runtimeErrorOccurred) return COMPLETION_NORMAL;
             }
 
-            had_return = true;
             return_value = value;
-            break;
+            return COMPLETION_RETURN;
         }
+        case STMT_BREAK:
+            return COMPLETION_BREAK;
+        case STMT_CONTINUE:
+            return COMPLETION_CONTINUE;
         default:
             runtimeError(NULL, "Interpreter error: Unknown statement type %d.",
                          stmt->type);
             break;
     }
+    return COMPLETION_NORMAL;
+}
+
+// --- Declarations ---
+// shared by both engines, after the initializer (if any) was evaluated
+
+void defineVariable(Stmt* stmt, Value value) {
+    SymbolId name = TOKEN_AT(stmt->as.var.name)->symbol;
+    StaticType declared = stmt->as.var.declaredType;
+    if (declared != STATIC_UNKNOWN && AS_EXPR(stmt->as.var.initializer)->staticType != declared && !hasType(value, declared)) {
+        runtimeError(TOKEN_AT(stmt->as.var.name), "Aiyo, '%s' is %s one, cannot put %s inside leh.",
+                     symbolName(name), staticTypeName(declared), valueTypeName(value));
+        return;
+    }
+
+    if (!environmentDefineTyped(currentEnvironment, name, value, declared)) {
+        runtimeError(TOKEN_AT(stmt->as.var.name),
+                     "Memory error defining variable '%s'.", symbolName(name));
+    }
+}
+
+void defineFunction(Stmt* stmt) {
+    ObjFunction* function = newFunction(stmt);
+    if (function == NULL) {
+        runtimeError(TOKEN_AT(AS_FUNCTION_STMT(stmt)->name), "Memory error creating function.");
+        return;
+    }
+
+    SymbolId name = TOKEN_AT(AS_FUNCTION_STMT(stmt)->name)->symbol;
+    if (function->upvalueCount > 0) {
+        // the name first, a local function can call itself
+        environmentDefine(currentEnvironment, name, NIL_VAL);
+        for (int i = 0; i < function->upvalueCount; i++) {
+            Upvalue* upvalue = &AS_FUNCTION_STMT(stmt)->upvalues[i];
+            if (upvalue->local) {
+                function->upvalues[i] = environmentCapture(currentEnvironment, upvalue->name.symbol);
+            } else {
+                function->upvalues[i] = currentFunction->upvalues[upvalue->index];
+            }
+            if (function->upvalues[i] == NULL) {
+                runtimeError(&upvalue->name, "Interpreter error: '%s' not there to capture.", symbolName(upvalue->name.symbol));
+                return;
+            }
+        }
+    }
+    environmentDefine(currentEnvironment, name, OBJ_VAL(function));
 }
 
-static void executeBlock(StmtList* statements, Environment* environment) {
+// the variables and functions declared directly in a scope, nil until their
+// statements run. a function in the scope can use the ones declared after it
+// (see declareAhead in the resolver), and takes them as upvalues when it is
+// defined, so they have to be there to capture. only captured scopes need it.
+void defineAhead(Environment* scope, StmtList* statements) {
+    for (int i = 0; i < STMT_COUNT(statements); i++) {
+        Stmt* stmt = LIST_STMT(statements, i);
+        if (stmt->type == STMT_VAR) {
+            environmentDefineTyped(scope, TOKEN_AT(stmt->as.var.name)->symbol, NIL_VAL, stmt->as.var.declaredType);
+        } else if (stmt->type == STMT_FUNCTION) {
+            environmentDefine(scope, TOKEN_AT(AS_FUNCTION_STMT(stmt)->name)->symbol, NIL_VAL);
+        }
+    }
+}
+
+static Completion executeBlock(StmtList* statements, Environment* environment) {
     Environment* previousEnvironment = currentEnvironment;
     // sets the new environment as current
     currentEnvironment = environment;
 
-    StmtList* current = statements;
-    // executes statements until the end or a runtime error occurs or if a return occurs
-    while (current != NULL && !runtimeErrorOccurred && !had_return) {
-        executeStmt(current->stmt);
-        current = current->next;
+    // executes statements until the end, a runtime error or a jump out of the block
+    Completion completion = COMPLETION_NORMAL;
+    for (int i = 0; i < STMT_COUNT(statements) && !runtimeErrorOccurred && completion == COMPLETION_NORMAL; i++) {
+        completion = executeStmt(LIST_STMT(statements, i));
     }
 
     currentEnvironment = previousEnvironment;
     freeEnvironment(environment);
+    return completion;
 }
 
 static Value callFunction(ObjFunction* function, Value* arguments, int arg_count) {
+    if (!memoizationEnabled || !AS_FUNCTION_STMT(function->declaration)->pure) {
+        return invokeFunction(function, arguments, arg_count);
+    }
+
+    // pure functions only depend on their arguments, so a cached result is as good as a call
+    if (function->memo == NULL) {
+        Token name = *TOKEN_AT(AS_FUNCTION_STMT(function->declaration)->name);
+        function->memo = newMemoTable(symbolName(name.symbol), name.length, function->arity);
+    }
+
+    Value result;
+    if (memoGet(function->memo, arguments, &result)) return result;
+
+    result = invokeFunction(function, arguments, arg_count);
+    if (!runtimeErrorOccurred) {
+        memoSet(function->memo, arguments, result);
+    }
+    return result;
+}
+
+static Value invokeFunction(ObjFunction* function, Value* arguments, int arg_count) {
     (void)arg_count;
-    Environment* environment = newEnclosedEnvironment(function->closure);
+    if (!loadFunctionBody(function->declaration)) return NIL_VAL;
+    // whatever the body names that isn't its own or an upvalue is a global
+    FunctionStmt* declaration = AS_FUNCTION_STMT(function->declaration);
+    Environment frame;
+    Environment* environment = declaration->captured
+        ? newEnclosedEnvironment(globalEnvironment)
+        : pushFrame(&frame, globalEnvironment, declaration->localCount);
     if (environment == NULL) {
         runtimeError(NULL, "Memory error creating function environment.");
         return NIL_VAL;
     }
 
     // Bind arguments to parameters
-    for (int i = 0; i < function->declaration->as.function.param_count; i++) {
-        Token param = function->declaration->as.function.params[i];
-
-        char* name = malloc(param.length + 1);
-        if (name == NULL) {
-            runtimeError(&param, "Memory error processing parameter name.");
-            freeEnvironment(environment);
-            return NIL_VAL;
-        }
-        strncpy(name, param.start, param.length);
-        name[param.length] = '\0';
-
-        environmentDefine(environment, name, arguments[i]);
-        free(name);
+    for (int i = 0; i < declaration->param_count; i++) {
+        SymbolId name = TOKEN_AT(declaration->params + i)->symbol;
+        StaticType* paramTypes = declaration->paramTypes;
+        environmentDefineTyped(environment, name, arguments[i], paramTypes != NULL ? paramTypes[i] : STATIC_UNKNOWN);
     }
+    if (declaration->captured) defineAhead(environment, AS_STMT_LIST(declaration->body));
 
     Environment* previous = currentEnvironment;
+    ObjFunction* enclosingFunction = currentFunction;
     currentEnvironment = environment;
+    currentFunction = function;
 
-    had_return = false;
-
-    executeBlock(function->declaration->as.function.body, environment);
+    Completion completion;
+    if (engine == ENGINE_CLOSURE) {
+        completion = runCompiledBody(function->declaration, environment);
+    } else {
+        completion = executeBlock(AS_STMT_LIST(declaration->body), environment);
+    }
 
     currentEnvironment = previous;
+    currentFunction = enclosingFunction;
+
+    Value result = completion == COMPLETION_RETURN ? return_value : NIL_VAL;
 
-    if (had_return) {
-        Value result = return_value;
-        had_return = false;
-        return result;
+    StaticType returnType = declaration->returnType;
+    if (returnType != STATIC_UNKNOWN && !runtimeErrorOccurred && !hasType(result, returnType)) {
+        Token name = *TOKEN_AT(declaration->name);
+        runtimeError(&name, "Aiyo, %s say will return %s, but give %s leh.",
+                     symbolName(name.symbol), staticTypeName(returnType), valueTypeName(result));
+        return NIL_VAL;
     }
+    return result;
+}
 
-    return NIL_VAL;
+// ===== Type Annotations =====
+bool hasType(Value value, StaticType type) {
+    switch (type) {
+        case STATIC_NUMBER:
+            return IS_NUMBER(value);
+        case STATIC_BOOL:
+            return IS_BOOL(value);
+        case STATIC_STRING:
+            return IS_STRING(value);
+        case STATIC_NIL:
+            return IS_NIL(value);
+        default:
+            return true;
+    }
+}
+
+const char* valueTypeName(Value value) {
+    if (IS_NUMBER(value)) return "number";
+    if (IS_BOOL(value)) return "bool";
+    if (IS_NIL(value)) return "nil";
+    if (IS_STRING(value)) return "string";
+    return "function";
+}
+
+// annotated parameters are checked once here, at the call. arguments the
+// inference pass already proved to have the right type skip the check, so
+// a fully typed call site costs nothing extra.
+static bool checkArgumentTypes(Expr* call, ObjFunction* function, Value* arguments) {
+    StaticType* paramTypes = AS_FUNCTION_STMT(function->declaration)->paramTypes;
+    if (paramTypes == NULL) return true;
+
+    for (int i = 0; i < function->arity; i++) {
+        if (paramTypes[i] == STATIC_UNKNOWN || CALL_ARGUMENT(&call->as.call, i)->staticType == paramTypes[i]) continue;
+        if (!hasType(arguments[i], paramTypes[i])) {
+            SymbolId param = TOKEN_AT(AS_FUNCTION_STMT(function->declaration)->params + i)->symbol;
+            runtimeError(TOKEN_AT(call->as.call.paren), "Aiyo, parameter '%s' must be %s, but you give %s leh.",
+                         symbolName(param), staticTypeName(paramTypes[i]), valueTypeName(arguments[i]));
+            return false;
+        }
+    }
+    return true;
 }
 
 // ===== Expression Evaluation stuff =====
-static bool isTruthy(Value value) {
+bool isTruthy(Value value) {
     if (IS_NIL(value)) return false;
     if (IS_BOOL(value)) return AS_BOOL(value);
     return true; // Numbers (and future objects) are truthy
 }
 
-static void checkNumberOperand(Token* operatorToken, Value operand) {
+void checkNumberOperand(Token* operatorToken, Value operand) {
     if (IS_NUMBER(operand)) return;
     runtimeError(operatorToken, "Operand must be a number.");
 }
 
-static void checkNumberOperands(Token* operatorToken, Value left, Value right) {
+void checkNumberOperands(Token* operatorToken, Value left, Value right) {
     if (IS_NUMBER(left) && IS_NUMBER(right)) return;
     runtimeError(operatorToken, "Operands must be numbers.");
 }
@@ -280,6 +419,264 @@ static Value clockNative(struct Interpreter* interpreter, int arg_count, Value*
     return NUMBER_VAL((double)time(NULL));
 }
 
+// ===== Operations shared with the closure engine =====
+
+// where the value of a variable read is. a captured variable is behind
+// one of the running function's upvalues. a read the resolver marked global
+// goes straight to the global environment, and after the first time straight
+// to its entry: a global keeps its slot for good (see environmentSlot), so
+// the slot found once is the inline cache and needs no other guard.
+Value* findVariable(Expr* variable) {
+    VariableExpr* read = &variable->as.variable;
+    if (read->global) {
+        if (read->slot < 0) {
+            read->slot = environmentSlot(globalEnvironment, TOKEN_AT(read->name)->symbol);
+            if (read->slot < 0) return NULL; // not defined yet, look again next time
+        }
+        return &globalEnvironment->entries[read->slot].value;
+    }
+    if (read->upvalue >= 0) return currentFunction->upvalues[read->upvalue]->location;
+    Entry* entry = environmentFind(currentEnvironment, TOKEN_AT(read->name));
+    return entry == NULL ? NULL : &entry->value;
+}
+
+Value readVariable(Expr* variable) {
+    Value* value = findVariable(variable);
+    if (value != NULL) return *value;
+    Token* name = TOKEN_AT(variable->as.variable.name);
+    runtimeError(name, "Undefined variable '%s'.", symbolName(name->symbol));
+    return NIL_VAL;
+}
+
+Value assignVariable(Expr* expr, Value value) {
+    Value* location = NULL;
+    StaticType type = STATIC_UNKNOWN;
+    if (expr->as.assign.upvalue >= 0) {
+        ObjUpvalue* upvalue = currentFunction->upvalues[expr->as.assign.upvalue];
+        location = upvalue->location;
+        type = upvalue->type;
+    } else {
+        Entry* entry = environmentFind(currentEnvironment, TOKEN_AT(expr->as.assign.name));
+        if (entry != NULL) {
+            location = &entry->value;
+            type = entry->type;
+        }
+    }
+
+    if (location != NULL) {
+        if (type != STATIC_UNKNOWN && AS_EXPR(expr->as.assign.value)->staticType != type && !hasType(value, type)) {
+            runtimeError(TOKEN_AT(expr->as.assign.name), "Aiyo, '%s' is %s one, cannot put %s inside leh.",
+                         symbolName(TOKEN_AT(expr->as.assign.name)->symbol),
+                         staticTypeName(type), valueTypeName(value));
+            return NIL_VAL;
+        }
+        *location = value;
+        return value;
+    }
+
+    Token* name = TOKEN_AT(expr->as.assign.name);
+    runtimeError(name, "Undefined variable '%s' for assignment.", symbolName(name->symbol));
+    return NIL_VAL;
+}
+
+// '+' adds numbers and joins strings
+Value addValues(Token* operatorToken, Value left, Value right) {
+    if (IS_NUMBER(left) && IS_NUMBER(right)) {
+        return NUMBER_VAL(AS_NUMBER(left) + AS_NUMBER(right));
+    }
+
+    // string concatenation
+    if (IS_STRING(left) && IS_STRING(right)) {
+        int leftLength = AS_STRING(left)->length;
+        int rightLength = AS_STRING(right)->length;
+        int totalLength = leftLength + rightLength;
+        char* result = ALLOCATE(char, totalLength + 1);
+        if (result == NULL) {
+            runtimeError(NULL, "Memory error creating string result.");
+            return NIL_VAL;
+        }
+        strncpy(result, AS_STRING(left)->chars, leftLength);
+        strncpy(result + leftLength, AS_STRING(right)->chars, rightLength);
+        result[totalLength] = '\0';
+        return OBJ_VAL(copyString(result, totalLength));
+    }
+    runtimeError(operatorToken, "Operands must be two numbers or two strings.");
+    return NIL_VAL;
+}
+
+// --- Self-Specializing Binary Nodes ---
+// the first time a binary node runs, if its operands are plain variables and
+// number literals it rewrites itself into one of the EXPR_BINARY_* kinds, which
+// read the operands straight out of the node instead of evaluating them. a
+// guard checks the variables still hold numbers; when it fails the node goes
+// back to being a plain EXPR_BINARY for good.
+
+static bool isNumberLiteral(Expr* expr) {
+    return expr->type == EXPR_LITERAL && expr->as.literal.type == TOKEN_NUMBER;
+}
+
+static void specializeBinary(Expr* expr) {
+    Expr* left = AS_EXPR(expr->as.binary.left);
+    Expr* right = AS_EXPR(expr->as.binary.right);
+    expr->as.binary.generic = true; // one chance only
+
+    if (left->type == EXPR_VARIABLE && isNumberLiteral(right)) {
+        expr->type = EXPR_BINARY_VAR_CONST;
+    } else if (isNumberLiteral(left) && right->type == EXPR_VARIABLE) {
+        expr->type = EXPR_BINARY_CONST_VAR;
+    } else if (left->type == EXPR_VARIABLE && right->type == EXPR_VARIABLE) {
+        expr->type = EXPR_BINARY_VAR_VAR;
+    }
+}
+
+static double numberOperand(Expr* operand, bool* ok) {
+    if (operand->type == EXPR_LITERAL) return operand->as.literal.value.number;
+    Value* value = findVariable(operand);
+    if (value == NULL || !IS_NUMBER(*value)) {
+        *ok = false;
+        return 0;
+    }
+    return AS_NUMBER(*value);
+}
+
+// the guard: false if a variable is missing or not a number
+static bool specializedOperands(Expr* expr, double* a, double* b) {
+    bool ok = true;
+    *a = numberOperand(AS_EXPR(expr->as.binary.left), &ok);
+    *b = numberOperand(AS_EXPR(expr->as.binary.right), &ok);
+    return ok;
+}
+
+// guard failed, evaluate it the slow way from now on
+static Value deoptimizeBinary(Expr* expr) {
+    expr->type = EXPR_BINARY;
+    return evaluateExpr(expr);
+}
+
+static Value numberBinary(Expr* expr, double a, double b) {
+    switch (TOKEN_AT(expr->as.binary.oper)->type) {
+        case TOKEN_GREATER:
+            return BOOL_VAL(a > b);
+        case TOKEN_GREATER_EQUAL:
+            return BOOL_VAL(a >= b);
+        case TOKEN_LESS:
+            return BOOL_VAL(a < b);
+        case TOKEN_LESS_EQUAL:
+            return BOOL_VAL(a <= b);
+        case TOKEN_BANG_EQUAL:
+            return BOOL_VAL(a != b);
+        case TOKEN_EQUAL_EQUAL:
+            return BOOL_VAL(a == b);
+        case TOKEN_MINUS:
+            return NUMBER_VAL(a - b);
+        case TOKEN_STAR:
+            return NUMBER_VAL(a * b);
+        case TOKEN_PLUS:
+            return NUMBER_VAL(a + b);
+        case TOKEN_SLASH:
+            if (b == 0) {
+                runtimeError(TOKEN_AT(expr->as.binary.oper), "Division by zero.");
+                return NIL_VAL;
+            }
+            return NUMBER_VAL(a / b);
+        default:
+            runtimeError(TOKEN_AT(expr->as.binary.oper), "Interpreter error: Unknown binary op.");
+            return NIL_VAL;
+    }
+}
+
+// --- Conditions ---
+// can and keep doing only need a yes or no. comparisons and logicals are
+// answered as a C bool here, without building a BOOL_VAL to unwrap again.
+// and/or just become && and ||. anything else goes through evaluateExpr.
+
+static bool isComparison(TokenType type) {
+    switch (type) {
+        case TOKEN_GREATER:
+        case TOKEN_GREATER_EQUAL:
+        case TOKEN_LESS:
+        case TOKEN_LESS_EQUAL:
+        case TOKEN_BANG_EQUAL:
+        case TOKEN_EQUAL_EQUAL:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool compareNumbers(TokenType type, double a, double b) {
+    switch (type) {
+        case TOKEN_GREATER:
+            return a > b;
+        case TOKEN_GREATER_EQUAL:
+            return a >= b;
+        case TOKEN_LESS:
+            return a < b;
+        case TOKEN_LESS_EQUAL:
+            return a <= b;
+        case TOKEN_BANG_EQUAL:
+            return a != b;
+        default:
+            return a == b;
+    }
+}
+
+// after a runtime error the result means nothing, callers stop anyway
+static bool evaluateCondition(Expr* expr) {
+    if (expr == NULL || runtimeErrorOccurred) return false;
+
+    switch (expr->type) {
+        case EXPR_GROUPING:
+            return evaluateCondition(AS_EXPR(expr->as.grouping.expression));
+        case EXPR_LOGICAL:
+            if (TOKEN_AT(expr->as.logical.oper)->type == TOKEN_AND) {
+                return evaluateCondition(AS_EXPR(expr->as.logical.left)) && evaluateCondition(AS_EXPR(expr->as.logical.right));
+            }
+            if (TOKEN_AT(expr->as.logical.oper)->type == TOKEN_OR) {
+                return evaluateCondition(AS_EXPR(expr->as.logical.left)) || evaluateCondition(AS_EXPR(expr->as.logical.right));
+            }
+            break;
+        case EXPR_UNARY:
+            if (TOKEN_AT(expr->as.unary.oper)->type == TOKEN_BANG) {
+                return !evaluateCondition(AS_EXPR(expr->as.unary.right));
+            }
+            break;
+        case EXPR_BINARY: {
+            if (!expr->as.binary.generic) {
+                specializeBinary(expr);
+                if (expr->type != EXPR_BINARY) return evaluateCondition(expr);
+            }
+
+            TokenType type = TOKEN_AT(expr->as.binary.oper)->type;
+            if (!isComparison(type)) break;
+
+            Value left = evaluateExpr(AS_EXPR(expr->as.binary.left));
+            if (runtimeErrorOccurred) return false;
+            Value right = evaluateExpr(AS_EXPR(expr->as.binary.right));
+            if (runtimeErrorOccurred) return false;
+
+            if (type == TOKEN_EQUAL_EQUAL) return valuesEqual(left, right);
+            if (type == TOKEN_BANG_EQUAL) return !valuesEqual(left, right);
+            checkNumberOperands(TOKEN_AT(expr->as.binary.oper), left, right);
+            if (runtimeErrorOccurred) return false;
+            return compareNumbers(type, AS_NUMBER(left), AS_NUMBER(right));
+        }
+        case EXPR_BINARY_VAR_CONST:
+        case EXPR_BINARY_CONST_VAR:
+        case EXPR_BINARY_VAR_VAR: {
+            double a, b;
+            // a failed guard deoptimizes in evaluateExpr below
+            if (isComparison(TOKEN_AT(expr->as.binary.oper)->type) && specializedOperands(expr, &a, &b)) {
+                return compareNumbers(TOKEN_AT(expr->as.binary.oper)->type, a, b);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    return isTruthy(evaluateExpr(expr));
+}
+
 static Value evaluateExpr(Expr* expr) {
     if (expr == NULL || runtimeErrorOccurred) return NIL_VAL;
 
@@ -311,9 +708,9 @@ static Value evaluateExpr(Expr* expr) {
             }
         }
         case EXPR_LOGICAL: {
-            Value left = evaluateExpr(expr->as.logical.left);
+            Value left = evaluateExpr(AS_EXPR(expr->as.logical.left));
             if (runtimeErrorOccurred) return NIL_VAL;
-            switch (expr->as.logical.oper.type) {
+            switch (TOKEN_AT(expr->as.logical.oper)->type) {
                 case TOKEN_OR:
                     if (isTruthy(left)) return left;
                     break;
@@ -321,50 +718,94 @@ static Value evaluateExpr(Expr* expr) {
                     if (!isTruthy(left)) return left;
                     break;
                 default:
-                    runtimeError(&expr->as.logical.oper, "Interpreter error: Unknown logical op.");
+                    runtimeError(TOKEN_AT(expr->as.logical.oper), "Interpreter error: Unknown logical op.");
                     return NIL_VAL;
             }
-            return evaluateExpr(expr->as.logical.right);
+            return evaluateExpr(AS_EXPR(expr->as.logical.right));
         }
         case EXPR_GROUPING: {
-            return evaluateExpr(expr->as.grouping.expression);
+            return evaluateExpr(AS_EXPR(expr->as.grouping.expression));
         }
         case EXPR_UNARY: {
-            Value right = evaluateExpr(expr->as.unary.right);
+            Value right = evaluateExpr(AS_EXPR(expr->as.unary.right));
             if (runtimeErrorOccurred) return NIL_VAL;
-            switch (expr->as.unary.oper.type) {
+            switch (TOKEN_AT(expr->as.unary.oper)->type) {
                 case TOKEN_BANG:
                     return BOOL_VAL(!isTruthy(right));
                 case TOKEN_MINUS:
-                    checkNumberOperand(&expr->as.unary.oper, right);
+                    if (AS_EXPR(expr->as.unary.right)->staticType == STATIC_NUMBER) {
+                        return NUMBER_VAL(-AS_NUMBER(right));
+                    }
+                    checkNumberOperand(TOKEN_AT(expr->as.unary.oper), right);
                     if (runtimeErrorOccurred) return NIL_VAL;
                     return NUMBER_VAL(-AS_NUMBER(right));
                 default:
-                    runtimeError(&expr->as.unary.oper,
+                    runtimeError(TOKEN_AT(expr->as.unary.oper),
                                  "Interpreter error: Unknown unary op.");
                     return NIL_VAL;
             }
         }
+        case EXPR_BINARY_VAR_CONST:
+        case EXPR_BINARY_CONST_VAR:
+        case EXPR_BINARY_VAR_VAR: {
+            double a, b;
+            if (!specializedOperands(expr, &a, &b)) return deoptimizeBinary(expr);
+            return numberBinary(expr, a, b);
+        }
         case EXPR_BINARY: {
-            Value left = evaluateExpr(expr->as.binary.left);
+            if (!expr->as.binary.generic) {
+                specializeBinary(expr);
+                if (expr->type != EXPR_BINARY) return evaluateExpr(expr);
+            }
+
+            Value left = evaluateExpr(AS_EXPR(expr->as.binary.left));
             if (runtimeErrorOccurred) return NIL_VAL;
-            Value right = evaluateExpr(expr->as.binary.right);
+            Value right = evaluateExpr(AS_EXPR(expr->as.binary.right));
             if (runtimeErrorOccurred) return NIL_VAL;
-            switch (expr->as.binary.oper.type) {
+
+            // type inference proved both operands are numbers, skip the checks
+            if (AS_EXPR(expr->as.binary.left)->staticType == STATIC_NUMBER && AS_EXPR(expr->as.binary.right)->staticType == STATIC_NUMBER) {
+                double a = AS_NUMBER(left);
+                double b = AS_NUMBER(right);
+                switch (TOKEN_AT(expr->as.binary.oper)->type) {
+                    case TOKEN_GREATER:
+                        return BOOL_VAL(a > b);
+                    case TOKEN_GREATER_EQUAL:
+                        return BOOL_VAL(a >= b);
+                    case TOKEN_LESS:
+                        return BOOL_VAL(a < b);
+                    case TOKEN_LESS_EQUAL:
+                        return BOOL_VAL(a <= b);
+                    case TOKEN_BANG_EQUAL:
+                        return BOOL_VAL(a != b);
+                    case TOKEN_EQUAL_EQUAL:
+                        return BOOL_VAL(a == b);
+                    case TOKEN_MINUS:
+                        return NUMBER_VAL(a - b);
+                    case TOKEN_STAR:
+                        return NUMBER_VAL(a * b);
+                    case TOKEN_PLUS:
+                        return NUMBER_VAL(a + b);
+                    default:
+                        break; // division still has to check for zero
+                }
+            }
+
+            switch (TOKEN_AT(expr->as.binary.oper)->type) {
                 case TOKEN_GREATER:
-                    checkNumberOperands(&expr->as.binary.oper, left, right);
+                    checkNumberOperands(TOKEN_AT(expr->as.binary.oper), left, right);
                     if (runtimeErrorOccurred) return NIL_VAL;
                     return BOOL_VAL(AS_NUMBER(left) > AS_NUMBER(right));
                 case TOKEN_GREATER_EQUAL:
-                    checkNumberOperands(&expr->as.binary.oper, left, right);
+                    checkNumberOperands(TOKEN_AT(expr->as.binary.oper), left, right);
                     if (runtimeErrorOccurred) return NIL_VAL;
                     return BOOL_VAL(AS_NUMBER(left) >= AS_NUMBER(right));
                 case TOKEN_LESS:
-                    checkNumberOperands(&expr->as.binary.oper, left, right);
+                    checkNumberOperands(TOKEN_AT(expr->as.binary.oper), left, right);
                     if (runtimeErrorOccurred) return NIL_VAL;
                     return BOOL_VAL(AS_NUMBER(left) < AS_NUMBER(right));
                 case TOKEN_LESS_EQUAL:
-                    checkNumberOperands(&expr->as.binary.oper, left, right);
+                    checkNumberOperands(TOKEN_AT(expr->as.binary.oper), left, right);
                     if (runtimeErrorOccurred) return NIL_VAL;
                     return BOOL_VAL(AS_NUMBER(left) <= AS_NUMBER(right));
                 case TOKEN_BANG_EQUAL:
@@ -372,98 +813,36 @@ static Value evaluateExpr(Expr* expr) {
                 case TOKEN_EQUAL_EQUAL:
                     return BOOL_VAL(valuesEqual(left, right));
                 case TOKEN_MINUS:
-                    checkNumberOperands(&expr->as.binary.oper, left, right);
+                    checkNumberOperands(TOKEN_AT(expr->as.binary.oper), left, right);
                     if (runtimeErrorOccurred) return NIL_VAL;
                     return NUMBER_VAL(AS_NUMBER(left) - AS_NUMBER(right));
                 case TOKEN_STAR:
-                    checkNumberOperands(&expr->as.binary.oper, left, right);
+                    checkNumberOperands(TOKEN_AT(expr->as.binary.oper), left, right);
                     if (runtimeErrorOccurred) return NIL_VAL;
                     return NUMBER_VAL(AS_NUMBER(left) * AS_NUMBER(right));
                 case TOKEN_SLASH:
-                    checkNumberOperands(&expr->as.binary.oper, left, right);
+                    checkNumberOperands(TOKEN_AT(expr->as.binary.oper), left, right);
                     if (runtimeErrorOccurred) return NIL_VAL;
                     if (AS_NUMBER(right) == 0) {
-                        runtimeError(&expr->as.binary.oper,
+                        runtimeError(TOKEN_AT(expr->as.binary.oper),
                                      "Division by zero.");
                         return NIL_VAL;
                     }
                     return NUMBER_VAL(AS_NUMBER(left) / AS_NUMBER(right));
                 case TOKEN_PLUS:
-                    if (IS_NUMBER(left) && IS_NUMBER(right)) {
-                        return NUMBER_VAL(AS_NUMBER(left) + AS_NUMBER(right));
-                    }
-
-                    // string concatenation
-                    if (IS_STRING(left) && IS_STRING(right)) {
-                        int leftLength = AS_STRING(left)->length;
-                        int rightLength = AS_STRING(right)->length;
-                        int totalLength = leftLength + rightLength;
-                        char* result = ALLOCATE(char, totalLength + 1);
-                        if (result == NULL) {
-                            runtimeError(
-                                NULL, "Memory error creating string result.");
-                            return NIL_VAL;
-                        }
-                        strncpy(result, AS_STRING(left)->chars, leftLength);
-                        strncpy(result + leftLength, AS_STRING(right)->chars,
-                                rightLength);
-                        result[totalLength] = '\0';
-                        return OBJ_VAL(copyString(result, totalLength));
-                    }
-                    runtimeError(
-                        &expr->as.binary.oper,
-                        "Operands must be two numbers or two strings.");
-                    return NIL_VAL;
+                    return addValues(TOKEN_AT(expr->as.binary.oper), left, right);
                 default:
-                    runtimeError(&expr->as.binary.oper,
+                    runtimeError(TOKEN_AT(expr->as.binary.oper),
                                  "Interpreter error: Unknown binary op.");
                     return NIL_VAL;
             }
         }
-        case EXPR_VARIABLE: {
-            Value value;
-            if (environmentGet(currentEnvironment, &expr->as.variable.name,
-                               &value)) {
-                return value;
-            } else {
-                char* name = malloc(expr->as.variable.name.length + 1);
-                if (name) {
-                    strncpy(name, expr->as.variable.name.start,
-                            expr->as.variable.name.length);
-                    name[expr->as.variable.name.length] = '\0';
-                    runtimeError(&expr->as.variable.name,
-                                 "Undefined variable '%s'.", name);
-                    free(name);
-                } else {
-                    runtimeError(&expr->as.variable.name,
-                                 "Undefined variable (mem err).");
-                }
-                return NIL_VAL;
-            }
-        }
+        case EXPR_VARIABLE:
+            return readVariable(expr);
         case EXPR_ASSIGN: {
-            Value value = evaluateExpr(expr->as.assign.value);
+            Value value = evaluateExpr(AS_EXPR(expr->as.assign.value));
             if (runtimeErrorOccurred) return NIL_VAL;
-            if (environmentAssign(currentEnvironment, &expr->as.assign.name,
-                                  value)) {
-                return value;
-            } else {
-                char* name = malloc(expr->as.assign.name.length + 1);
-                if (name) {
-                    strncpy(name, expr->as.assign.name.start,
-                            expr->as.assign.name.length);
-                    name[expr->as.assign.name.length] = '\0';
-                    runtimeError(&expr->as.assign.name,
-                                 "Undefined variable '%s' for assignment.",
-                                 name);
-                    free(name);
-                } else {
-                    runtimeError(
-                        &expr->as.assign.name,
-                        "Undefined variable for assignment (mem err).");
-                }
-                return NIL_VAL;
-            }
+            return assignVariable(expr, value);
         }
         case EXPR_CALL:
             return visitCallExpr(expr);
@@ -479,23 +858,30 @@ static Value evaluateExpr(Expr* expr) {
 }
 
 static Value visitCallExpr(Expr* expr) {
-    Value callee = evaluateExpr(expr->as.call.callee);
+    Value callee = evaluateExpr(AS_EXPR(expr->as.call.callee));
     if (runtimeErrorOccurred) return NIL_VAL;
 
     Value* arguments = malloc(sizeof(Value) * expr->as.call.arg_count);
     if (arguments == NULL && expr->as.call.arg_count > 0) {
-        runtimeError(&expr->as.call.paren, "Memory error evaluating function arguments.");
+        runtimeError(TOKEN_AT(expr->as.call.paren), "Memory error evaluating function arguments.");
         return NIL_VAL;
     }
 
     for (int i = 0; i < expr->as.call.arg_count; i++) {
-        arguments[i] = evaluateExpr(expr->as.call.arguments[i]);
+        arguments[i] = evaluateExpr(CALL_ARGUMENT(&expr->as.call, i));
         if (runtimeErrorOccurred) {
             free(arguments);
             return NIL_VAL;
         }
     }
 
+    Value result = callValue(expr, callee, arguments);
+    free(arguments);
+    return result;
+}
+
+// arguments were already evaluated, in order. the caller owns them.
+Value callValue(Expr* expr, Value callee, Value* arguments) {
     if (IS_OBJ(callee) && OBJ_TYPE(callee) == OBJ_FUNCTION) {
         ObjFunction* function = (ObjFunction*)AS_OBJ(callee);
 
@@ -503,14 +889,14 @@ static Value visitCallExpr(Expr* expr) {
             char error[100];
             sprintf(error, "Eh hello, suppose to get %d argument(s) but you give %d only leh.",
                     function->arity, expr->as.call.arg_count);
-            runtimeError(&expr->as.call.paren, error);
-            free(arguments);
+            runtimeError(TOKEN_AT(expr->as.call.paren), error);
+            return NIL_VAL;
+        }
+        if (!checkArgumentTypes(expr, function, arguments)) {
             return NIL_VAL;
         }
 
-        Value result = callFunction(function, arguments, expr->as.call.arg_count);
-        free(arguments);
-        return result;
+        return callFunction(function, arguments, expr->as.call.arg_count);
     } else if (IS_OBJ(callee) && OBJ_TYPE(callee) == OBJ_NATIVE) {
         ObjNative* native = (ObjNative*)AS_OBJ(callee);
 
@@ -518,17 +904,13 @@ static Value visitCallExpr(Expr* expr) {
             char error[100];
             sprintf(error, "Eh hello, suppose to get %d argument(s) but you give %d only leh.",
                     native->arity, expr->as.call.arg_count);
-            runtimeError(&expr->as.call.paren, error);
-            free(arguments);
+            runtimeError(TOKEN_AT(expr->as.call.paren), error);
             return NIL_VAL;
         }
 
-        Value result = native->function(NULL, expr->as.call.arg_count, arguments);
-        free(arguments);
-        return result;
+        return native->function(NULL, expr->as.call.arg_count, arguments);
     } else {
-        runtimeError(&expr->as.call.paren, "Can only call functions.");
-        free(arguments);
+        runtimeError(TOKEN_AT(expr->as.call.paren), "Can only call functions.");
         return NIL_VAL;
     }
 }
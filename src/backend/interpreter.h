@@ -5,6 +5,7 @@
 #include "../ast/stmt.h"
 #include "../runtime/object.h"
 #include "../frontend/scanner.h"
+#include "environment.h"
 #include <stdbool.h>
 
 // Structure to hold runtime error info (optional but good practice)
@@ -19,6 +20,28 @@ void initInterpreter();
 // Free interpreter resources (frees global environment)
 void freeInterpreter();
 
+// Cache results of functions the optimizer marked pure (--memoize)
+void setMemoization(bool enabled);
+
+// How programs are executed (--engine=)
+typedef enum {
+    ENGINE_TREE, // walk the AST directly
+    ENGINE_CLOSURE // compile the AST into trees of specialized handlers first (closure.c)
+} Engine;
+
+void setEngine(Engine engine);
+
+// Function bodies the parser skipped (see parseFunctionBody) are loaded on
+// the first call: parsed, resolved and optimized by the loader, which reports
+// what is wrong and returns false if it can't. set by whoever ran the front end.
+typedef bool (*BodyLoader)(Stmt* function);
+
+void setBodyLoader(BodyLoader loader);
+
+// make sure the body of a function declaration is there. false after an
+// error, which also stops the program.
+bool loadFunctionBody(Stmt* function);
+
 // Interpret a list of statements
 // Returns true on success, false if a runtime error occurred.
 void interpretStatements(StmtList* statements);
@@ -33,4 +56,39 @@ bool hadRuntimeError();
 // Reset the runtime error flag (e.g., for REPL use)
 void resetRuntimeError();
 
+// --- Engine Internals ---
+// state and semantics shared by the tree-walker and the closure engine, so
+// both behave exactly alike. not meant for anything outside src/backend.
+
+extern Environment* globalEnvironment;
+extern Environment* currentEnvironment;
+extern ObjFunction* currentFunction; // the one running, NULL at the top level
+extern bool runtimeErrorOccurred;
+
+// how a statement finished, passed up until a loop or call takes it. the
+// value of a `return` waits in return_value meanwhile.
+typedef enum {
+    COMPLETION_NORMAL,
+    COMPLETION_RETURN,
+    COMPLETION_BREAK,
+    COMPLETION_CONTINUE
+} Completion;
+
+extern Value return_value;
+
+bool isTruthy(Value value);
+void checkNumberOperand(Token* operatorToken, Value operand);
+void checkNumberOperands(Token* operatorToken, Value left, Value right);
+bool hasType(Value value, StaticType type);
+const char* valueTypeName(Value value);
+
+Value* findVariable(Expr* variable); // NULL if not defined, nothing reported
+Value readVariable(Expr* variable);
+Value assignVariable(Expr* assign, Value value); // value already evaluated
+Value addValues(Token* operatorToken, Value left, Value right);
+Value callValue(Expr* call, Value callee, Value* arguments);
+void defineVariable(Stmt* var, Value value); // initializer already evaluated
+void defineFunction(Stmt* function);
+void defineAhead(Environment* scope, StmtList* statements); // a captured scope, before it runs
+
 #endif 
\ No newline at end of file
@@ -0,0 +1,213 @@
+#include "analysis.h"
+#include "../runtime/memory.h"
+#include <stdlib.h>
+#include <string.h>
+
+// --- Name Sets ---
+void initNameSet(NameSet* set) {
+    set->names = NULL;
+    set->count = 0;
+    set->capacity = 0;
+    set->positions = NULL;
+    set->positionCapacity = 0;
+}
+
+void freeNameSet(NameSet* set) {
+    FREE_ARRAY(Token, set->names, set->capacity);
+    FREE_ARRAY(int, set->positions, set->positionCapacity);
+    initNameSet(set);
+}
+
+int nameSetFind(NameSet* set, Token* name) {
+    if (set->positions == NULL) {
+        for (int i = 0; i < set->count; i++) {
+            if (set->names[i].symbol == name->symbol) {
+                return i;
+            }
+        }
+        return -1;
+    }
+    if (name->symbol >= set->positionCapacity) return -1;
+    int position = set->positions[name->symbol];
+    if (position >= 0 && position < set->count && set->names[position].symbol == name->symbol) return position;
+    return -1;
+}
+
+bool nameSetContains(NameSet* set, Token* name) {
+    return nameSetFind(set, name) >= 0;
+}
+
+// room for symbol in positions. the new part is left as it comes, see NameSet
+static void growPositions(NameSet* set, SymbolId symbol) {
+    SymbolId capacity = symbolLimit();
+    if (capacity < 2 * set->positionCapacity) capacity = 2 * set->positionCapacity;
+    if (capacity <= symbol) capacity = symbol + 1;
+    set->positions = GROW_ARRAY(int, set->positions, set->positionCapacity, capacity);
+    set->positionCapacity = capacity;
+}
+
+void nameSetAdd(NameSet* set, Token name) {
+    if (nameSetContains(set, &name)) return;
+    if (set->count >= set->capacity) {
+        int oldCapacity = set->capacity;
+        set->capacity = GROW_CAPACITY(oldCapacity);
+        set->names = GROW_ARRAY(Token, set->names, oldCapacity, set->capacity);
+    }
+    set->names[set->count] = name;
+
+    if (set->positions == NULL && set->count >= NAME_SET_SCAN) {
+        growPositions(set, name.symbol);
+        for (int i = 0; i < set->count; i++) {
+            set->positions[set->names[i].symbol] = i;
+        }
+    }
+    if (set->positions != NULL) {
+        if (name.symbol >= set->positionCapacity) growPositions(set, name.symbol);
+        set->positions[name.symbol] = set->count;
+    }
+    set->count++;
+}
+
+// --- Effects ---
+void initEffects(Effects* effects) {
+    initNameSet(&effects->assigned);
+    initNameSet(&effects->declared);
+    effects->hasCall = false;
+}
+
+void freeEffects(Effects* effects) {
+    freeNameSet(&effects->assigned);
+    freeNameSet(&effects->declared);
+}
+
+void scanExpr(Expr* expr, Effects* effects) {
+    if (expr == NULL) return;
+    switch (expr->type) {
+        case EXPR_ASSIGN:
+            nameSetAdd(&effects->assigned, *TOKEN_AT(expr->as.assign.name));
+            scanExpr(AS_EXPR(expr->as.assign.value), effects);
+            break;
+        case EXPR_CALL:
+            effects->hasCall = true;
+            scanExpr(AS_EXPR(expr->as.call.callee), effects);
+            for (int i = 0; i < expr->as.call.arg_count; i++) {
+                scanExpr(CALL_ARGUMENT(&expr->as.call, i), effects);
+            }
+            break;
+        case EXPR_BINARY:
+            scanExpr(AS_EXPR(expr->as.binary.left), effects);
+            scanExpr(AS_EXPR(expr->as.binary.right), effects);
+            break;
+        case EXPR_LOGICAL:
+            scanExpr(AS_EXPR(expr->as.logical.left), effects);
+            scanExpr(AS_EXPR(expr->as.logical.right), effects);
+            break;
+        case EXPR_UNARY:
+            scanExpr(AS_EXPR(expr->as.unary.right), effects);
+            break;
+        case EXPR_GROUPING:
+            scanExpr(AS_EXPR(expr->as.grouping.expression), effects);
+            break;
+        default:
+            break;
+    }
+}
+
+// a body the parser skipped only comes with what it assigns
+static void scanBody(FunctionStmt* function, Effects* effects) {
+    for (int i = 0; i < function->lazy.assignedCount; i++) {
+        nameSetAdd(&effects->assigned, function->lazy.assigned[i]);
+    }
+    scanStmtList(AS_STMT_LIST(function->body), effects);
+}
+
+void scanStmtList(StmtList* list, Effects* effects) {
+    for (int i = 0; i < STMT_COUNT(list); i++) {
+        scanStmt(LIST_STMT(list, i), effects);
+    }
+}
+
+void scanStmt(Stmt* stmt, Effects* effects) {
+    if (stmt == NULL) return;
+    switch (stmt->type) {
+        case STMT_EXPRESSION:
+            scanExpr(AS_EXPR(stmt->as.expression.expression), effects);
+            break;
+        case STMT_PRINT:
+            scanExpr(AS_EXPR(stmt->as.print.expression), effects);
+            break;
+        case STMT_VAR:
+            nameSetAdd(&effects->declared, *TOKEN_AT(stmt->as.var.name));
+            scanExpr(AS_EXPR(stmt->as.var.initializer), effects);
+            break;
+        case STMT_BLOCK:
+            scanStmtList(AS_STMT_LIST(stmt->as.block.statements), effects);
+            break;
+        case STMT_IF:
+            scanExpr(AS_EXPR(stmt->as.ifStmt.condition), effects);
+            scanStmt(AS_STMT(stmt->as.ifStmt.thenBranch), effects);
+            scanStmt(AS_STMT(stmt->as.ifStmt.elseBranch), effects);
+            break;
+        case STMT_WHILE:
+            scanExpr(AS_EXPR(stmt->as.whileStmt.condition), effects);
+            scanStmt(AS_STMT(stmt->as.whileStmt.body), effects);
+            scanExpr(AS_EXPR(stmt->as.whileStmt.increment), effects);
+            break;
+        case STMT_FUNCTION:
+            nameSetAdd(&effects->declared, *TOKEN_AT(AS_FUNCTION_STMT(stmt)->name));
+            for (int i = 0; i < AS_FUNCTION_STMT(stmt)->param_count; i++) {
+                nameSetAdd(&effects->declared, *TOKEN_AT(AS_FUNCTION_STMT(stmt)->params + i));
+            }
+            scanBody(AS_FUNCTION_STMT(stmt), effects);
+            break;
+        case STMT_RETURN:
+            scanExpr(AS_EXPR(stmt->as.return_stmt.value), effects);
+            break;
+        case STMT_BREAK:
+        case STMT_CONTINUE:
+            break;
+    }
+}
+
+// record every name some function body assigns to
+void scanFunctionBodies(Stmt* stmt, Effects* effects) {
+    if (stmt == NULL) return;
+    switch (stmt->type) {
+        case STMT_FUNCTION:
+            scanBody(AS_FUNCTION_STMT(stmt), effects);
+            break;
+        case STMT_BLOCK: {
+            StmtList* list = AS_STMT_LIST(stmt->as.block.statements);
+            for (int i = 0; i < STMT_COUNT(list); i++) {
+                scanFunctionBodies(LIST_STMT(list, i), effects);
+            }
+            break;
+        }
+        case STMT_IF:
+            scanFunctionBodies(AS_STMT(stmt->as.ifStmt.thenBranch), effects);
+            scanFunctionBodies(AS_STMT(stmt->as.ifStmt.elseBranch), effects);
+            break;
+        case STMT_WHILE:
+            scanFunctionBodies(AS_STMT(stmt->as.whileStmt.body), effects);
+            break;
+        default:
+            break;
+    }
+}
+
+// --- Prelude ---
+
+static StmtList* prelude = NULL;
+
+void setPrelude(StmtList* functions) {
+    prelude = functions;
+}
+
+void scanProgramFunctions(StmtList* statements, Effects* effects) {
+    for (int i = 0; i < STMT_COUNT(prelude); i++) {
+        scanFunctionBodies(LIST_STMT(prelude, i), effects);
+    }
+    for (int i = 0; i < STMT_COUNT(statements); i++) {
+        scanFunctionBodies(LIST_STMT(statements, i), effects);
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef sg_analysis_h
+#define sg_analysis_h
+
+#include "../ast/expr.h"
+#include "../ast/stmt.h"
+#include <stdbool.h>
+
+// helpers shared by the passes that run between the resolver and the interpreter
+
+// --- Name Sets ---
+// sets of identifier tokens, in the order they were added. small ones are
+// scanned. past NAME_SET_SCAN names a set also keeps where each symbol sits
+// in names, so a lookup costs the same however many names a program has.
+// dropping the names added since some count (count = mark) is all it takes
+// to leave scopes.
+#define NAME_SET_SCAN 8
+
+typedef struct {
+    Token* names;
+    int count;
+    int capacity;
+    // by symbol, a position in names. only trusted where names agrees, so
+    // it is never cleared (the sparse sets of Briggs and Torczon)
+    int* positions;
+    SymbolId positionCapacity;
+} NameSet;
+
+void initNameSet(NameSet* set);
+void freeNameSet(NameSet* set);
+bool nameSetContains(NameSet* set, Token* name);
+int nameSetFind(NameSet* set, Token* name); // position in names, -1 if not there
+void nameSetAdd(NameSet* set, Token name);
+
+// --- Effects ---
+// what a piece of code can do to the variables around it
+typedef struct {
+    NameSet assigned; // targets of '=' anywhere inside
+    NameSet declared; // variables, functions and parameters introduced inside
+    bool hasCall;
+} Effects;
+
+void initEffects(Effects* effects);
+void freeEffects(Effects* effects);
+
+// accumulate the effects of code, including nested function bodies
+void scanExpr(Expr* expr, Effects* effects);
+void scanStmt(Stmt* stmt, Effects* effects);
+void scanStmtList(StmtList* list, Effects* effects);
+
+// accumulate the effects of every function body declared in stmt. those are
+// the names any call may change.
+void scanFunctionBodies(Stmt* stmt, Effects* effects);
+
+// --- Prelude ---
+// functions that already exist when the program starts, restored from a heap
+// image (--image). a call in the program may reach them, so what their bodies
+// assign counts too when asking what any call may change.
+void setPrelude(StmtList* functions);
+
+// scanFunctionBodies over every statement of the program and the prelude
+void scanProgramFunctions(StmtList* statements, Effects* effects);
+
+#endif
@@ -0,0 +1,674 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../ast/pool.h"
+#include "../runtime/memory.h"
+#include "cache.h"
+#include "source.h"
+
+static const char CACHE_MAGIC[4] = {'S', 'G', 'C', '\0'};
+
+// header, in native byte order. another byte order reads as another version.
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint64_t sourceHash;
+    uint64_t sourceLength;
+    uint64_t payloadHash; // of everything after the header, catches damage
+    uint32_t lazyBodies; // whether some function bodies were left unparsed
+} CacheHeader;
+
+#define NULL_NODE 0xFF // tag of a missing expression or statement
+#define INLINE_TOKEN UINT32_MAX // token text follows instead of a source offset
+
+uint64_t hashBytes(const void* bytes, size_t length) {
+    const uint8_t* at = bytes;
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= at[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+char* cachePathFor(const char* path) {
+    size_t length = strlen(path);
+    bool sg = length > 3 && strcmp(path + length - 3, ".sg") == 0;
+    const char* suffix = sg ? "c" : ".sgc";
+    char* cachePath = ALLOCATE(char, length + strlen(suffix) + 1);
+    memcpy(cachePath, path, length);
+    strcpy(cachePath + length, suffix);
+    return cachePath;
+}
+
+// --- Writing ---
+
+typedef struct {
+    uint8_t* bytes;
+    size_t count;
+    size_t capacity;
+    const char* source;
+    size_t sourceLength;
+    bool failed;
+} Writer;
+
+static void writeBytes(Writer* writer, const void* bytes, size_t size) {
+    if (writer->capacity - writer->count < size) {
+        size_t capacity = writer->capacity;
+        while (capacity - writer->count < size) {
+            capacity = GROW_CAPACITY(capacity);
+        }
+        writer->bytes = GROW_ARRAY(uint8_t, writer->bytes, writer->capacity, capacity);
+        writer->capacity = capacity;
+    }
+    memcpy(writer->bytes + writer->count, bytes, size);
+    writer->count += size;
+}
+
+static void writeByte(Writer* writer, uint8_t value) {
+    writeBytes(writer, &value, 1);
+}
+
+static void writeInt(Writer* writer, int32_t value) {
+    writeBytes(writer, &value, sizeof(value));
+}
+
+static void writeOffset(Writer* writer, uint32_t offset) {
+    writeBytes(writer, &offset, sizeof(offset));
+}
+
+static void writeToken(Writer* writer, Token* token) {
+    writeInt(writer, token->type);
+    writeInt(writer, token->line);
+    writeInt(writer, (int32_t)token->length);
+
+    // optimizer temporaries have names of their own
+    bool inSource = token->start >= writer->source &&
+                    token->start + token->length <= writer->source + writer->sourceLength;
+    writeOffset(writer, inSource ? (uint32_t)(token->start - writer->source) : INLINE_TOKEN);
+    if (!inSource) writeBytes(writer, token->start, token->length);
+}
+
+static void writeStmtList(Writer* writer, StmtList* list);
+
+static void writeExpr(Writer* writer, Expr* expr) {
+    if (expr == NULL) {
+        writeByte(writer, NULL_NODE);
+        return;
+    }
+    writeByte(writer, (uint8_t)expr->type);
+    writeByte(writer, (uint8_t)expr->staticType);
+
+    switch (expr->type) {
+        case EXPR_ASSIGN:
+            writeToken(writer, TOKEN_AT(expr->as.assign.name));
+            writeExpr(writer, AS_EXPR(expr->as.assign.value));
+            writeInt(writer, expr->as.assign.upvalue);
+            break;
+        case EXPR_LOGICAL:
+            writeExpr(writer, AS_EXPR(expr->as.logical.left));
+            writeToken(writer, TOKEN_AT(expr->as.logical.oper));
+            writeExpr(writer, AS_EXPR(expr->as.logical.right));
+            break;
+        case EXPR_BINARY:
+        case EXPR_BINARY_VAR_CONST:
+        case EXPR_BINARY_CONST_VAR:
+        case EXPR_BINARY_VAR_VAR:
+            writeExpr(writer, AS_EXPR(expr->as.binary.left));
+            writeToken(writer, TOKEN_AT(expr->as.binary.oper));
+            writeExpr(writer, AS_EXPR(expr->as.binary.right));
+            break;
+        case EXPR_CALL:
+            writeExpr(writer, AS_EXPR(expr->as.call.callee));
+            writeToken(writer, TOKEN_AT(expr->as.call.paren));
+            writeInt(writer, expr->as.call.arg_count);
+            for (int i = 0; i < expr->as.call.arg_count; i++) {
+                writeExpr(writer, CALL_ARGUMENT(&expr->as.call, i));
+            }
+            break;
+        case EXPR_GROUPING:
+            writeExpr(writer, AS_EXPR(expr->as.grouping.expression));
+            break;
+        case EXPR_LITERAL:
+            writeInt(writer, expr->as.literal.type);
+            switch (expr->as.literal.type) {
+                case TOKEN_NUMBER:
+                    writeBytes(writer, &expr->as.literal.value.number, sizeof(double));
+                    break;
+                case TOKEN_STRING: {
+                    int32_t length = (int32_t)strlen(expr->as.literal.value.string);
+                    writeInt(writer, length);
+                    writeBytes(writer, expr->as.literal.value.string, length);
+                    break;
+                }
+                case TOKEN_CORRECT:
+                case TOKEN_WRONG:
+                    writeByte(writer, expr->as.literal.value.boolean);
+                    break;
+                default:
+                    break;
+            }
+            break;
+        case EXPR_UNARY:
+            writeToken(writer, TOKEN_AT(expr->as.unary.oper));
+            writeExpr(writer, AS_EXPR(expr->as.unary.right));
+            break;
+        case EXPR_VARIABLE:
+            writeToken(writer, TOKEN_AT(expr->as.variable.name));
+            writeByte(writer, expr->as.variable.global);
+            writeInt(writer, expr->as.variable.upvalue);
+            break;
+    }
+}
+
+static void writeStmt(Writer* writer, Stmt* stmt) {
+    if (stmt == NULL) {
+        writeByte(writer, NULL_NODE);
+        return;
+    }
+    writeByte(writer, (uint8_t)stmt->type);
+
+    switch (stmt->type) {
+        case STMT_EXPRESSION:
+            writeExpr(writer, AS_EXPR(stmt->as.expression.expression));
+            break;
+        case STMT_IF:
+            writeExpr(writer, AS_EXPR(stmt->as.ifStmt.condition));
+            writeStmt(writer, AS_STMT(stmt->as.ifStmt.thenBranch));
+            writeStmt(writer, AS_STMT(stmt->as.ifStmt.elseBranch));
+            break;
+        case STMT_PRINT:
+            writeExpr(writer, AS_EXPR(stmt->as.print.expression));
+            break;
+        case STMT_WHILE:
+            writeExpr(writer, AS_EXPR(stmt->as.whileStmt.condition));
+            writeStmt(writer, AS_STMT(stmt->as.whileStmt.body));
+            writeExpr(writer, AS_EXPR(stmt->as.whileStmt.increment));
+            break;
+        case STMT_VAR:
+            writeToken(writer, TOKEN_AT(stmt->as.var.name));
+            writeExpr(writer, AS_EXPR(stmt->as.var.initializer));
+            writeByte(writer, (uint8_t)stmt->as.var.declaredType);
+            break;
+        case STMT_BLOCK:
+            writeStmtList(writer, AS_STMT_LIST(stmt->as.block.statements));
+            writeInt(writer, stmt->as.block.localCount);
+            writeByte(writer, stmt->as.block.captured);
+            break;
+        case STMT_FUNCTION: {
+            FunctionStmt* function = AS_FUNCTION_STMT(stmt);
+            writeToken(writer, TOKEN_AT(function->name));
+            writeInt(writer, function->param_count);
+            for (int i = 0; i < function->param_count; i++) {
+                writeToken(writer, TOKEN_AT(function->params + i));
+            }
+            writeByte(writer, function->paramTypes != NULL);
+            if (function->paramTypes != NULL) {
+                for (int i = 0; i < function->param_count; i++) {
+                    writeByte(writer, (uint8_t)function->paramTypes[i]);
+                }
+            }
+            writeByte(writer, (uint8_t)function->returnType);
+            writeByte(writer, function->pure);
+            writeInt(writer, function->upvalueCount);
+            for (int i = 0; i < function->upvalueCount; i++) {
+                writeToken(writer, &function->upvalues[i].name);
+                writeByte(writer, function->upvalues[i].local);
+                writeInt(writer, function->upvalues[i].index);
+            }
+            writeInt(writer, function->localCount);
+            writeByte(writer, function->captured);
+
+            // a skipped body is saved as where it is in the source
+            LazyBody* lazy = &function->lazy;
+            writeByte(writer, lazy->start != NULL);
+            if (lazy->start == NULL) {
+                writeStmtList(writer, AS_STMT_LIST(function->body));
+                break;
+            }
+            if (lazy->start < writer->source || lazy->start >= writer->source + writer->sourceLength) {
+                writer->failed = true;
+                break;
+            }
+            writeOffset(writer, (uint32_t)(lazy->start - writer->source));
+            writeInt(writer, lazy->line);
+            writeInt(writer, lazy->assignedCount);
+            for (int i = 0; i < lazy->assignedCount; i++) {
+                writeToken(writer, &lazy->assigned[i]);
+            }
+            break;
+        }
+        case STMT_RETURN:
+            writeToken(writer, TOKEN_AT(stmt->as.return_stmt.keyword));
+            writeExpr(writer, AS_EXPR(stmt->as.return_stmt.value));
+            break;
+        case STMT_BREAK:
+        case STMT_CONTINUE:
+            writeToken(writer, TOKEN_AT(stmt->as.jump.keyword));
+            break;
+    }
+}
+
+static void writeStmtList(Writer* writer, StmtList* list) {
+    writeInt(writer, STMT_COUNT(list));
+    for (int i = 0; i < STMT_COUNT(list); i++) {
+        writeStmt(writer, LIST_STMT(list, i));
+    }
+}
+
+uint8_t* encodeStatements(StmtList* statements, const char* source, size_t sourceLength, size_t* length) {
+    if (sourceLength >= INLINE_TOKEN) return NULL;
+
+    Writer writer = {NULL, 0, 0, source, sourceLength, false};
+    writeStmtList(&writer, statements);
+    *length = writer.count;
+    if (writer.failed) {
+        FREE_ARRAY(uint8_t, writer.bytes, writer.capacity);
+        return NULL;
+    }
+    return writer.bytes;
+}
+
+void saveCache(const char* cachePath, const char* source, size_t sourceLength, StmtList* statements, bool lazyBodies) {
+    size_t length;
+    uint8_t* payload = statements == NULL ? NULL : encodeStatements(statements, source, sourceLength, &length);
+    if (payload == NULL) return;
+
+    CacheHeader header;
+    memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+    header.version = AST_FORMAT_VERSION;
+    header.sourceHash = hashBytes(source, sourceLength);
+    header.sourceLength = sourceLength;
+    header.payloadHash = hashBytes(payload, length);
+    header.lazyBodies = lazyBodies;
+
+    // write a temporary and rename it over, so a run reading the cache at the
+    // same time never sees half a file
+    size_t pathLength = strlen(cachePath);
+    char* temporary = ALLOCATE(char, pathLength + 5);
+    memcpy(temporary, cachePath, pathLength);
+    strcpy(temporary + pathLength, ".tmp");
+
+    FILE* file = fopen(temporary, "wb");
+    if (file != NULL) {
+        bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                       fwrite(payload, 1, length, file) == length;
+        written = fclose(file) == 0 && written;
+        if (!written || rename(temporary, cachePath) != 0) remove(temporary);
+    }
+
+    FREE(char, temporary);
+    FREE_ARRAY(uint8_t, payload, length);
+}
+
+// --- Reading ---
+// every read is bounds checked. once anything is off, failed is set, reads
+// return zeroes and the caller throws the lot away. nodes are linked in as
+// soon as they exist, so freeing a half-built tree frees everything.
+
+typedef struct {
+    const uint8_t* at;
+    const uint8_t* end;
+    const char* source;
+    size_t sourceLength;
+    bool failed;
+} Reader;
+
+static bool readBytes(Reader* reader, void* out, size_t size) {
+    if (reader->failed || (size_t)(reader->end - reader->at) < size) {
+        reader->failed = true;
+        memset(out, 0, size);
+        return false;
+    }
+    memcpy(out, reader->at, size);
+    reader->at += size;
+    return true;
+}
+
+static uint8_t readByte(Reader* reader) {
+    uint8_t value;
+    readBytes(reader, &value, 1);
+    return value;
+}
+
+static int32_t readInt(Reader* reader) {
+    int32_t value;
+    readBytes(reader, &value, sizeof(value));
+    return value;
+}
+
+// a count of things still to come, each at least one byte long
+static int32_t readCount(Reader* reader) {
+    int32_t count = readInt(reader);
+    if (count < 0 || count > reader->end - reader->at) {
+        reader->failed = true;
+        return 0;
+    }
+    return count;
+}
+
+static StaticType readStaticType(Reader* reader) {
+    uint8_t type = readByte(reader);
+    if (type > STATIC_NIL) reader->failed = true;
+    return reader->failed ? STATIC_UNKNOWN : (StaticType)type;
+}
+
+static Token readToken(Reader* reader) {
+    Token token;
+    int32_t type = readInt(reader);
+    token.line = readInt(reader);
+    int32_t length = readInt(reader);
+    uint32_t offset;
+    readBytes(reader, &offset, sizeof(offset));
+
+    token.type = type >= 0 && type <= TOKEN_LAH ? (TokenType)type : TOKEN_ERROR;
+    token.length = length < 0 ? 0 : (unsigned int)length;
+    token.start = "";
+    if (length < 0 || type != (int32_t)token.type) {
+        reader->failed = true;
+    } else if (offset != INLINE_TOKEN) {
+        if ((size_t)offset + token.length > reader->sourceLength) {
+            reader->failed = true;
+        } else {
+            token.start = reader->source + offset;
+        }
+    } else if ((size_t)(reader->end - reader->at) < token.length) {
+        reader->failed = true;
+    } else {
+        char* text = poolAllocate(token.length + 1);
+        readBytes(reader, text, token.length);
+        token.start = text;
+    }
+    if (reader->failed) {
+        token.start = "";
+        token.length = 0;
+    }
+    token.symbol = token.type == TOKEN_IDENTIFIER ? internSymbol(token.start, token.length) : NO_SYMBOL;
+    return token;
+}
+
+static StmtList* readStmtList(Reader* reader);
+
+// an upvalue index, or -1 for none
+static int readUpvalueIndex(Reader* reader) {
+    int32_t index = readInt(reader);
+    if (index < -1 || index > UINT16_MAX) reader->failed = true;
+    return reader->failed ? -1 : index;
+}
+
+// how many locals a scope declares. only sizes its frame, so a big one is
+// cut down rather than trusted.
+static int readLocalCount(Reader* reader) {
+    int32_t count = readInt(reader);
+    if (count < 0) reader->failed = true;
+    if (reader->failed) return 0;
+    return count > UINT16_MAX ? UINT16_MAX : count;
+}
+
+static Expr* readExpr(Reader* reader) {
+    uint8_t type = readByte(reader);
+    if (reader->failed || type == NULL_NODE) return NULL;
+    if (type > EXPR_BINARY_VAR_VAR) {
+        reader->failed = true;
+        return NULL;
+    }
+
+    Expr* expr = poolAllocate(sizeof(Expr));
+    expr->type = (ExprType)type;
+    expr->staticType = readStaticType(reader);
+
+    switch (expr->type) {
+        case EXPR_ASSIGN:
+            expr->as.assign.name = poolToken(readToken(reader));
+            expr->as.assign.value = nodeIndex(readExpr(reader));
+            expr->as.assign.upvalue = readUpvalueIndex(reader);
+            break;
+        case EXPR_LOGICAL:
+            expr->as.logical.left = nodeIndex(readExpr(reader));
+            expr->as.logical.oper = poolToken(readToken(reader));
+            expr->as.logical.right = nodeIndex(readExpr(reader));
+            break;
+        case EXPR_BINARY:
+        case EXPR_BINARY_VAR_CONST:
+        case EXPR_BINARY_CONST_VAR:
+        case EXPR_BINARY_VAR_VAR:
+            // specialization starts over, the shapes it saw may not hold
+            expr->type = EXPR_BINARY;
+            expr->as.binary.left = nodeIndex(readExpr(reader));
+            expr->as.binary.oper = poolToken(readToken(reader));
+            expr->as.binary.right = nodeIndex(readExpr(reader));
+            break;
+        case EXPR_CALL: {
+            expr->as.call.callee = nodeIndex(readExpr(reader));
+            expr->as.call.paren = poolToken(readToken(reader));
+            int32_t count = readCount(reader);
+            if (count == 0) break;
+            NodeIndex* arguments = poolAllocate(sizeof(NodeIndex) * count);
+            expr->as.call.arguments = nodeIndex(arguments);
+            // count up as arguments arrive, freeExpr frees that many
+            for (int i = 0; i < count && !reader->failed; i++) {
+                arguments[i] = nodeIndex(readExpr(reader));
+                expr->as.call.arg_count = i + 1;
+            }
+            break;
+        }
+        case EXPR_GROUPING:
+            expr->as.grouping.expression = nodeIndex(readExpr(reader));
+            break;
+        case EXPR_LITERAL: {
+            int32_t literal = readInt(reader);
+            switch (literal) {
+                case TOKEN_NUMBER:
+                    readBytes(reader, &expr->as.literal.value.number, sizeof(double));
+                    break;
+                case TOKEN_STRING: {
+                    int32_t length = readCount(reader);
+                    if (reader->failed) break;
+                    char* string = ALLOCATE(char, length + 1);
+                    readBytes(reader, string, length);
+                    string[length] = '\0';
+                    expr->as.literal.value.string = string;
+                    break;
+                }
+                case TOKEN_CORRECT:
+                case TOKEN_WRONG:
+                    expr->as.literal.value.boolean = readByte(reader) != 0;
+                    break;
+                case TOKEN_NIL:
+                    break;
+                default:
+                    reader->failed = true;
+                    break;
+            }
+            // set last, freeExpr only frees a string that is there
+            if (!reader->failed) expr->as.literal.type = (TokenType)literal;
+            break;
+        }
+        case EXPR_UNARY:
+            expr->as.unary.oper = poolToken(readToken(reader));
+            expr->as.unary.right = nodeIndex(readExpr(reader));
+            break;
+        case EXPR_VARIABLE: {
+            expr->as.variable.name = poolToken(readToken(reader));
+            uint8_t global = readByte(reader);
+            if (global > 1) reader->failed = true;
+            expr->as.variable.global = global == 1;
+            expr->as.variable.slot = -1;
+            expr->as.variable.upvalue = readUpvalueIndex(reader);
+            break;
+        }
+    }
+    return expr;
+}
+
+static Stmt* readStmt(Reader* reader) {
+    uint8_t type = readByte(reader);
+    if (reader->failed || type == NULL_NODE) return NULL;
+    if (type > STMT_CONTINUE) {
+        reader->failed = true;
+        return NULL;
+    }
+
+    Stmt* stmt = poolAllocate(sizeof(Stmt));
+    stmt->type = (StmtType)type;
+
+    switch (stmt->type) {
+        case STMT_EXPRESSION:
+            stmt->as.expression.expression = nodeIndex(readExpr(reader));
+            break;
+        case STMT_IF:
+            stmt->as.ifStmt.condition = nodeIndex(readExpr(reader));
+            stmt->as.ifStmt.thenBranch = nodeIndex(readStmt(reader));
+            stmt->as.ifStmt.elseBranch = nodeIndex(readStmt(reader));
+            break;
+        case STMT_PRINT:
+            stmt->as.print.expression = nodeIndex(readExpr(reader));
+            break;
+        case STMT_WHILE:
+            stmt->as.whileStmt.condition = nodeIndex(readExpr(reader));
+            stmt->as.whileStmt.body = nodeIndex(readStmt(reader));
+            stmt->as.whileStmt.increment = nodeIndex(readExpr(reader));
+            break;
+        case STMT_VAR:
+            stmt->as.var.name = poolToken(readToken(reader));
+            stmt->as.var.initializer = nodeIndex(readExpr(reader));
+            stmt->as.var.declaredType = readStaticType(reader);
+            break;
+        case STMT_BLOCK:
+            stmt->as.block.statements = nodeIndex(readStmtList(reader));
+            stmt->as.block.localCount = readLocalCount(reader);
+            stmt->as.block.captured = readByte(reader) != 0;
+            break;
+        case STMT_FUNCTION: {
+            FunctionStmt* function = poolAllocate(sizeof(FunctionStmt));
+            stmt->as.function = nodeIndex(function);
+            function->name = poolToken(readToken(reader));
+            int32_t count = readCount(reader);
+            if (count > 0) {
+                function->params = poolTokens(count);
+                for (int i = 0; i < count; i++) {
+                    *TOKEN_AT(function->params + i) = readToken(reader);
+                }
+            }
+            function->param_count = count;
+            if (readByte(reader) && count > 0) {
+                function->paramTypes = malloc(sizeof(StaticType) * count);
+                if (function->paramTypes == NULL) {
+                    reader->failed = true;
+                    break;
+                }
+                for (int i = 0; i < count; i++) {
+                    function->paramTypes[i] = readStaticType(reader);
+                }
+            }
+            function->returnType = readStaticType(reader);
+            function->pure = readByte(reader) != 0;
+            int32_t upvalues = readCount(reader);
+            if (upvalues > 0) {
+                function->upvalues = malloc(sizeof(Upvalue) * upvalues);
+                if (function->upvalues == NULL) {
+                    reader->failed = true;
+                    break;
+                }
+                // count up as they arrive, like call arguments
+                for (int i = 0; i < upvalues && !reader->failed; i++) {
+                    function->upvalues[i].name = readToken(reader);
+                    function->upvalues[i].local = readByte(reader) != 0;
+                    function->upvalues[i].index = readUpvalueIndex(reader);
+                    function->upvalueCount = i + 1;
+                }
+            }
+            function->localCount = readLocalCount(reader);
+            function->captured = readByte(reader) != 0;
+
+            if (readByte(reader) == 0) {
+                function->body = nodeIndex(readStmtList(reader));
+                break;
+            }
+            LazyBody* lazy = &function->lazy;
+            uint32_t offset;
+            readBytes(reader, &offset, sizeof(offset));
+            int32_t line = readInt(reader);
+            int32_t assigned = readCount(reader);
+            if (reader->failed || offset >= reader->sourceLength) {
+                reader->failed = true;
+                break;
+            }
+            if (assigned > 0) {
+                lazy->assigned = malloc(sizeof(Token) * assigned);
+                if (lazy->assigned == NULL) {
+                    reader->failed = true;
+                    break;
+                }
+                // count up as they arrive, like call arguments
+                for (int i = 0; i < assigned && !reader->failed; i++) {
+                    lazy->assigned[i] = readToken(reader);
+                    lazy->assignedCount = i + 1;
+                }
+            }
+            lazy->start = reader->source + offset;
+            lazy->line = line;
+            break;
+        }
+        case STMT_RETURN:
+            stmt->as.return_stmt.keyword = poolToken(readToken(reader));
+            stmt->as.return_stmt.value = nodeIndex(readExpr(reader));
+            break;
+        case STMT_BREAK:
+        case STMT_CONTINUE:
+            stmt->as.jump.keyword = poolToken(readToken(reader));
+            break;
+    }
+    return stmt;
+}
+
+static StmtList* readStmtList(Reader* reader) {
+    int32_t count = readCount(reader);
+    if (count == 0) return NULL;
+    // statements not read yet stay 0, which freeStmtList skips
+    StmtList* list = poolAllocate(sizeof(StmtList) + sizeof(NodeIndex) * count);
+    list->count = count;
+    for (int i = 0; i < count && !reader->failed; i++) {
+        list->stmts[i] = nodeIndex(readStmt(reader));
+    }
+    return list;
+}
+
+bool decodeStatements(const uint8_t* bytes, size_t length, const char* source, size_t sourceLength, StmtList** statements) {
+    Reader reader = {bytes, bytes + length, source, sourceLength, false};
+    PoolMark mark = poolMark();
+    *statements = readStmtList(&reader);
+    if (reader.at != reader.end) reader.failed = true; // trailing junk
+
+    if (reader.failed) {
+        freeStmtList(*statements);
+        poolRelease(mark);
+        *statements = NULL;
+        return false;
+    }
+    return true;
+}
+
+StmtList* loadCache(const char* cachePath, const char* source, size_t sourceLength, bool lazyBodies) {
+    Source cache;
+    if (!loadSourceQuietly(&cache, cachePath)) return NULL;
+
+    const uint8_t* payload = (const uint8_t*)cache.text + sizeof(CacheHeader);
+    size_t length = cache.length - sizeof(CacheHeader);
+    CacheHeader header;
+    StmtList* statements = NULL;
+    if (cache.length >= sizeof(header)) {
+        memcpy(&header, cache.text, sizeof(header));
+        if (memcmp(header.magic, CACHE_MAGIC, sizeof(header.magic)) == 0 &&
+            header.version == AST_FORMAT_VERSION && header.sourceLength == sourceLength &&
+            header.sourceHash == hashBytes(source, sourceLength) &&
+            header.payloadHash == hashBytes(payload, length) && (lazyBodies || !header.lazyBodies)) {
+            decodeStatements(payload, length, source, sourceLength, &statements);
+        }
+    }
+
+    freeSource(&cache);
+    return statements;
+}
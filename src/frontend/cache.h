@@ -0,0 +1,51 @@
+#ifndef sg_cache_h
+#define sg_cache_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../ast/stmt.h"
+
+// .sgc files: the program as the front end leaves it (parsed, resolved and
+// optimized) saved next to its script, so later runs of an unchanged script
+// skip scanning, parsing, resolving and optimizing. a cache only counts if
+// its format version and the hash and length of the source all match.
+//
+// tokens are stored as offsets into the source, which is loaded anyway for
+// the hash, so names and error lines come out exactly as if parsed.
+
+// where the cache of the script at path goes: foo.sg -> foo.sgc
+char* cachePathFor(const char* path);
+
+// the statements saved in cachePath for source, or NULL if there is no
+// usable cache (missing, stale, another version or damaged). nodes go in the
+// AST pool like parsed ones. without lazyBodies, a cache with function bodies
+// the parser skipped (see parseFunctionBody) doesn't count either.
+StmtList* loadCache(const char* cachePath, const char* source, size_t sourceLength, bool lazyBodies);
+
+// save statements for source. call before running them, the interpreter
+// rewrites nodes as it goes. failing to write is not an error, the next run
+// just parses again. lazyBodies says whether the parser skipped bodies.
+void saveCache(const char* cachePath, const char* source, size_t sourceLength, StmtList* statements, bool lazyBodies);
+
+// --- Encoded Statements ---
+// the format of the statements in a cache, also used for the functions in
+// heap images (see backend/image.h)
+
+// bump whenever the AST, this encoding or what the optimizer produces changes
+#define AST_FORMAT_VERSION 8
+
+// FNV-1a, for telling whether files still match what they were made from
+uint64_t hashBytes(const void* bytes, size_t length);
+
+// statements as bytes, with their tokens as offsets into source. bodies the
+// parser skipped are saved as offsets too. the caller frees the result. NULL
+// if source is too long to point into, or a skipped body is not in it.
+uint8_t* encodeStatements(StmtList* statements, const char* source, size_t sourceLength, size_t* length);
+
+// the statements encodeStatements was given, with tokens pointing into source
+// again. false if the bytes are damaged, then nothing is left allocated.
+bool decodeStatements(const uint8_t* bytes, size_t length, const char* source, size_t sourceLength, StmtList** statements);
+
+#endif
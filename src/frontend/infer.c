@@ -0,0 +1,666 @@
+#include "infer.h"
+#include "../ast/expr.h"
+#include "../ast/stmt.h"
+#include "../runtime/memory.h"
+#include "analysis.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// --- Type State ---
+// what we know about every variable in scope at the current program point,
+// inner bindings after the outer ones they shadow. innermost[] finds the
+// binding a name means by its symbol, like the resolver's scopes do.
+//
+// where paths split (branches, loops, function bodies) the state isn't
+// copied. every change of a type goes on a trail with the type it replaced,
+// so going back to the state at an earlier mark only costs the changes since
+// then, and so does merging two paths: the bindings neither path changed
+// agree anyway.
+typedef struct {
+    Token name;
+    StaticType type;
+    StaticType declared; // from an annotation. the interpreter enforces it on every store
+    bool global;
+    int shadowed; // binding of the same name further out, -1 if none
+    int body; // the function body type was set in, see typeOf
+    int seen; // stamp of the last merge that looked at it
+    int change; // its place in the delta being merged, when seen
+} Binding;
+
+typedef struct {
+    Binding* bindings;
+    int count;
+    int capacity;
+} TypeState;
+
+static TypeState state = { NULL, 0, 0 };
+
+// by symbol, the innermost binding of that name in state, -1 if none
+static int* innermost = NULL;
+static SymbolId innermostCapacity = 0;
+
+// a type a binding had before it changed
+typedef struct {
+    int binding;
+    StaticType type;
+    int body;
+} Undo;
+
+static Undo* trail = NULL;
+static int trailCount = 0;
+static int trailCapacity = 0;
+
+// the state some path ended in, as the bindings it changed since a mark
+typedef struct {
+    int binding;
+    StaticType before; // at the mark
+    StaticType after;
+} TypeChange;
+
+typedef struct {
+    TypeChange* changes;
+    int count;
+    int capacity;
+} Delta;
+
+// the function body being inferred, and the bindings from outside it. the
+// body may run at any later point, so those only keep their annotated type
+// in it until the body itself sets them. bodies are numbered as they come,
+// 0 is the top level.
+static int body = 0;
+static int bodyCount = 0;
+static int bodyBase = 0;
+
+static int mergeStamp = 0;
+
+// names some function body assigns to. a call may change any of them.
+static NameSet functionAssigned;
+
+// globals declared more than once at the top level. a later declaration
+// replaces the variable and its annotation, so a function body can't trust
+// the one it sees.
+static NameSet redeclaredGlobals;
+
+// top-level functions with a return annotation whose name always refers to
+// them, so a call through that name has the annotated type. the names are in
+// the same order
+static Stmt** typedFunctions = NULL;
+static int typedFunctionCount = 0;
+static int typedFunctionCapacity = 0;
+static NameSet typedFunctionNames;
+
+// 0 at the top level of the program
+static int depth = 0;
+
+// the states at the jumps out of the innermost loop, merged into where they
+// go: the loop's exit for `cabut`, its next iteration for `carry on`. both
+// are changes since the top of the current pass through the loop.
+// NULL outside a loop.
+typedef struct {
+    Delta breaks;
+    Delta continues;
+    bool broke;
+    bool continued;
+    int mark;
+    int base; // bindings from outside the loop
+} LoopJumps;
+
+static LoopJumps* loopJumps = NULL;
+
+// for the --dump-opt summary
+static int numericOperations = 0;
+static int provenOperations = 0;
+
+static void indexBinding(int index) {
+    SymbolId symbol = state.bindings[index].name.symbol;
+    if (symbol >= innermostCapacity) {
+        SymbolId oldCapacity = innermostCapacity;
+        innermostCapacity = symbolLimit() > 2 * oldCapacity ? symbolLimit() : 2 * oldCapacity;
+        if (innermostCapacity <= symbol) innermostCapacity = symbol + 1;
+        innermost = GROW_ARRAY(int, innermost, oldCapacity, innermostCapacity);
+        for (SymbolId i = oldCapacity; i < innermostCapacity; i++) {
+            innermost[i] = -1;
+        }
+    }
+    state.bindings[index].shadowed = innermost[symbol];
+    innermost[symbol] = index;
+}
+
+// drop the bindings made since the state had mark of them
+static void popBindings(int mark) {
+    while (state.count > mark) {
+        Binding* binding = &state.bindings[--state.count];
+        innermost[binding->name.symbol] = binding->shadowed;
+    }
+}
+
+static void pushBinding(Token name, StaticType type, StaticType declared) {
+    if (state.count >= state.capacity) {
+        int oldCapacity = state.capacity;
+        state.capacity = GROW_CAPACITY(oldCapacity);
+        state.bindings = GROW_ARRAY(Binding, state.bindings, oldCapacity, state.capacity);
+    }
+    Binding* binding = &state.bindings[state.count];
+    binding->name = name;
+    binding->type = declared != STATIC_UNKNOWN ? declared : type;
+    binding->declared = declared;
+    binding->global = depth == 0;
+    binding->body = body;
+    binding->seen = 0;
+    indexBinding(state.count);
+    state.count++;
+}
+
+static int findBinding(Token* name) {
+    if (name->symbol >= innermostCapacity) return -1;
+    return innermost[name->symbol];
+}
+
+// the type of binding index, had it type set in the given body
+static StaticType typeIn(int index, StaticType type, int setIn) {
+    if (index >= bodyBase || setIn == body) return type;
+    Binding* binding = &state.bindings[index];
+    if (binding->global && nameSetContains(&redeclaredGlobals, &binding->name)) return STATIC_UNKNOWN;
+    return binding->declared;
+}
+
+static StaticType typeOf(int index) {
+    return typeIn(index, state.bindings[index].type, state.bindings[index].body);
+}
+
+static void setType(int index, StaticType type) {
+    if (typeOf(index) == type) return;
+    if (trailCount >= trailCapacity) {
+        int oldCapacity = trailCapacity;
+        trailCapacity = GROW_CAPACITY(oldCapacity);
+        trail = GROW_ARRAY(Undo, trail, oldCapacity, trailCapacity);
+    }
+    Binding* binding = &state.bindings[index];
+    trail[trailCount++] = (Undo) { index, binding->type, binding->body };
+    binding->type = type;
+    binding->body = body;
+}
+
+// back to the types at mark. the bindings made since must be gone already
+static void undo(int mark) {
+    while (trailCount > mark) {
+        Undo* change = &trail[--trailCount];
+        if (change->binding >= state.count) continue;
+        state.bindings[change->binding].type = change->type;
+        state.bindings[change->binding].body = change->body;
+    }
+}
+
+static void freeDelta(Delta* delta) {
+    FREE_ARRAY(TypeChange, delta->changes, delta->capacity);
+    delta->changes = NULL;
+    delta->count = 0;
+    delta->capacity = 0;
+}
+
+static void addChange(Delta* delta, int binding, StaticType before, StaticType after) {
+    if (delta->count >= delta->capacity) {
+        int oldCapacity = delta->capacity;
+        delta->capacity = GROW_CAPACITY(oldCapacity);
+        delta->changes = GROW_ARRAY(TypeChange, delta->changes, oldCapacity, delta->capacity);
+    }
+    delta->changes[delta->count++] = (TypeChange) { binding, before, after };
+}
+
+// the bindings below base whose type changed since mark, with their types
+// then and now. seen stamps them with their place in delta.
+static void collectChanges(Delta* delta, int mark, int base) {
+    int stamp = ++mergeStamp;
+    for (int i = mark; i < trailCount; i++) {
+        int index = trail[i].binding;
+        if (index >= base || state.bindings[index].seen == stamp) continue;
+        // the first change since mark has the type at mark
+        StaticType before = typeIn(index, trail[i].type, trail[i].body);
+        StaticType after = typeOf(index);
+        state.bindings[index].seen = stamp;
+        if (before == after) continue;
+        state.bindings[index].change = delta->count;
+        addChange(delta, index, before, after);
+    }
+}
+
+// where two paths join a variable keeps its type only if both agree. the
+// current state and other both went on from the state at mark, other ended
+// with the given changes. returns true if the current state lost anything.
+static bool mergeChanges(Delta* other, int mark, int base) {
+    Delta own = { NULL, 0, 0 };
+    collectChanges(&own, mark, base);
+    int stamp = ++mergeStamp;
+
+    bool changed = false;
+    for (int i = 0; i < other->count; i++) {
+        TypeChange* change = &other->changes[i];
+        state.bindings[change->binding].seen = stamp;
+        StaticType current = typeOf(change->binding);
+        if (current != change->after && current != STATIC_UNKNOWN) {
+            setType(change->binding, STATIC_UNKNOWN);
+            changed = true;
+        }
+    }
+    // other still has the type from the mark
+    for (int i = 0; i < own.count; i++) {
+        TypeChange* change = &own.changes[i];
+        if (state.bindings[change->binding].seen == stamp) continue;
+        if (change->after != change->before && change->after != STATIC_UNKNOWN) {
+            setType(change->binding, STATIC_UNKNOWN);
+            changed = true;
+        }
+    }
+    freeDelta(&own);
+    return changed;
+}
+
+// as mergeChanges, into a delta instead of the current state
+static void mergeInto(Delta* into, Delta* other) {
+    int stamp = ++mergeStamp;
+    for (int i = 0; i < into->count; i++) {
+        state.bindings[into->changes[i].binding].seen = stamp;
+        state.bindings[into->changes[i].binding].change = i;
+    }
+    int intoCount = into->count;
+    for (int i = 0; i < other->count; i++) {
+        TypeChange* change = &other->changes[i];
+        Binding* binding = &state.bindings[change->binding];
+        if (binding->seen == stamp) {
+            TypeChange* mine = &into->changes[binding->change];
+            if (mine->after != change->after) mine->after = STATIC_UNKNOWN;
+            binding->seen = -stamp; // into's changes other has too
+        } else if (change->before != change->after && change->before != STATIC_UNKNOWN) {
+            addChange(into, change->binding, change->before, STATIC_UNKNOWN);
+        }
+    }
+    // into's changes other doesn't have: other keeps the type from the mark
+    for (int i = 0; i < intoCount; i++) {
+        TypeChange* mine = &into->changes[i];
+        if (state.bindings[mine->binding].seen == stamp && mine->after != mine->before) {
+            mine->after = STATIC_UNKNOWN;
+        }
+    }
+}
+
+static void addJump(Delta* jumps, bool* seen) {
+    Delta here = { NULL, 0, 0 };
+    collectChanges(&here, loopJumps->mark, loopJumps->base);
+    if (*seen) {
+        mergeInto(jumps, &here);
+        freeDelta(&here);
+    } else {
+        *jumps = here;
+        *seen = true;
+    }
+}
+
+// forget the state once inference is done
+static void clearState() {
+    popBindings(0);
+    FREE_ARRAY(Binding, state.bindings, state.capacity);
+    state = (TypeState) { NULL, 0, 0 };
+    FREE_ARRAY(int, innermost, innermostCapacity);
+    innermost = NULL;
+    innermostCapacity = 0;
+    FREE_ARRAY(Undo, trail, trailCapacity);
+    trail = NULL;
+    trailCount = 0;
+    trailCapacity = 0;
+}
+
+static StaticType callResultType(Expr* callee) {
+    if (callee->type != EXPR_VARIABLE) return STATIC_UNKNOWN;
+    Token* name = TOKEN_AT(callee->as.variable.name);
+    int binding = findBinding(name);
+    if (binding >= 0 && !state.bindings[binding].global) return STATIC_UNKNOWN; // shadowed
+
+    int function = nameSetFind(&typedFunctionNames, name);
+    return function < 0 ? STATIC_UNKNOWN : AS_FUNCTION_STMT(typedFunctions[function])->returnType;
+}
+
+static void forgetBinding(int index) {
+    if (state.bindings[index].declared == STATIC_UNKNOWN) setType(index, STATIC_UNKNOWN);
+}
+
+// whichever is shorter: the bindings, or the names calls assign to
+static void forgetCallEffects() {
+    if (state.count <= functionAssigned.count) {
+        for (int i = 0; i < state.count; i++) {
+            if (nameSetContains(&functionAssigned, &state.bindings[i].name)) forgetBinding(i);
+        }
+        return;
+    }
+    for (int i = 0; i < functionAssigned.count; i++) {
+        SymbolId symbol = functionAssigned.names[i].symbol;
+        int index = symbol < innermostCapacity ? innermost[symbol] : -1;
+        for (; index >= 0; index = state.bindings[index].shadowed) {
+            forgetBinding(index);
+        }
+    }
+}
+
+// --- Expressions ---
+
+static StaticType inferExpr(Expr* expr) {
+    if (expr == NULL) return STATIC_NIL;
+
+    StaticType type = STATIC_UNKNOWN;
+    switch (expr->type) {
+        case EXPR_LITERAL:
+            switch (expr->as.literal.type) {
+                case TOKEN_NUMBER:
+                    type = STATIC_NUMBER;
+                    break;
+                case TOKEN_STRING:
+                    type = STATIC_STRING;
+                    break;
+                case TOKEN_CORRECT:
+                case TOKEN_WRONG:
+                    type = STATIC_BOOL;
+                    break;
+                case TOKEN_NIL:
+                    type = STATIC_NIL;
+                    break;
+                default:
+                    break;
+            }
+            break;
+        case EXPR_VARIABLE: {
+            int binding = findBinding(TOKEN_AT(expr->as.variable.name));
+            if (binding >= 0) type = typeOf(binding);
+            break;
+        }
+        case EXPR_ASSIGN: {
+            type = inferExpr(AS_EXPR(expr->as.assign.value));
+            int binding = findBinding(TOKEN_AT(expr->as.assign.name));
+            if (binding >= 0) {
+                // a value of any other type is a runtime error
+                StaticType declared = state.bindings[binding].declared;
+                if (declared != STATIC_UNKNOWN) type = declared;
+                setType(binding, type);
+            }
+            break;
+        }
+        case EXPR_GROUPING:
+            type = inferExpr(AS_EXPR(expr->as.grouping.expression));
+            break;
+        case EXPR_UNARY:
+            // either a runtime error or a value of this type
+            inferExpr(AS_EXPR(expr->as.unary.right));
+            type = TOKEN_AT(expr->as.unary.oper)->type == TOKEN_MINUS ? STATIC_NUMBER : STATIC_BOOL;
+            break;
+        case EXPR_BINARY: {
+            StaticType left = inferExpr(AS_EXPR(expr->as.binary.left));
+            StaticType right = inferExpr(AS_EXPR(expr->as.binary.right));
+            switch (TOKEN_AT(expr->as.binary.oper)->type) {
+                case TOKEN_EQUAL_EQUAL:
+                case TOKEN_BANG_EQUAL:
+                    type = STATIC_BOOL;
+                    break;
+                case TOKEN_GREATER:
+                case TOKEN_GREATER_EQUAL:
+                case TOKEN_LESS:
+                case TOKEN_LESS_EQUAL:
+                    type = STATIC_BOOL;
+                    numericOperations++;
+                    if (left == STATIC_NUMBER && right == STATIC_NUMBER) provenOperations++;
+                    break;
+                case TOKEN_MINUS:
+                case TOKEN_STAR:
+                case TOKEN_SLASH:
+                    type = STATIC_NUMBER;
+                    numericOperations++;
+                    if (left == STATIC_NUMBER && right == STATIC_NUMBER) provenOperations++;
+                    break;
+                case TOKEN_PLUS:
+                    // mixing a number with anything else fails at runtime
+                    if (left == STATIC_NUMBER || right == STATIC_NUMBER) {
+                        type = STATIC_NUMBER;
+                    } else if (left == STATIC_STRING || right == STATIC_STRING) {
+                        type = STATIC_STRING;
+                    }
+                    numericOperations++;
+                    if (left == STATIC_NUMBER && right == STATIC_NUMBER) provenOperations++;
+                    break;
+                default:
+                    break;
+            }
+            break;
+        }
+        case EXPR_LOGICAL: {
+            // the right operand may or may not run
+            StaticType left = inferExpr(AS_EXPR(expr->as.logical.left));
+            int mark = trailCount;
+            StaticType right = inferExpr(AS_EXPR(expr->as.logical.right));
+            Delta afterLeft = { NULL, 0, 0 };
+            mergeChanges(&afterLeft, mark, state.count);
+            type = left == right ? left : STATIC_UNKNOWN;
+            break;
+        }
+        case EXPR_CALL:
+            inferExpr(AS_EXPR(expr->as.call.callee));
+            for (int i = 0; i < expr->as.call.arg_count; i++) {
+                inferExpr(CALL_ARGUMENT(&expr->as.call, i));
+            }
+            forgetCallEffects();
+            type = callResultType(AS_EXPR(expr->as.call.callee));
+            break;
+        default:
+            break;
+    }
+
+    expr->staticType = type;
+    return type;
+}
+
+// --- Statements ---
+
+static void inferStmt(Stmt* stmt);
+
+static void inferStmtList(StmtList* list) {
+    for (int i = 0; i < STMT_COUNT(list); i++) {
+        inferStmt(LIST_STMT(list, i));
+    }
+}
+
+static void inferStmt(Stmt* stmt) {
+    if (stmt == NULL) return;
+    switch (stmt->type) {
+        case STMT_EXPRESSION:
+            inferExpr(AS_EXPR(stmt->as.expression.expression));
+            break;
+        case STMT_PRINT:
+            inferExpr(AS_EXPR(stmt->as.print.expression));
+            break;
+        case STMT_RETURN:
+            inferExpr(AS_EXPR(stmt->as.return_stmt.value));
+            break;
+        case STMT_BREAK:
+            // what follows doesn't run, going on with this state only loses precision
+            if (loopJumps != NULL) addJump(&loopJumps->breaks, &loopJumps->broke);
+            break;
+        case STMT_CONTINUE:
+            if (loopJumps != NULL) addJump(&loopJumps->continues, &loopJumps->continued);
+            break;
+        case STMT_VAR:
+            pushBinding(*TOKEN_AT(stmt->as.var.name), inferExpr(AS_EXPR(stmt->as.var.initializer)), stmt->as.var.declaredType);
+            break;
+        case STMT_BLOCK: {
+            int mark = state.count;
+            depth++;
+            inferStmtList(AS_STMT_LIST(stmt->as.block.statements));
+            depth--;
+            popBindings(mark);
+            break;
+        }
+        case STMT_IF: {
+            inferExpr(AS_EXPR(stmt->as.ifStmt.condition));
+            int base = state.count;
+            int mark = trailCount;
+            inferStmt(AS_STMT(stmt->as.ifStmt.thenBranch));
+            popBindings(base);
+            Delta afterThen = { NULL, 0, 0 };
+            collectChanges(&afterThen, mark, base);
+            undo(mark);
+            inferStmt(AS_STMT(stmt->as.ifStmt.elseBranch));
+            mergeChanges(&afterThen, mark, base);
+            freeDelta(&afterThen);
+            break;
+        }
+        case STMT_WHILE: {
+            // iterate until the state at the top of the loop stops changing.
+            // only the annotations of that last pass are kept, and they hold
+            // for every iteration.
+            LoopJumps* enclosingJumps = loopJumps;
+            int base = state.count;
+            for (;;) {
+                int entry = trailCount;
+                inferExpr(AS_EXPR(stmt->as.whileStmt.condition));
+                int afterCondition = trailCount;
+                LoopJumps jumps = { { NULL, 0, 0 }, { NULL, 0, 0 }, false, false, afterCondition, base };
+                loopJumps = &jumps;
+                inferStmt(AS_STMT(stmt->as.whileStmt.body));
+                loopJumps = enclosingJumps;
+                popBindings(base);
+                if (jumps.continued) mergeChanges(&jumps.continues, afterCondition, base);
+                inferExpr(AS_EXPR(stmt->as.whileStmt.increment));
+                freeDelta(&jumps.continues);
+
+                // the state at the top of the loop keeps what the end of the pass agrees with
+                Delta pass = { NULL, 0, 0 };
+                collectChanges(&pass, entry, base);
+                bool changed = false;
+                for (int i = 0; i < pass.count; i++) {
+                    if (pass.changes[i].before != STATIC_UNKNOWN) changed = true;
+                }
+                if (!changed) {
+                    undo(afterCondition);
+                    if (jumps.broke) mergeChanges(&jumps.breaks, afterCondition, base);
+                    freeDelta(&jumps.breaks);
+                    freeDelta(&pass);
+                    break;
+                }
+                undo(entry);
+                for (int i = 0; i < pass.count; i++) {
+                    setType(pass.changes[i].binding, STATIC_UNKNOWN);
+                }
+                freeDelta(&jumps.breaks);
+                freeDelta(&pass);
+            }
+            break;
+        }
+        case STMT_FUNCTION: {
+            pushBinding(*TOKEN_AT(AS_FUNCTION_STMT(stmt)->name), STATIC_UNKNOWN, STATIC_UNKNOWN);
+
+            // the body may run at any later point, so only annotated variables
+            // outside it keep their type (see typeOf). the rest stay around
+            // for shadowing.
+            int enclosingBody = body;
+            int enclosingBase = bodyBase;
+            LoopJumps* enclosingJumps = loopJumps;
+            int mark = trailCount;
+            body = ++bodyCount;
+            bodyBase = state.count;
+            loopJumps = NULL;
+            depth++;
+            StaticType* paramTypes = AS_FUNCTION_STMT(stmt)->paramTypes;
+            for (int i = 0; i < AS_FUNCTION_STMT(stmt)->param_count; i++) {
+                StaticType type = paramTypes != NULL ? paramTypes[i] : STATIC_UNKNOWN;
+                pushBinding(*TOKEN_AT(AS_FUNCTION_STMT(stmt)->params + i), STATIC_UNKNOWN, type);
+            }
+            inferStmtList(AS_STMT_LIST(AS_FUNCTION_STMT(stmt)->body));
+            depth--;
+            popBindings(bodyBase);
+            undo(mark);
+            loopJumps = enclosingJumps;
+            body = enclosingBody;
+            bodyBase = enclosingBase;
+            break;
+        }
+    }
+}
+
+static void findRedeclaredGlobals(StmtList* statements) {
+    NameSet declared;
+    initNameSet(&declared);
+    for (int i = 0; i < STMT_COUNT(statements); i++) {
+        Stmt* stmt = LIST_STMT(statements, i);
+        Token* name = NULL;
+        if (stmt->type == STMT_VAR) name = TOKEN_AT(stmt->as.var.name);
+        if (stmt->type == STMT_FUNCTION) name = TOKEN_AT(AS_FUNCTION_STMT(stmt)->name);
+        if (name == NULL) continue;
+        if (nameSetContains(&declared, name)) {
+            nameSetAdd(&redeclaredGlobals, *name);
+        } else {
+            nameSetAdd(&declared, *name);
+        }
+    }
+    freeNameSet(&declared);
+}
+
+static void findTypedFunctions(StmtList* statements) {
+    Effects program;
+    initEffects(&program);
+    scanStmtList(statements, &program);
+
+    for (int i = 0; i < STMT_COUNT(statements); i++) {
+        Stmt* stmt = LIST_STMT(statements, i);
+        if (stmt->type != STMT_FUNCTION || AS_FUNCTION_STMT(stmt)->returnType == STATIC_UNKNOWN) continue;
+        if (nameSetContains(&redeclaredGlobals, TOKEN_AT(AS_FUNCTION_STMT(stmt)->name))) continue;
+        if (nameSetContains(&program.assigned, TOKEN_AT(AS_FUNCTION_STMT(stmt)->name))) continue;
+
+        if (typedFunctionCount >= typedFunctionCapacity) {
+            int oldCapacity = typedFunctionCapacity;
+            typedFunctionCapacity = GROW_CAPACITY(oldCapacity);
+            typedFunctions = GROW_ARRAY(Stmt*, typedFunctions, oldCapacity, typedFunctionCapacity);
+        }
+        typedFunctions[typedFunctionCount++] = stmt;
+        nameSetAdd(&typedFunctionNames, *TOKEN_AT(AS_FUNCTION_STMT(stmt)->name));
+    }
+    freeEffects(&program);
+}
+
+void inferTypes(StmtList* statements, bool dump) {
+    Effects effects;
+    initEffects(&effects);
+    scanProgramFunctions(statements, &effects);
+    functionAssigned = effects.assigned;
+    initNameSet(&redeclaredGlobals);
+    initNameSet(&typedFunctionNames);
+    findRedeclaredGlobals(statements);
+    findTypedFunctions(statements);
+    numericOperations = 0;
+    provenOperations = 0;
+    depth = 0;
+    body = 0;
+    bodyCount = 0;
+    bodyBase = 0;
+
+    inferStmtList(statements);
+
+    if (dump) {
+        fprintf(stderr, "types: %d of %d arithmetic and comparison operations need no operand check\n",
+                provenOperations, numericOperations);
+    }
+
+    clearState();
+    freeEffects(&effects);
+    freeNameSet(&redeclaredGlobals);
+    freeNameSet(&typedFunctionNames);
+    FREE_ARRAY(Stmt*, typedFunctions, typedFunctionCapacity);
+    typedFunctions = NULL;
+    typedFunctionCount = 0;
+    typedFunctionCapacity = 0;
+}
+
+void inferFunctionTypes(Stmt* function, NameSet* assigned) {
+    functionAssigned = *assigned;
+    depth = 0;
+    body = 0;
+    bodyCount = 0;
+    bodyBase = 0;
+    inferStmt(function);
+    clearState();
+}
@@ -0,0 +1,18 @@
+#ifndef sg_infer_h
+#define sg_infer_h
+
+#include "../ast/stmt.h"
+#include "analysis.h"
+#include <stdbool.h>
+
+// flow-sensitive type inference. fills in Expr.staticType wherever the type of
+// a value is the same on every execution, so the interpreter can skip its
+// operand checks there. when dump is true a summary is printed on stderr.
+void inferTypes(StmtList* statements, bool dump);
+
+// the same for a function body parsed after the rest of the program (see
+// parseFunctionBody). functionAssigned holds the names any call may change.
+// nothing is known about globals there, so only locals get types.
+void inferFunctionTypes(Stmt* function, NameSet* functionAssigned);
+
+#endif
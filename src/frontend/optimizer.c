@@ -0,0 +1,1118 @@
+#include "optimizer.h"
+#include "analysis.h"
+#include "infer.h"
+#include "../ast/expr.h"
+#include "../ast/pool.h"
+#include "../ast/stmt.h"
+#include "../runtime/memory.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// --- Optimizer State ---
+static bool dumpOptimizations = false;
+
+// names assigned somewhere inside a function body. any call can change these.
+static NameSet functionAssigned;
+
+// what any call may change, for the function bodies parsed late (see
+// optimizeFunction). worked out once, the parser noted what skipped bodies
+// assign, so bodies parsed since are covered.
+static Effects programEffects;
+static bool scannedProgram = false;
+
+// local variables in scope at the statement being optimized. anything not in
+// here is a global.
+static NameSet locals;
+static int scopeDepth = 0;
+
+// temporaries get names starting with '$' so they can never clash with user code
+static int tempCount = 0;
+
+static TokenIndex newTemp(const char* prefix, int line) {
+    char buffer[32];
+    int length = snprintf(buffer, sizeof(buffer), "$%s%d", prefix, tempCount++);
+
+    Token token;
+    token.type = TOKEN_IDENTIFIER;
+    token.symbol = internSymbol(buffer, length);
+    token.start = symbolName(token.symbol);
+    token.length = length;
+    token.line = line;
+    return poolToken(token);
+}
+
+void freeOptimizer() {
+    tempCount = 0;
+
+    if (scannedProgram) freeEffects(&programEffects);
+    scannedProgram = false;
+}
+
+// --- Expression Helpers ---
+
+// no calls and no assignments anywhere inside
+static bool isPure(Expr* expr) {
+    if (expr == NULL) return true;
+    switch (expr->type) {
+        case EXPR_LITERAL:
+        case EXPR_VARIABLE:
+            return true;
+        case EXPR_GROUPING:
+            return isPure(AS_EXPR(expr->as.grouping.expression));
+        case EXPR_UNARY:
+            return isPure(AS_EXPR(expr->as.unary.right));
+        case EXPR_BINARY:
+            return isPure(AS_EXPR(expr->as.binary.left)) && isPure(AS_EXPR(expr->as.binary.right));
+        case EXPR_LOGICAL:
+            return isPure(AS_EXPR(expr->as.logical.left)) && isPure(AS_EXPR(expr->as.logical.right));
+        default:
+            return false;
+    }
+}
+
+static bool exprEquals(Expr* a, Expr* b) {
+    if (a->type != b->type) return false;
+    switch (a->type) {
+        case EXPR_LITERAL:
+            if (a->as.literal.type != b->as.literal.type) return false;
+            if (a->as.literal.type == TOKEN_NUMBER) return a->as.literal.value.number == b->as.literal.value.number;
+            if (a->as.literal.type == TOKEN_STRING) return strcmp(a->as.literal.value.string, b->as.literal.value.string) == 0;
+            return true;
+        case EXPR_VARIABLE:
+            return TOKEN_AT(a->as.variable.name)->symbol == TOKEN_AT(b->as.variable.name)->symbol;
+        case EXPR_GROUPING:
+            return exprEquals(AS_EXPR(a->as.grouping.expression), AS_EXPR(b->as.grouping.expression));
+        case EXPR_UNARY:
+            return TOKEN_AT(a->as.unary.oper)->type == TOKEN_AT(b->as.unary.oper)->type &&
+                   exprEquals(AS_EXPR(a->as.unary.right), AS_EXPR(b->as.unary.right));
+        case EXPR_BINARY:
+            return TOKEN_AT(a->as.binary.oper)->type == TOKEN_AT(b->as.binary.oper)->type &&
+                   exprEquals(AS_EXPR(a->as.binary.left), AS_EXPR(b->as.binary.left)) &&
+                   exprEquals(AS_EXPR(a->as.binary.right), AS_EXPR(b->as.binary.right));
+        case EXPR_LOGICAL:
+            return TOKEN_AT(a->as.logical.oper)->type == TOKEN_AT(b->as.logical.oper)->type &&
+                   exprEquals(AS_EXPR(a->as.logical.left), AS_EXPR(b->as.logical.left)) &&
+                   exprEquals(AS_EXPR(a->as.logical.right), AS_EXPR(b->as.logical.right));
+        default:
+            return false;
+    }
+}
+
+// deep copy of a pure expression
+static Expr* cloneExpr(Expr* expr) {
+    switch (expr->type) {
+        case EXPR_LITERAL:
+            switch (expr->as.literal.type) {
+                case TOKEN_NUMBER:
+                    return newLiteralNumberExpr(expr->as.literal.value.number);
+                case TOKEN_STRING:
+                    return newLiteralStringExpr(expr->as.literal.value.string);
+                case TOKEN_NIL:
+                    return newLiteralNilExpr();
+                default:
+                    return newLiteralBooleanExpr(expr->as.literal.value.boolean);
+            }
+        case EXPR_VARIABLE: {
+            Expr* copy = newVariableExpr(expr->as.variable.name);
+            copy->as.variable.global = expr->as.variable.global;
+            copy->as.variable.upvalue = expr->as.variable.upvalue;
+            return copy;
+        }
+        case EXPR_GROUPING:
+            return newGroupingExpr(cloneExpr(AS_EXPR(expr->as.grouping.expression)));
+        case EXPR_UNARY:
+            return newUnaryExpr(expr->as.unary.oper, cloneExpr(AS_EXPR(expr->as.unary.right)));
+        case EXPR_BINARY:
+            return newBinaryExpr(cloneExpr(AS_EXPR(expr->as.binary.left)), expr->as.binary.oper,
+                                 cloneExpr(AS_EXPR(expr->as.binary.right)));
+        case EXPR_LOGICAL:
+            return newLogicalExpr(cloneExpr(AS_EXPR(expr->as.logical.left)), expr->as.logical.oper,
+                                  cloneExpr(AS_EXPR(expr->as.logical.right)));
+        default:
+            return NULL;
+    }
+}
+
+// best-effort source line of an expression, for reporting
+static int exprLine(Expr* expr) {
+    switch (expr->type) {
+        case EXPR_VARIABLE:
+            return TOKEN_AT(expr->as.variable.name)->line;
+        case EXPR_ASSIGN:
+            return TOKEN_AT(expr->as.assign.name)->line;
+        case EXPR_GROUPING:
+            return exprLine(AS_EXPR(expr->as.grouping.expression));
+        case EXPR_UNARY:
+            return TOKEN_AT(expr->as.unary.oper)->line;
+        case EXPR_BINARY:
+            return TOKEN_AT(expr->as.binary.oper)->line;
+        case EXPR_LOGICAL:
+            return TOKEN_AT(expr->as.logical.oper)->line;
+        case EXPR_CALL:
+            return TOKEN_AT(expr->as.call.paren)->line;
+        default:
+            return 0;
+    }
+}
+
+// turn expr into a read of temp. returns a new node holding what expr was.
+static Expr* detachExpr(Expr* expr, TokenIndex temp) {
+    Expr* moved = poolAllocate(sizeof(Expr));
+    *moved = *expr;
+    expr->type = EXPR_VARIABLE;
+    expr->staticType = STATIC_UNKNOWN;
+    expr->as.variable.name = temp;
+    expr->as.variable.global = false;
+    expr->as.variable.slot = -1;
+    expr->as.variable.upvalue = -1;
+    return moved;
+}
+
+// --- Loop-Invariant Code Motion ---
+
+typedef struct {
+    Expr** exprs;
+    int count;
+    int capacity;
+    bool barrier; // stop collecting, something with a visible effect runs first
+    bool fallible; // something that may raise an error runs first, see canFail
+} Candidates;
+
+typedef struct {
+    Expr* value; // hoisted expression
+    TokenIndex temp; // temporary holding its value
+} Hoisted;
+
+typedef struct {
+    Hoisted* entries;
+    int count;
+    int capacity;
+} HoistTable;
+
+static void addCandidate(Candidates* candidates, Expr* expr) {
+    if (candidates->count >= candidates->capacity) {
+        int oldCapacity = candidates->capacity;
+        candidates->capacity = GROW_CAPACITY(oldCapacity);
+        candidates->exprs = GROW_ARRAY(Expr*, candidates->exprs, oldCapacity, candidates->capacity);
+    }
+    candidates->exprs[candidates->count++] = expr;
+}
+
+static bool isInvariantName(Effects* loop, Token* name) {
+    if (nameSetContains(&loop->assigned, name)) return false;
+    if (nameSetContains(&loop->declared, name)) return false;
+    // a call inside the loop may run any function body
+    if (loop->hasCall && nameSetContains(&functionAssigned, name)) return false;
+    return true;
+}
+
+static bool isInvariant(Effects* loop, Expr* expr) {
+    if (!isPure(expr)) return false;
+    switch (expr->type) {
+        case EXPR_LITERAL:
+            return true;
+        case EXPR_VARIABLE:
+            return isInvariantName(loop, TOKEN_AT(expr->as.variable.name));
+        case EXPR_GROUPING:
+            return isInvariant(loop, AS_EXPR(expr->as.grouping.expression));
+        case EXPR_UNARY:
+            return isInvariant(loop, AS_EXPR(expr->as.unary.right));
+        case EXPR_BINARY:
+            return isInvariant(loop, AS_EXPR(expr->as.binary.left)) && isInvariant(loop, AS_EXPR(expr->as.binary.right));
+        case EXPR_LOGICAL:
+            return isInvariant(loop, AS_EXPR(expr->as.logical.left)) && isInvariant(loop, AS_EXPR(expr->as.logical.right));
+        default:
+            return false;
+    }
+}
+
+// a temporary only pays off for real work: an operator, or a global lookup
+// that would otherwise walk every enclosing environment
+static bool worthHoisting(Expr* expr) {
+    switch (expr->type) {
+        case EXPR_BINARY:
+        case EXPR_UNARY:
+        case EXPR_LOGICAL:
+            return true;
+        case EXPR_GROUPING:
+            return worthHoisting(AS_EXPR(expr->as.grouping.expression));
+        case EXPR_VARIABLE:
+            return scopeDepth > 0 && !nameSetContains(&locals, TOKEN_AT(expr->as.variable.name));
+        default:
+            return false;
+    }
+}
+
+// whether evaluating expr may raise a runtime error: an operand check that
+// inference could not prove away, a division, a global that may not be
+// defined yet. needs the types inferTypes filled in.
+static bool canFail(Expr* expr) {
+    if (expr == NULL) return false;
+    switch (expr->type) {
+        case EXPR_LITERAL:
+            return false;
+        case EXPR_VARIABLE:
+            return expr->as.variable.global && expr->staticType == STATIC_UNKNOWN;
+        case EXPR_GROUPING:
+            return canFail(AS_EXPR(expr->as.grouping.expression));
+        case EXPR_UNARY: {
+            Expr* right = AS_EXPR(expr->as.unary.right);
+            if (canFail(right)) return true;
+            return TOKEN_AT(expr->as.unary.oper)->type == TOKEN_MINUS && right->staticType != STATIC_NUMBER;
+        }
+        case EXPR_BINARY: {
+            Expr* left = AS_EXPR(expr->as.binary.left);
+            Expr* right = AS_EXPR(expr->as.binary.right);
+            if (canFail(left) || canFail(right)) return true;
+            switch (TOKEN_AT(expr->as.binary.oper)->type) {
+                case TOKEN_EQUAL_EQUAL:
+                case TOKEN_BANG_EQUAL:
+                    return false;
+                case TOKEN_PLUS:
+                    if (left->staticType == STATIC_STRING && right->staticType == STATIC_STRING) return false;
+                    return left->staticType != STATIC_NUMBER || right->staticType != STATIC_NUMBER;
+                case TOKEN_SLASH:
+                    if (left->staticType != STATIC_NUMBER || right->staticType != STATIC_NUMBER) return true;
+                    // only a literal divisor is known not to be zero
+                    return right->type != EXPR_LITERAL || right->as.literal.value.number == 0;
+                default:
+                    return left->staticType != STATIC_NUMBER || right->staticType != STATIC_NUMBER;
+            }
+        }
+        case EXPR_LOGICAL:
+            return canFail(AS_EXPR(expr->as.logical.left)) || canFail(AS_EXPR(expr->as.logical.right));
+        default:
+            return true;
+    }
+}
+
+// walks expr in evaluation order and records the largest invariant subtrees
+// that are evaluated before anything with a visible effect. once something
+// that may fail has run, only candidates that cannot fail are taken, so the
+// error a program stops with stays the same.
+static void collectCandidates(Effects* loop, Expr* expr, Candidates* candidates) {
+    if (expr == NULL || candidates->barrier) return;
+
+    if (isInvariant(loop, expr) && worthHoisting(expr) && (!candidates->fallible || !canFail(expr))) {
+        addCandidate(candidates, expr);
+        return;
+    }
+
+    switch (expr->type) {
+        case EXPR_GROUPING:
+            collectCandidates(loop, AS_EXPR(expr->as.grouping.expression), candidates);
+            break;
+        case EXPR_UNARY:
+            collectCandidates(loop, AS_EXPR(expr->as.unary.right), candidates);
+            break;
+        case EXPR_BINARY:
+            collectCandidates(loop, AS_EXPR(expr->as.binary.left), candidates);
+            collectCandidates(loop, AS_EXPR(expr->as.binary.right), candidates);
+            break;
+        case EXPR_LOGICAL:
+            // the right operand may not run at all
+            collectCandidates(loop, AS_EXPR(expr->as.logical.left), candidates);
+            if (!isPure(AS_EXPR(expr->as.logical.right))) candidates->barrier = true;
+            break;
+        case EXPR_CALL:
+            collectCandidates(loop, AS_EXPR(expr->as.call.callee), candidates);
+            for (int i = 0; i < expr->as.call.arg_count; i++) {
+                collectCandidates(loop, CALL_ARGUMENT(&expr->as.call, i), candidates);
+            }
+            candidates->barrier = true;
+            break;
+        case EXPR_ASSIGN:
+            collectCandidates(loop, AS_EXPR(expr->as.assign.value), candidates);
+            candidates->barrier = true;
+            break;
+        default:
+            break;
+    }
+    if (canFail(expr)) candidates->fallible = true;
+}
+
+// the straight-line prefix of a loop body runs on every iteration
+static void collectFromBodyStmt(Effects* loop, Stmt* stmt, Candidates* candidates) {
+    switch (stmt->type) {
+        case STMT_EXPRESSION:
+            collectCandidates(loop, AS_EXPR(stmt->as.expression.expression), candidates);
+            break;
+        case STMT_VAR:
+            collectCandidates(loop, AS_EXPR(stmt->as.var.initializer), candidates);
+            break;
+        case STMT_PRINT:
+            collectCandidates(loop, AS_EXPR(stmt->as.print.expression), candidates);
+            candidates->barrier = true;
+            break;
+        case STMT_IF:
+            collectCandidates(loop, AS_EXPR(stmt->as.ifStmt.condition), candidates);
+            candidates->barrier = true;
+            break;
+        case STMT_RETURN:
+            collectCandidates(loop, AS_EXPR(stmt->as.return_stmt.value), candidates);
+            candidates->barrier = true;
+            break;
+        default:
+            candidates->barrier = true;
+            break;
+    }
+}
+
+static void collectFromBody(Effects* loop, Stmt* body, Candidates* candidates) {
+    if (body->type != STMT_BLOCK) {
+        collectFromBodyStmt(loop, body, candidates);
+        return;
+    }
+    StmtList* list = AS_STMT_LIST(body->as.block.statements);
+    for (int i = 0; i < STMT_COUNT(list) && !candidates->barrier; i++) {
+        collectFromBodyStmt(loop, LIST_STMT(list, i), candidates);
+    }
+}
+
+// replace every candidate with a temporary, sharing temporaries between
+// structurally equal expressions. new declarations are added to declarations.
+static void hoistCandidates(Candidates* candidates, HoistTable* table, StmtListBuilder* declarations) {
+    for (int i = 0; i < candidates->count; i++) {
+        Expr* expr = candidates->exprs[i];
+        int line = exprLine(expr);
+
+        Hoisted* existing = NULL;
+        for (int j = 0; j < table->count; j++) {
+            if (exprEquals(table->entries[j].value, expr)) {
+                existing = &table->entries[j];
+                break;
+            }
+        }
+
+        char* text = dumpOptimizations ? printExpr(expr) : NULL;
+        if (existing != NULL) {
+            freeExpr(detachExpr(expr, existing->temp));
+            if (text != NULL) {
+                Token* temp = TOKEN_AT(existing->temp);
+                fprintf(stderr, "[line %d] licm: reused %.*s for %s\n", line, temp->length, temp->start, text);
+            }
+        } else {
+            TokenIndex temp = newTemp("licm", line);
+            Expr* value = detachExpr(expr, temp);
+            addStmt(declarations, newVarStmt(temp, value));
+
+            if (table->count >= table->capacity) {
+                int oldCapacity = table->capacity;
+                table->capacity = GROW_CAPACITY(oldCapacity);
+                table->entries = GROW_ARRAY(Hoisted, table->entries, oldCapacity, table->capacity);
+            }
+            table->entries[table->count].value = value;
+            table->entries[table->count].temp = temp;
+            table->count++;
+
+            if (text != NULL) {
+                fprintf(stderr, "[line %d] licm: hoisted %s out of loop into %.*s\n", line, text,
+                        TOKEN_AT(temp)->length, TOKEN_AT(temp)->start);
+            }
+        }
+        free(text);
+    }
+}
+
+static void hoistLoopInvariants(Stmt* stmt) {
+    WhileStmt* loop = &stmt->as.whileStmt;
+    Expr* condition = AS_EXPR(loop->condition);
+    Stmt* body = AS_STMT(loop->body);
+
+    Effects effects;
+    initEffects(&effects);
+    scanExpr(condition, &effects);
+    scanStmt(body, &effects);
+    scanExpr(AS_EXPR(loop->increment), &effects);
+
+    // the condition always runs once on entry. the body only runs when the
+    // condition holds, so its invariants need a guard, which evaluates the
+    // condition an extra time and is therefore only done for pure conditions.
+    Candidates fromCondition = { NULL, 0, 0, false, false };
+    Candidates fromBody = { NULL, 0, 0, false, false };
+    collectCandidates(&effects, condition, &fromCondition);
+    if (isPure(condition)) {
+        collectFromBody(&effects, body, &fromBody);
+    }
+
+    if (fromCondition.count > 0 || fromBody.count > 0) {
+        HoistTable table = { NULL, 0, 0 };
+        StmtListBuilder entry;
+        StmtListBuilder guarded;
+        initStmtListBuilder(&entry);
+        initStmtListBuilder(&guarded);
+
+        hoistCandidates(&fromCondition, &table, &entry);
+        hoistCandidates(&fromBody, &table, &guarded);
+
+        // { chope $a = ..; can (cond) { chope $b = ..; keep doing (cond) body } }
+        Stmt* result = newWhileStmt(condition, body);
+        result->as.whileStmt.increment = loop->increment;
+        if (guarded.count > 0) {
+            addStmt(&guarded, result);
+            result = newIfStmt(cloneExpr(condition), newBlockStmt(buildStmtList(&guarded)), NULL);
+        }
+        if (entry.count > 0) {
+            addStmt(&entry, result);
+            result = newBlockStmt(buildStmtList(&entry));
+        }
+
+        // rewrite in place so the parent keeps pointing at the same node
+        *stmt = *result; // result itself stays behind in the AST pool
+
+        FREE_ARRAY(Hoisted, table.entries, table.capacity);
+    }
+
+    FREE_ARRAY(Expr*, fromCondition.exprs, fromCondition.capacity);
+    FREE_ARRAY(Expr*, fromBody.exprs, fromBody.capacity);
+    freeEffects(&effects);
+}
+
+// --- Common Subexpression Elimination ---
+// within one straight-line statement list, a pure expression that was already
+// computed, and whose variables cannot have changed since, is read back from
+// a temporary. the first occurrence turns into ($cseN = expr) and a
+// "chope $cseN" is placed in front of its statement.
+
+typedef struct {
+    Expr* expr; // first occurrence
+    int site; // where the statement it belongs to is in the list
+    TokenIndex temp;
+    bool named; // first occurrence already stores into temp
+} Available;
+
+// a declaration to go in front of the statement at some site once the list
+// is done, see insertBefore
+typedef struct {
+    Stmt* stmt;
+    int previous; // the one inserted at the same site before it, -1 if none
+} Insertion;
+
+typedef struct {
+    Available* entries;
+    int count;
+    int capacity;
+    Insertion* insertions;
+    int insertionCount;
+    int insertionCapacity;
+    int* latest; // by site, the last insertion there or -1. NULL until the first
+    int siteCount;
+} AvailableTable;
+
+typedef struct {
+    TokenIndex temp;
+    Expr* value;
+} CseTemp;
+
+// what each $cse temporary holds, for comparing expressions that already
+// read one
+static CseTemp* cseTemps = NULL;
+static int cseTempCount = 0;
+static int cseTempCapacity = 0;
+
+static Expr* cseTempValue(Token* name) {
+    if (name->length == 0 || name->start[0] != '$') return NULL;
+    for (int i = 0; i < cseTempCount; i++) {
+        Token* temp = TOKEN_AT(cseTemps[i].temp);
+        if (temp->symbol == name->symbol) {
+            return cseTemps[i].value;
+        }
+    }
+    return NULL;
+}
+
+// look through groupings and temporaries to the expression computed
+static Expr* cseUnwrap(Expr* expr) {
+    for (;;) {
+        if (expr->type == EXPR_GROUPING) {
+            expr = AS_EXPR(expr->as.grouping.expression);
+        } else if (expr->type == EXPR_ASSIGN && cseTempValue(TOKEN_AT(expr->as.assign.name)) != NULL) {
+            expr = AS_EXPR(expr->as.assign.value);
+        } else if (expr->type == EXPR_VARIABLE && cseTempValue(TOKEN_AT(expr->as.variable.name)) != NULL) {
+            expr = cseTempValue(TOKEN_AT(expr->as.variable.name));
+        } else {
+            return expr;
+        }
+    }
+}
+
+static bool cseEquals(Expr* a, Expr* b) {
+    a = cseUnwrap(a);
+    b = cseUnwrap(b);
+    if (a->type != b->type) return false;
+    switch (a->type) {
+        case EXPR_UNARY:
+            return TOKEN_AT(a->as.unary.oper)->type == TOKEN_AT(b->as.unary.oper)->type &&
+                   cseEquals(AS_EXPR(a->as.unary.right), AS_EXPR(b->as.unary.right));
+        case EXPR_BINARY:
+            return TOKEN_AT(a->as.binary.oper)->type == TOKEN_AT(b->as.binary.oper)->type &&
+                   cseEquals(AS_EXPR(a->as.binary.left), AS_EXPR(b->as.binary.left)) &&
+                   cseEquals(AS_EXPR(a->as.binary.right), AS_EXPR(b->as.binary.right));
+        case EXPR_LOGICAL:
+            return TOKEN_AT(a->as.logical.oper)->type == TOKEN_AT(b->as.logical.oper)->type &&
+                   cseEquals(AS_EXPR(a->as.logical.left), AS_EXPR(b->as.logical.left)) &&
+                   cseEquals(AS_EXPR(a->as.logical.right), AS_EXPR(b->as.logical.right));
+        default:
+            return exprEquals(a, b);
+    }
+}
+
+static bool readsAny(Expr* expr, NameSet* names) {
+    expr = cseUnwrap(expr);
+    switch (expr->type) {
+        case EXPR_VARIABLE:
+            return nameSetContains(names, TOKEN_AT(expr->as.variable.name));
+        case EXPR_UNARY:
+            return readsAny(AS_EXPR(expr->as.unary.right), names);
+        case EXPR_BINARY:
+            return readsAny(AS_EXPR(expr->as.binary.left), names) || readsAny(AS_EXPR(expr->as.binary.right), names);
+        case EXPR_LOGICAL:
+            return readsAny(AS_EXPR(expr->as.logical.left), names) || readsAny(AS_EXPR(expr->as.logical.right), names);
+        default:
+            return false;
+    }
+}
+
+// operators over variables and literals. a lone unary on a leaf is about as
+// cheap as reading a temporary back.
+static bool isCseCandidate(Expr* expr) {
+    if (!isPure(expr)) return false;
+    if (expr->type == EXPR_BINARY) return true;
+    if (expr->type == EXPR_UNARY) {
+        ExprType operand = AS_EXPR(expr->as.unary.right)->type;
+        return operand != EXPR_LITERAL && operand != EXPR_VARIABLE;
+    }
+    return false;
+}
+
+static void killNames(AvailableTable* table, NameSet* names) {
+    int kept = 0;
+    for (int i = 0; i < table->count; i++) {
+        if (!readsAny(table->entries[i].expr, names)) {
+            table->entries[kept++] = table->entries[i];
+        }
+    }
+    table->count = kept;
+}
+
+static void killName(AvailableTable* table, Token name) {
+    NameSet names;
+    initNameSet(&names);
+    nameSetAdd(&names, name);
+    killNames(table, &names);
+    freeNameSet(&names);
+}
+
+static void killEffects(AvailableTable* table, Effects* effects) {
+    killNames(table, &effects->assigned);
+    if (effects->hasCall) killNames(table, &functionAssigned);
+}
+
+// the list is rebuilt with them once it is done (see cseStmtList), until then
+// every site stays where it is
+static void insertBefore(AvailableTable* table, int site, Stmt* stmt) {
+    if (table->latest == NULL) {
+        table->latest = ALLOCATE(int, table->siteCount);
+        for (int i = 0; i < table->siteCount; i++) table->latest[i] = -1;
+    }
+    if (table->insertionCount >= table->insertionCapacity) {
+        int oldCapacity = table->insertionCapacity;
+        table->insertionCapacity = GROW_CAPACITY(oldCapacity);
+        table->insertions = GROW_ARRAY(Insertion, table->insertions, oldCapacity, table->insertionCapacity);
+    }
+    table->insertions[table->insertionCount] = (Insertion) { stmt, table->latest[site] };
+    table->latest[site] = table->insertionCount++;
+}
+
+static void reuseAvailable(AvailableTable* table, Available* entry, Expr* expr) {
+    if (!entry->named) {
+        entry->temp = newTemp("cse", exprLine(entry->expr));
+        insertBefore(table, entry->site, newVarStmt(entry->temp, NULL));
+
+        Expr* value = detachExpr(entry->expr, entry->temp);
+        entry->expr->type = EXPR_ASSIGN;
+        entry->expr->as.assign.name = entry->temp;
+        entry->expr->as.assign.value = nodeIndex(value);
+        entry->expr->as.assign.upvalue = -1;
+        entry->named = true;
+
+        if (cseTempCount >= cseTempCapacity) {
+            int oldCapacity = cseTempCapacity;
+            cseTempCapacity = GROW_CAPACITY(oldCapacity);
+            cseTemps = GROW_ARRAY(CseTemp, cseTemps, oldCapacity, cseTempCapacity);
+        }
+        cseTemps[cseTempCount].temp = entry->temp;
+        cseTemps[cseTempCount].value = value;
+        cseTempCount++;
+    }
+
+    if (dumpOptimizations) {
+        char* text = printExpr(expr);
+        Token* temp = TOKEN_AT(entry->temp);
+        fprintf(stderr, "[line %d] cse: reused %.*s for %s\n", exprLine(expr), temp->length, temp->start, text);
+        free(text);
+    }
+    freeExpr(detachExpr(expr, entry->temp));
+}
+
+// walks expr in evaluation order. canAdd is false where the code might not
+// run, so nothing computed there can be relied on later.
+static void cseExpr(AvailableTable* table, Expr* expr, int site, bool canAdd) {
+    if (expr == NULL) return;
+
+    bool candidate = isCseCandidate(expr);
+    if (candidate) {
+        for (int i = 0; i < table->count; i++) {
+            if (cseEquals(table->entries[i].expr, expr)) {
+                reuseAvailable(table, &table->entries[i], expr);
+                return;
+            }
+        }
+    }
+
+    switch (expr->type) {
+        case EXPR_GROUPING:
+            cseExpr(table, AS_EXPR(expr->as.grouping.expression), site, canAdd);
+            break;
+        case EXPR_UNARY:
+            cseExpr(table, AS_EXPR(expr->as.unary.right), site, canAdd);
+            break;
+        case EXPR_BINARY:
+            cseExpr(table, AS_EXPR(expr->as.binary.left), site, canAdd);
+            cseExpr(table, AS_EXPR(expr->as.binary.right), site, canAdd);
+            break;
+        case EXPR_LOGICAL:
+            cseExpr(table, AS_EXPR(expr->as.logical.left), site, canAdd);
+            cseExpr(table, AS_EXPR(expr->as.logical.right), site, false);
+            break;
+        case EXPR_CALL:
+            cseExpr(table, AS_EXPR(expr->as.call.callee), site, canAdd);
+            for (int i = 0; i < expr->as.call.arg_count; i++) {
+                cseExpr(table, CALL_ARGUMENT(&expr->as.call, i), site, canAdd);
+            }
+            killNames(table, &functionAssigned);
+            break;
+        case EXPR_ASSIGN:
+            cseExpr(table, AS_EXPR(expr->as.assign.value), site, canAdd);
+            killName(table, *TOKEN_AT(expr->as.assign.name));
+            break;
+        default:
+            break;
+    }
+
+    if (candidate && canAdd) {
+        if (table->count >= table->capacity) {
+            int oldCapacity = table->capacity;
+            table->capacity = GROW_CAPACITY(oldCapacity);
+            table->entries = GROW_ARRAY(Available, table->entries, oldCapacity, table->capacity);
+        }
+        Available* entry = &table->entries[table->count++];
+        entry->expr = expr;
+        entry->site = site;
+        entry->named = false;
+    }
+}
+
+static StmtList* cseStmtList(StmtList* list);
+
+// statement lists nested in stmt get their own tables
+static void cseNested(Stmt* stmt) {
+    if (stmt == NULL) return;
+    switch (stmt->type) {
+        case STMT_BLOCK:
+            stmt->as.block.statements = nodeIndex(cseStmtList(AS_STMT_LIST(stmt->as.block.statements)));
+            break;
+        case STMT_IF:
+            cseNested(AS_STMT(stmt->as.ifStmt.thenBranch));
+            cseNested(AS_STMT(stmt->as.ifStmt.elseBranch));
+            break;
+        case STMT_WHILE:
+            cseNested(AS_STMT(stmt->as.whileStmt.body));
+            break;
+        case STMT_FUNCTION:
+            AS_FUNCTION_STMT(stmt)->body = nodeIndex(cseStmtList(AS_STMT_LIST(AS_FUNCTION_STMT(stmt)->body)));
+            break;
+        default:
+            break;
+    }
+}
+
+static void cseStmt(AvailableTable* table, Stmt* stmt, int site) {
+    Effects effects;
+    initEffects(&effects);
+
+    switch (stmt->type) {
+        case STMT_EXPRESSION:
+            cseExpr(table, AS_EXPR(stmt->as.expression.expression), site, true);
+            break;
+        case STMT_PRINT:
+            cseExpr(table, AS_EXPR(stmt->as.print.expression), site, true);
+            break;
+        case STMT_RETURN:
+            cseExpr(table, AS_EXPR(stmt->as.return_stmt.value), site, true);
+            break;
+        case STMT_VAR:
+            cseExpr(table, AS_EXPR(stmt->as.var.initializer), site, true);
+            killName(table, *TOKEN_AT(stmt->as.var.name));
+            break;
+        case STMT_FUNCTION:
+            killName(table, *TOKEN_AT(AS_FUNCTION_STMT(stmt)->name));
+            break;
+        case STMT_IF:
+            // the condition always runs, the branches are separate lists
+            cseExpr(table, AS_EXPR(stmt->as.ifStmt.condition), site, true);
+            scanStmt(AS_STMT(stmt->as.ifStmt.thenBranch), &effects);
+            scanStmt(AS_STMT(stmt->as.ifStmt.elseBranch), &effects);
+            killEffects(table, &effects);
+            break;
+        case STMT_WHILE:
+        case STMT_BLOCK:
+            scanStmt(stmt, &effects);
+            killEffects(table, &effects);
+            break;
+        case STMT_BREAK:
+        case STMT_CONTINUE:
+            break;
+    }
+
+    freeEffects(&effects);
+}
+
+// list with the declarations put in front of its statements, a new list if
+// there are any
+static StmtList* cseStmtList(StmtList* list) {
+    AvailableTable table = { NULL, 0, 0, NULL, 0, 0, NULL, STMT_COUNT(list) };
+    for (int i = 0; i < STMT_COUNT(list); i++) {
+        Stmt* stmt = LIST_STMT(list, i);
+        cseStmt(&table, stmt, i);
+        cseNested(stmt);
+    }
+
+    if (table.insertionCount > 0) {
+        StmtListBuilder rebuilt;
+        initStmtListBuilder(&rebuilt);
+        for (int i = 0; i < STMT_COUNT(list); i++) {
+            // the last one inserted goes first, as if each went right in front
+            for (int at = table.latest[i]; at != -1; at = table.insertions[at].previous) {
+                addStmt(&rebuilt, table.insertions[at].stmt);
+            }
+            addStmt(&rebuilt, LIST_STMT(list, i));
+        }
+        list = buildStmtList(&rebuilt);
+    }
+
+    FREE_ARRAY(Available, table.entries, table.capacity);
+    FREE_ARRAY(Insertion, table.insertions, table.insertionCapacity);
+    FREE_ARRAY(int, table.latest, table.siteCount);
+    return list;
+}
+
+static StmtList* eliminateCommonSubexpressions(StmtList* statements) {
+    statements = cseStmtList(statements);
+    FREE_ARRAY(CseTemp, cseTemps, cseTempCapacity);
+    cseTemps = NULL;
+    cseTempCount = 0;
+    cseTempCapacity = 0;
+    return statements;
+}
+
+// --- Purity Analysis ---
+// a function is pure when it only reads its own parameters and locals, never
+// prints, and only calls pure functions. such calls can be memoized.
+
+typedef struct {
+    NameSet locals; // parameters and locals in scope
+    NameSet callees; // globals called by name, must turn out pure as well
+    bool pure;
+} PurityScan;
+
+static void purityStmt(PurityScan* scan, Stmt* stmt);
+
+static void purityExpr(PurityScan* scan, Expr* expr) {
+    if (expr == NULL || !scan->pure) return;
+    switch (expr->type) {
+        case EXPR_VARIABLE:
+            if (!nameSetContains(&scan->locals, TOKEN_AT(expr->as.variable.name))) scan->pure = false;
+            break;
+        case EXPR_ASSIGN:
+            if (!nameSetContains(&scan->locals, TOKEN_AT(expr->as.assign.name))) scan->pure = false;
+            purityExpr(scan, AS_EXPR(expr->as.assign.value));
+            break;
+        case EXPR_CALL: {
+            Expr* callee = AS_EXPR(expr->as.call.callee);
+            if (callee->type == EXPR_VARIABLE && !nameSetContains(&scan->locals, TOKEN_AT(callee->as.variable.name))) {
+                nameSetAdd(&scan->callees, *TOKEN_AT(callee->as.variable.name));
+            } else {
+                // calling a function value we cannot see
+                scan->pure = false;
+            }
+            for (int i = 0; i < expr->as.call.arg_count; i++) {
+                purityExpr(scan, CALL_ARGUMENT(&expr->as.call, i));
+            }
+            break;
+        }
+        case EXPR_BINARY:
+            purityExpr(scan, AS_EXPR(expr->as.binary.left));
+            purityExpr(scan, AS_EXPR(expr->as.binary.right));
+            break;
+        case EXPR_LOGICAL:
+            purityExpr(scan, AS_EXPR(expr->as.logical.left));
+            purityExpr(scan, AS_EXPR(expr->as.logical.right));
+            break;
+        case EXPR_UNARY:
+            purityExpr(scan, AS_EXPR(expr->as.unary.right));
+            break;
+        case EXPR_GROUPING:
+            purityExpr(scan, AS_EXPR(expr->as.grouping.expression));
+            break;
+        default:
+            break;
+    }
+}
+
+static void purityStmtList(PurityScan* scan, StmtList* list) {
+    for (int i = 0; i < STMT_COUNT(list) && scan->pure; i++) {
+        purityStmt(scan, LIST_STMT(list, i));
+    }
+}
+
+static void purityStmt(PurityScan* scan, Stmt* stmt) {
+    if (stmt == NULL || !scan->pure) return;
+    switch (stmt->type) {
+        case STMT_PRINT:
+        case STMT_FUNCTION:
+            // output, or a closure over our locals
+            scan->pure = false;
+            break;
+        case STMT_EXPRESSION:
+            purityExpr(scan, AS_EXPR(stmt->as.expression.expression));
+            break;
+        case STMT_VAR:
+            // the initializer still sees the outer binding
+            purityExpr(scan, AS_EXPR(stmt->as.var.initializer));
+            nameSetAdd(&scan->locals, *TOKEN_AT(stmt->as.var.name));
+            break;
+        case STMT_BLOCK: {
+            int mark = scan->locals.count;
+            purityStmtList(scan, AS_STMT_LIST(stmt->as.block.statements));
+            scan->locals.count = mark;
+            break;
+        }
+        case STMT_IF:
+            purityExpr(scan, AS_EXPR(stmt->as.ifStmt.condition));
+            purityStmt(scan, AS_STMT(stmt->as.ifStmt.thenBranch));
+            purityStmt(scan, AS_STMT(stmt->as.ifStmt.elseBranch));
+            break;
+        case STMT_WHILE:
+            purityExpr(scan, AS_EXPR(stmt->as.whileStmt.condition));
+            purityStmt(scan, AS_STMT(stmt->as.whileStmt.body));
+            purityExpr(scan, AS_EXPR(stmt->as.whileStmt.increment));
+            break;
+        case STMT_RETURN:
+            purityExpr(scan, AS_EXPR(stmt->as.return_stmt.value));
+            break;
+        case STMT_BREAK:
+        case STMT_CONTINUE:
+            break;
+    }
+}
+
+// only top-level functions are considered. a callee name must be bound
+// exactly once at the top level and never reassigned, otherwise the call
+// might reach something else later.
+static void markPureFunctions(StmtList* statements) {
+    NameSet declared;
+    NameSet redeclared;
+    initNameSet(&declared);
+    initNameSet(&redeclared);
+
+    Effects effects;
+    initEffects(&effects);
+    int functionCount = 0;
+    for (int i = 0; i < STMT_COUNT(statements); i++) {
+        Stmt* stmt = LIST_STMT(statements, i);
+        scanStmt(stmt, &effects);
+
+        Token* name = NULL;
+        if (stmt->type == STMT_FUNCTION) {
+            name = TOKEN_AT(AS_FUNCTION_STMT(stmt)->name);
+            functionCount++;
+        } else if (stmt->type == STMT_VAR) {
+            name = TOKEN_AT(stmt->as.var.name);
+        }
+        if (name == NULL) continue;
+        if (nameSetContains(&declared, name)) {
+            nameSetAdd(&redeclared, *name);
+        } else {
+            nameSetAdd(&declared, *name);
+        }
+    }
+
+    Stmt** functions = ALLOCATE(Stmt*, functionCount > 0 ? functionCount : 1);
+    PurityScan* scans = ALLOCATE(PurityScan, functionCount > 0 ? functionCount : 1);
+    int count = 0;
+    for (int i = 0; i < STMT_COUNT(statements); i++) {
+        Stmt* stmt = LIST_STMT(statements, i);
+        if (stmt->type != STMT_FUNCTION) continue;
+
+        PurityScan* scan = &scans[count];
+        functions[count++] = stmt;
+        initNameSet(&scan->locals);
+        initNameSet(&scan->callees);
+        FunctionStmt* function = AS_FUNCTION_STMT(stmt);
+        Token* name = TOKEN_AT(function->name);
+        // a body the parser skipped can't be checked
+        scan->pure = function->lazy.start == NULL && !nameSetContains(&redeclared, name) &&
+                     !nameSetContains(&effects.assigned, name);
+        for (int i = 0; i < function->param_count; i++) {
+            nameSetAdd(&scan->locals, *TOKEN_AT(function->params + i));
+        }
+        purityStmtList(scan, AS_STMT_LIST(function->body));
+    }
+
+    // drop functions calling anything impure until nothing changes. a name
+    // declared twice is impure under both declarations
+    NameSet named; // by a top-level function
+    NameSet impure;
+    initNameSet(&named);
+    initNameSet(&impure);
+    for (int i = 0; i < count; i++) {
+        nameSetAdd(&named, *TOKEN_AT(AS_FUNCTION_STMT(functions[i])->name));
+        if (!scans[i].pure) nameSetAdd(&impure, *TOKEN_AT(AS_FUNCTION_STMT(functions[i])->name));
+    }
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int i = 0; i < count; i++) {
+            if (!scans[i].pure) continue;
+            for (int c = 0; c < scans[i].callees.count && scans[i].pure; c++) {
+                Token* callee = &scans[i].callees.names[c];
+                if (!nameSetContains(&named, callee) || nameSetContains(&impure, callee)) {
+                    scans[i].pure = false;
+                    nameSetAdd(&impure, *TOKEN_AT(AS_FUNCTION_STMT(functions[i])->name));
+                    changed = true;
+                }
+            }
+        }
+    }
+    freeNameSet(&named);
+    freeNameSet(&impure);
+
+    for (int i = 0; i < count; i++) {
+        AS_FUNCTION_STMT(functions[i])->pure = scans[i].pure;
+        if (scans[i].pure && dumpOptimizations) {
+            Token name = *TOKEN_AT(AS_FUNCTION_STMT(functions[i])->name);
+            fprintf(stderr, "[line %d] purity: %.*s is pure, calls can be memoized\n", name.line, name.length, name.start);
+        }
+        freeNameSet(&scans[i].locals);
+        freeNameSet(&scans[i].callees);
+    }
+
+    FREE_ARRAY(Stmt*, functions, functionCount);
+    FREE_ARRAY(PurityScan, scans, functionCount);
+    freeEffects(&effects);
+    freeNameSet(&declared);
+    freeNameSet(&redeclared);
+}
+
+// --- Driver ---
+
+static void optimizeStmt(Stmt* stmt);
+
+static void optimizeStmtList(StmtList* list) {
+    for (int i = 0; i < STMT_COUNT(list); i++) {
+        optimizeStmt(LIST_STMT(list, i));
+    }
+}
+
+static void optimizeStmt(Stmt* stmt) {
+    if (stmt == NULL) return;
+    switch (stmt->type) {
+        case STMT_VAR:
+            if (scopeDepth > 0) nameSetAdd(&locals, *TOKEN_AT(stmt->as.var.name));
+            break;
+        case STMT_BLOCK: {
+            int mark = locals.count;
+            scopeDepth++;
+            optimizeStmtList(AS_STMT_LIST(stmt->as.block.statements));
+            scopeDepth--;
+            locals.count = mark;
+            break;
+        }
+        case STMT_FUNCTION: {
+            if (scopeDepth > 0) nameSetAdd(&locals, *TOKEN_AT(AS_FUNCTION_STMT(stmt)->name));
+            int mark = locals.count;
+            scopeDepth++;
+            for (int i = 0; i < AS_FUNCTION_STMT(stmt)->param_count; i++) {
+                nameSetAdd(&locals, *TOKEN_AT(AS_FUNCTION_STMT(stmt)->params + i));
+            }
+            optimizeStmtList(AS_STMT_LIST(AS_FUNCTION_STMT(stmt)->body));
+            scopeDepth--;
+            locals.count = mark;
+            break;
+        }
+        case STMT_IF:
+            optimizeStmt(AS_STMT(stmt->as.ifStmt.thenBranch));
+            optimizeStmt(AS_STMT(stmt->as.ifStmt.elseBranch));
+            break;
+        case STMT_WHILE:
+            // inner loops first, their temporaries then count as declared
+            // inside the outer loop
+            optimizeStmt(AS_STMT(stmt->as.whileStmt.body));
+            hoistLoopInvariants(stmt);
+            break;
+        default:
+            break;
+    }
+}
+
+StmtList* optimize(StmtList* statements, bool dump) {
+    dumpOptimizations = dump;
+
+    Effects functionEffects;
+    initEffects(&functionEffects);
+    scanProgramFunctions(statements, &functionEffects);
+    functionAssigned = functionEffects.assigned;
+
+    markPureFunctions(statements);
+
+    // licm needs to know which invariants cannot fail, see canFail
+    inferTypes(statements, false);
+
+    initNameSet(&locals);
+    scopeDepth = 0;
+    optimizeStmtList(statements);
+    // after licm, so invariants leave the loop before temporaries tie them to it
+    statements = eliminateCommonSubexpressions(statements);
+
+    freeNameSet(&locals);
+    freeEffects(&functionEffects);
+    initNameSet(&functionAssigned);
+
+    // last, so it also covers the temporaries introduced above
+    inferTypes(statements, dump);
+    return statements;
+}
+
+void optimizeFunction(Stmt* function, StmtList* program) {
+    if (!scannedProgram) {
+        initEffects(&programEffects);
+        scanProgramFunctions(program, &programEffects);
+        scannedProgram = true;
+    }
+    functionAssigned = programEffects.assigned;
+
+    // as optimize() would have done it, apart from purity, which is a
+    // property of the whole program and was settled without this body
+    inferFunctionTypes(function, &programEffects.assigned);
+    initNameSet(&locals);
+    scopeDepth = 0;
+    optimizeStmt(function);
+    cseNested(function);
+
+    freeNameSet(&locals);
+    initNameSet(&functionAssigned);
+
+    inferFunctionTypes(function, &programEffects.assigned);
+}
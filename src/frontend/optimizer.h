@@ -0,0 +1,22 @@
+#ifndef sg_optimizer_h
+#define sg_optimizer_h
+
+#include "../ast/stmt.h"
+#include <stdbool.h>
+
+// run the AST-level optimisation passes over a resolved program.
+// statements are rewritten in place, apart from the top-level list itself:
+// the program to run is the list returned. when dump is true every
+// transformation is reported on stderr.
+StmtList* optimize(StmtList* statements, bool dump);
+
+// the same for the body of a function the parser skipped (see
+// parseFunctionBody), once it is parsed and resolved. program is what it was
+// declared in, the analyses need every function body any call may reach.
+void optimizeFunction(Stmt* function, StmtList* program);
+
+// free the names of compiler-introduced temporaries. call this only after
+// the statements passed to optimize() and optimizeFunction() have been freed.
+void freeOptimizer();
+
+#endif
@@ -1,6 +1,7 @@
 #include "parser.h"
 #include "../ast/expr.h"
 #include "../ast/stmt.h"
+#include "../runtime/memory.h"
 #include "scanner.h"
 #include <stdbool.h>
 #include <stdio.h>
@@ -8,27 +9,16 @@
 #include <string.h>
 
 static Expr* expression(Parser* parser);
-static Expr* assignment(Parser* parser);
-static Expr* or (Parser * parser);
-static Expr* and (Parser * parser);
-static Expr* equality(Parser* parser);
-static Expr* comparison(Parser* parser);
-static Expr* term(Parser* parser);
-static Expr* factor(Parser* parser);
-static Expr* unary(Parser* parser);
-static Expr* call(Parser* parser);
-static Expr* primary(Parser* parser);
-static Expr* finishCall(Parser* parser, Expr* callee);
 
 static bool match(Parser* parser, TokenType type);
 static bool check(Parser* parser, TokenType type);
-static Token advance(Parser* parser);
-static Token peek(Parser* parser);
-static Token previous(Parser* parser);
+static Token* advance(Parser* parser);
+static Token* peek(Parser* parser);
+static Token* previous(Parser* parser);
 static bool isAtEnd(Parser* parser);
-static Token consume(Parser* parser, TokenType type, const char* message);
+static Token* consume(Parser* parser, TokenType type, const char* message);
 static void synchronize(Parser* parser);
-static void error(Parser* parser, Token token, const char* message);
+static void error(Parser* parser, Token* token, const char* message);
 
 static Stmt* declaration(Parser* parser);
 static Stmt* function(Parser* parser, const char* kind);
@@ -38,23 +28,41 @@ static Stmt* ifStatement(Parser* parser);
 static Stmt* printStatement(Parser* parser);
 static Stmt* whileStatement(Parser* parser);
 static Stmt* returnStatement(Parser* parser);
+static Stmt* jumpStatement(Parser* parser, StmtType type);
 static Stmt* expressionStatement(Parser* parser);
 static Stmt* varDeclaration(Parser* parser);
+static StaticType typeAnnotation(Parser* parser);
 static StmtList* block(Parser* parser); // Returns a list for BlockStmt
+static bool skipBody(Parser* parser, LazyBody* lazy);
 
-void initParser(Parser* parser, Token* tokens, int count) {
-    parser->tokens = tokens;
-    parser->count = count;
+#define RING_SLOT(position) ((position) & (PARSER_LOOKAHEAD - 1))
+
+void initParser(Parser* parser, Scanner* scanner) {
+    parser->scanner = scanner;
+    for (int i = 0; i < PARSER_LOOKAHEAD; i++) {
+        parser->ring[i].type = TOKEN_EOF; // nothing before the first token
+    }
     parser->current = 0;
+    parser->ring[0] = scanToken(scanner);
     // overall result of parsing, whether we found any errors or not
     parser->hadError = false;
     // panic mode is the temp state, reset after synchronization happens, so we can handle more errors
     parser->panicMode = false;
+    parser->lazyBodies = false;
+    parser->depth = 0;
+}
+
+// error tokens own their message, free the ones still in the ring
+static void freeRing(Parser* parser) {
+    for (int i = 0; i < PARSER_LOOKAHEAD; i++) {
+        freeToken(parser->ring[i]);
+        parser->ring[i].type = TOKEN_EOF;
+    }
 }
 
 StmtList* parse(Parser* parser) {
-    StmtList* statements = NULL;
-    StmtList* tail = NULL;
+    StmtListBuilder statements;
+    initStmtListBuilder(&statements);
 
     while (!isAtEnd(parser)) {
         Stmt* decl = declaration(parser); // declaration handles synchronization on error
@@ -63,50 +71,73 @@ StmtList* parse(Parser* parser) {
             // free everything parsed so far at this top level and stop.
             // Internal structures (like block lists) should have been freed
             // by the function where the error occurred (e.g., block()).
-            freeStmtList(statements);
+            freeStmtList(buildStmtList(&statements));
+            freeRing(parser);
             return NULL;
         }
         if (decl != NULL) {
             // Add the successfully parsed statement to the list
-            StmtList* newNode = newStmtList(decl, NULL);
-            if (statements == NULL) {
-                statements = newNode;
-                tail = newNode;
-            } else {
-                tail->next = newNode;
-                tail = newNode;
-            }
+            addStmt(&statements, decl);
         }
         // If decl is NULL but no error, it might be an empty input or handled case.
     }
 
-    return statements;
+    freeRing(parser);
+    return buildStmtList(&statements);
+}
+
+Stmt* parseDeclaration(Parser* parser) {
+    while (!isAtEnd(parser)) {
+        Stmt* decl = declaration(parser);
+        if (parser->hadError) break;
+        if (decl != NULL) return decl;
+    }
+    freeRing(parser);
+    return NULL;
 }
 
 bool hadParserError(Parser* parser) {
     return parser->hadError;
 }
 
-static void errorAt(Parser* parser, Token token, const char* message) {
+bool parseFunctionBody(Stmt* function) {
+    LazyBody* lazy = &AS_FUNCTION_STMT(function)->lazy;
+    Scanner scanner;
+    initScanner(&scanner, lazy->start);
+    scanner.line = lazy->line;
+    Parser parser;
+    initParser(&parser, &scanner);
+
+    StmtList* body = block(&parser);
+    freeRing(&parser);
+    if (parser.hadError) return false;
+
+    AS_FUNCTION_STMT(function)->body = nodeIndex(body);
+    free(lazy->assigned);
+    *lazy = (LazyBody) { NULL, 0, NULL, 0 };
+    return true;
+}
+
+static void errorAt(Parser* parser, Token* token, const char* message) {
     if (parser->panicMode) return; // if we're already in panic mode, don't do anything
     parser->panicMode = true;
     parser->hadError = true;
 
-    fprintf(stderr, "[line %d] Aiyo problem sia:", token.line);
+    fprintf(stderr, "[line %d] Aiyo problem sia:", token->line);
 
-    if (token.type == TOKEN_EOF) {
+    if (token->type == TOKEN_EOF) {
         fprintf(stderr, " at end");
-    } else if (token.type == TOKEN_ERROR) {
+    } else if (token->type == TOKEN_ERROR) {
         // Nothing - error token already has message
         // fprintf(stderr, ""); // Ensure ':' is added
     } else {
-        fprintf(stderr, " at '%.*s'", token.length, token.start);
+        fprintf(stderr, " at '%.*s'", token->length, token->start);
     }
 
     fprintf(stderr, ": %s\n", message);
 }
 
-static void error(Parser* parser, Token token, const char* message) {
+static void error(Parser* parser, Token* token, const char* message) {
     errorAt(parser, token, message);
 }
 
@@ -115,25 +146,32 @@ static void errorAtCurrent(Parser* parser, const char* message) {
 }
 
 static bool isAtEnd(Parser* parser) {
-    return peek(parser).type == TOKEN_EOF;
+    return peek(parser)->type == TOKEN_EOF;
 }
 
-static Token previous(Parser* parser) {
-    return parser->tokens[parser->current - 1];
+// tokens are handed out as pointers into the ring. a slot is reused a few
+// tokens later, so anything kept while parsing on has to be copied out.
+static Token* previous(Parser* parser) {
+    return &parser->ring[RING_SLOT(parser->current - 1)];
 }
 
-static Token peek(Parser* parser) {
-    return parser->tokens[parser->current];
+static Token* peek(Parser* parser) {
+    return &parser->ring[RING_SLOT(parser->current)];
 }
 
-static Token advance(Parser* parser) {
-    if (!isAtEnd(parser)) parser->current++;
+static Token* advance(Parser* parser) {
+    if (!isAtEnd(parser)) {
+        parser->current++;
+        Token* next = &parser->ring[RING_SLOT(parser->current)];
+        freeToken(*next); // the token that used to be here
+        *next = scanToken(parser->scanner);
+    }
     return previous(parser);
 }
 
 static bool check(Parser* parser, TokenType type) {
     if (isAtEnd(parser)) return false;
-    return peek(parser).type == type;
+    return peek(parser)->type == type;
 }
 
 static bool match(Parser* parser, TokenType type) {
@@ -144,7 +182,7 @@ static bool match(Parser* parser, TokenType type) {
     return false;
 }
 
-static Token consume(Parser* parser, TokenType type, const char* message) {
+static Token* consume(Parser* parser, TokenType type, const char* message) {
     if (type == TOKEN_SEMICOLON && check(parser, TOKEN_LAH)) {
         return advance(parser);
     }
@@ -163,9 +201,9 @@ static void synchronize(Parser* parser) {
     parser->panicMode = false;
 
     while (!isAtEnd(parser)) {
-        if (previous(parser).type == TOKEN_SEMICOLON) return;
+        if (previous(parser)->type == TOKEN_SEMICOLON) return;
 
-        switch (peek(parser).type) {
+        switch (peek(parser)->type) {
             case TOKEN_CLASS:
             case TOKEN_HOWDO:
             case TOKEN_CHOPE:
@@ -174,6 +212,8 @@ static void synchronize(Parser* parser) {
             case TOKEN_KEEP_DOING:
             case TOKEN_PRINT:
             case TOKEN_RETURN:
+            case TOKEN_CABUT:
+            case TOKEN_CARRY_ON:
                 return; // Start parsing from the next likely statement beginning
             default:
                 // Do nothing, just advance
@@ -207,11 +247,24 @@ static Stmt* declaration(Parser* parser) {
     return stmt;
 }
 
-// function ->  "(" parameters? ")"
+// typeAnnotation -> "number" | "string" | "bool", after the ':'
+static StaticType typeAnnotation(Parser* parser) {
+    Token* type = consume(parser, TOKEN_IDENTIFIER, "After ':' must say what type leh.");
+    if (parser->hadError) return STATIC_UNKNOWN;
+
+    if (type->length == 6 && memcmp(type->start, "number", 6) == 0) return STATIC_NUMBER;
+    if (type->length == 6 && memcmp(type->start, "string", 6) == 0) return STATIC_STRING;
+    if (type->length == 4 && memcmp(type->start, "bool", 4) == 0) return STATIC_BOOL;
+    error(parser, type, "Dunno this type leh. Only number, string or bool can.");
+    return STATIC_UNKNOWN;
+}
+
+// function ->  "(" parameters? ")" ( ":" type )?
+// parameters -> IDENTIFIER ( ":" type )? ( "," IDENTIFIER ( ":" type )? )*
 static Stmt* function(Parser* parser, const char* kind) {
     char message[64];
     snprintf(message, sizeof(message), "Where the %s name ah?", kind);
-    Token name = consume(parser, TOKEN_IDENTIFIER, message);
+    Token name = *consume(parser, TOKEN_IDENTIFIER, message);
     if (parser->hadError) return NULL;
 
     consume(parser, TOKEN_LEFT_PAREN, "Aiyo, after function name must have '(' one lah!");
@@ -219,6 +272,7 @@ static Stmt* function(Parser* parser, const char* kind) {
 
     // Parse parameters
     Token* parameters = NULL;
+    StaticType* paramTypes = NULL; // only allocated once some parameter is annotated
     int param_count = 0;
 
     if (!check(parser, TOKEN_RIGHT_PAREN)) {
@@ -226,23 +280,52 @@ static Stmt* function(Parser* parser, const char* kind) {
             if (param_count >= 255) {
                 error(parser, peek(parser), "Walao, too many parameters sia. Max 255 can already!");
                 free(parameters);
+                free(paramTypes);
                 return NULL;
             }
 
-            Token param = consume(parser, TOKEN_IDENTIFIER, "Eh where your parameter name sia?");
+            Token param = *consume(parser, TOKEN_IDENTIFIER, "Eh where your parameter name sia?");
             if (parser->hadError) {
                 free(parameters);
+                free(paramTypes);
                 return NULL;
             }
 
+            StaticType paramType = STATIC_UNKNOWN;
+            if (match(parser, TOKEN_COLON)) {
+                paramType = typeAnnotation(parser);
+                if (parser->hadError) {
+                    free(parameters);
+                    free(paramTypes);
+                    return NULL;
+                }
+            }
+
             Token* new_params = (Token*)realloc(parameters, sizeof(Token) * (param_count + 1));
             if (new_params == NULL) {
-                error(parser, param, "Memory problem lah, cannot allocate for parameters ok.");
+                error(parser, &param, "Memory problem lah, cannot allocate for parameters ok.");
                 free(parameters);
+                free(paramTypes);
                 return NULL;
             }
             parameters = new_params;
 
+            if (paramTypes != NULL || paramType != STATIC_UNKNOWN) {
+                StaticType* new_types = (StaticType*)realloc(paramTypes, sizeof(StaticType) * (param_count + 1));
+                if (new_types == NULL) {
+                    error(parser, &param, "Memory problem lah, cannot allocate for parameters ok.");
+                    free(parameters);
+                    free(paramTypes);
+                    return NULL;
+                }
+                // parameters before the first annotated one are untyped
+                for (int i = paramTypes == NULL ? 0 : param_count; i < param_count; i++) {
+                    new_types[i] = STATIC_UNKNOWN;
+                }
+                paramTypes = new_types;
+                paramTypes[param_count] = paramType;
+            }
+
             parameters[param_count] = param;
             param_count++;
         } while (match(parser, TOKEN_COMMA));
@@ -251,20 +334,103 @@ static Stmt* function(Parser* parser, const char* kind) {
     consume(parser, TOKEN_RIGHT_PAREN, "Aiyo, after parameters must close with ')' leh!");
     if (parser->hadError) {
         free(parameters);
+        free(paramTypes);
         return NULL;
     }
 
+    StaticType returnType = STATIC_UNKNOWN;
+    if (match(parser, TOKEN_COLON)) {
+        returnType = typeAnnotation(parser);
+        if (parser->hadError) {
+            free(parameters);
+            free(paramTypes);
+            return NULL;
+        }
+    }
+
+    if (parser->lazyBodies && parser->depth == 0) {
+        LazyBody lazy;
+        if (!skipBody(parser, &lazy)) {
+            free(parameters);
+            free(paramTypes);
+            return NULL;
+        }
+        Stmt* stmt = newFunctionStmt(poolToken(name), param_count, parameters, NULL);
+        free(parameters);
+        AS_FUNCTION_STMT(stmt)->paramTypes = paramTypes;
+        AS_FUNCTION_STMT(stmt)->returnType = returnType;
+        AS_FUNCTION_STMT(stmt)->lazy = lazy;
+        return stmt;
+    }
+
     // Removed: Token leftBrace = consume(parser, TOKEN_LEFT_BRACE, ...);
     StmtList* body = block(parser);
     if (parser->hadError || body == NULL) {
         free(parameters);
+        free(paramTypes);
         return NULL;
     }
 
-    return newFunctionStmt(name, param_count, parameters, body);
+    Stmt* stmt = newFunctionStmt(poolToken(name), param_count, parameters, body);
+    free(parameters);
+    AS_FUNCTION_STMT(stmt)->paramTypes = paramTypes;
+    AS_FUNCTION_STMT(stmt)->returnType = returnType;
+    return stmt;
 }
 
-// statement -> exprStmt | ifStmt | printStmt | returnStmt | block
+// the braces of a function body and what is between them, without parsing
+// it. the scanner still sees every token, so bad characters and unterminated
+// strings are reported now, like everything about the braces themselves.
+static bool skipBody(Parser* parser, LazyBody* lazy) {
+    if (!check(parser, TOKEN_LEFT_BRACE)) {
+        errorAtCurrent(parser, "Wah, you never open with '{' ah? Cannot start block like this!");
+        return false;
+    }
+    *lazy = (LazyBody) { peek(parser)->start, peek(parser)->line, NULL, 0 };
+    int capacity = 0;
+
+    int depth = 0;
+    TokenType before = TOKEN_EOF;
+    do {
+        Token* token = advance(parser);
+        switch (token->type) {
+            case TOKEN_LEFT_BRACE:
+                depth++;
+                break;
+            case TOKEN_RIGHT_BRACE:
+                depth--;
+                break;
+            case TOKEN_ERROR:
+                error(parser, token, token->start);
+                break;
+            case TOKEN_IDENTIFIER:
+                // name = value, but not chope name = value or chope name: type = value
+                if (check(parser, TOKEN_EQUAL) && before != TOKEN_CHOPE && before != TOKEN_COLON) {
+                    if (lazy->assignedCount >= capacity) {
+                        int oldCapacity = capacity;
+                        capacity = GROW_CAPACITY(oldCapacity);
+                        lazy->assigned = GROW_ARRAY(Token, lazy->assigned, oldCapacity, capacity);
+                    }
+                    lazy->assigned[lazy->assignedCount++] = *token;
+                }
+                break;
+            default:
+                break;
+        }
+        before = token->type;
+    } while (depth > 0 && !isAtEnd(parser) && !parser->hadError);
+
+    if (depth > 0 && !parser->hadError) {
+        errorAtCurrent(parser, "After block must close with '}' ok?");
+    }
+    if (parser->hadError) {
+        free(lazy->assigned);
+        return false;
+    }
+    return true;
+}
+
+// statement -> exprStmt | ifStmt | printStmt | returnStmt | jumpStmt | block
 static Stmt* statement(Parser* parser) {
     if (match(parser, TOKEN_DO_AGAIN_FROM)) {
         return forStatement(parser);
@@ -281,6 +447,12 @@ static Stmt* statement(Parser* parser) {
     if (match(parser, TOKEN_RETURN)) {
         return returnStatement(parser);
     }
+    if (match(parser, TOKEN_CABUT)) {
+        return jumpStatement(parser, STMT_BREAK);
+    }
+    if (match(parser, TOKEN_CARRY_ON)) {
+        return jumpStatement(parser, STMT_CONTINUE);
+    }
     if (check(parser, TOKEN_LEFT_BRACE)) {
         StmtList* blockStmts = block(parser); // block() handles {} and returns list
         // If block parsing failed (returned NULL), propagate NULL
@@ -296,8 +468,8 @@ static Stmt* statement(Parser* parser) {
 
 // forStmt -> "for" "(" ( varDecl | exprStmt | ";" ) expression? ";" expression? ")" statement ;
 static Stmt* forStatement(Parser* parser) {
-    Token leftParen = consume(parser, TOKEN_LEFT_PAREN, "After 'for' must have '(' one leh!");
-    if (parser->hadError || leftParen.type == TOKEN_ERROR) return NULL;
+    Token* leftParen = consume(parser, TOKEN_LEFT_PAREN, "After 'for' must have '(' one leh!");
+    if (parser->hadError || leftParen->type == TOKEN_ERROR) return NULL;
 
     Stmt* initializer;
     if (match(parser, TOKEN_SEMICOLON)) {
@@ -329,19 +501,16 @@ static Stmt* forStatement(Parser* parser) {
     Stmt* body = statement(parser);
     if (parser->hadError) return NULL;
 
-    if (increment != NULL) {
-        StmtList* incrNode = newStmtList(newExpressionStmt(increment), NULL);
-        body = newBlockStmt(newStmtList(body, incrNode));
-    }
-
     if (condition == NULL) {
         condition = newLiteralBooleanExpr(true);
     }
+    // the increment stays apart from the body, `carry on` still runs it
     body = newWhileStmt(condition, body);
+    body->as.whileStmt.increment = nodeIndex(increment);
 
     if (initializer != NULL) {
-        StmtList* bodyNode = newStmtList(body, NULL);
-        body = newBlockStmt(newStmtList(initializer, bodyNode));
+        NodeIndex statements[] = { nodeIndex(initializer), nodeIndex(body) };
+        body = newBlockStmt(newStmtList(statements, 2));
     }
 
     return body;
@@ -349,7 +518,7 @@ static Stmt* forStatement(Parser* parser) {
 
 // returnStmt -> "return" expression? ";"
 static Stmt* returnStatement(Parser* parser) {
-    Token keyword = previous(parser);
+    Token keyword = *previous(parser);
 
     Expr* value = NULL;
     if (!check(parser, TOKEN_SEMICOLON)) {
@@ -359,19 +528,28 @@ static Stmt* returnStatement(Parser* parser) {
 
     consume(parser, TOKEN_SEMICOLON, "Aiyo return value means finish already, must end with ';'.");
 
-    return newReturnStmt(keyword, value);
+    return newReturnStmt(poolToken(keyword), value);
+}
+
+// jumpStmt -> ( "cabut" | "carry on" ) ";"
+// whether there is a loop to jump out of is the resolver's business
+static Stmt* jumpStatement(Parser* parser, StmtType type) {
+    Token keyword = *previous(parser);
+    Token* semicolon = consume(parser, TOKEN_SEMICOLON, "Cabut or carry on also must end with ';' one.");
+    if (semicolon->type == TOKEN_ERROR) return NULL;
+    return newJumpStmt(type, poolToken(keyword));
 }
 
 // ifStmt -> "if" "(" expression ")" statement ( "else" statement )?
 static Stmt* ifStatement(Parser* parser) {
-    Token leftParen = consume(parser, TOKEN_LEFT_PAREN, "After 'if' must have '(' leh!");
-    if (parser->hadError || leftParen.type == TOKEN_ERROR)
+    Token* leftParen = consume(parser, TOKEN_LEFT_PAREN, "After 'if' must have '(' leh!");
+    if (parser->hadError || leftParen->type == TOKEN_ERROR)
         return NULL; // Error consuming left parenthesis
     Expr* condition = expression(parser);
     if (parser->hadError)
         return NULL; // Propagate error
-    Token rightParen = consume(parser, TOKEN_RIGHT_PAREN, "If condition finish liao, where your ')' ah?");
-    if (parser->hadError || rightParen.type == TOKEN_ERROR)
+    Token* rightParen = consume(parser, TOKEN_RIGHT_PAREN, "If condition finish liao, where your ')' ah?");
+    if (parser->hadError || rightParen->type == TOKEN_ERROR)
         return NULL; // Error consuming right parenthesis
 
     Stmt* thenBranch = statement(parser);
@@ -392,19 +570,19 @@ static Stmt* ifStatement(Parser* parser) {
 static Stmt* printStatement(Parser* parser) {
     Expr* value = expression(parser); // Parse the expression to print
     if (parser->hadError) return NULL; // Propagate error
-    Token semicolon = consume(parser, TOKEN_SEMICOLON, "You print already never put ';'? How can?");
-    if (semicolon.type == TOKEN_ERROR) return NULL; // Error consuming semicolon
+    Token* semicolon = consume(parser, TOKEN_SEMICOLON, "You print already never put ';'? How can?");
+    if (semicolon->type == TOKEN_ERROR) return NULL; // Error consuming semicolon
     return newPrintStmt(value);
 }
 
 // whileStmt -> "while" "(" expression ")" statement ;
 static Stmt* whileStatement(Parser* parser) {
-    Token leftParen = consume(parser, TOKEN_LEFT_PAREN, "After 'while' must have '(' leh!");
-    if (parser->hadError || leftParen.type == TOKEN_ERROR) return NULL; // Error consuming parenthesis
+    Token* leftParen = consume(parser, TOKEN_LEFT_PAREN, "After 'while' must have '(' leh!");
+    if (parser->hadError || leftParen->type == TOKEN_ERROR) return NULL; // Error consuming parenthesis
     Expr* condition = expression(parser);
     if (parser->hadError) return NULL;
-    Token rightParen = consume(parser, TOKEN_RIGHT_PAREN, "Condition close with ')' leh, don't forget.");
-    if (parser->hadError || rightParen.type == TOKEN_ERROR) return NULL; // Error consuming parenthesis
+    Token* rightParen = consume(parser, TOKEN_RIGHT_PAREN, "Condition close with ')' leh, don't forget.");
+    if (parser->hadError || rightParen->type == TOKEN_ERROR) return NULL; // Error consuming parenthesis
     Stmt* body = statement(parser);
     if (parser->hadError) return NULL;
 
@@ -415,16 +593,22 @@ static Stmt* whileStatement(Parser* parser) {
 static Stmt* expressionStatement(Parser* parser) {
     Expr* expr = expression(parser); // Parse the expression
     if (parser->hadError) return NULL; // Propagate error
-    Token semicolon = consume(parser, TOKEN_SEMICOLON, "Expression done liao, remember your ';'!");
-    if (semicolon.type == TOKEN_ERROR) return NULL; // Error consuming semicolon
+    Token* semicolon = consume(parser, TOKEN_SEMICOLON, "Expression done liao, remember your ';'!");
+    if (semicolon->type == TOKEN_ERROR) return NULL; // Error consuming semicolon
     return newExpressionStmt(expr);
 }
 
-// varDecl -> "var" IDENTIFIER ( "=" expression )
+// varDecl -> "var" IDENTIFIER ( ":" type )? ( "=" expression )
 static Stmt* varDeclaration(Parser* parser) {
-    Token name = consume(parser, TOKEN_IDENTIFIER, "Eh hello, where the variable name?");
+    Token name = *consume(parser, TOKEN_IDENTIFIER, "Eh hello, where the variable name?");
     if (name.type == TOKEN_ERROR) return NULL;
 
+    StaticType declaredType = STATIC_UNKNOWN;
+    if (match(parser, TOKEN_COLON)) {
+        declaredType = typeAnnotation(parser);
+        if (parser->hadError) return NULL;
+    }
+
     Expr* initializer = NULL;
     if (match(parser, TOKEN_EQUAL)) {
         initializer = expression(parser);
@@ -436,13 +620,21 @@ static Stmt* varDeclaration(Parser* parser) {
         }
     }
 
-    Token semicolon = consume(parser, TOKEN_SEMICOLON, "After declare variable must have ';' leh.");
-    if (semicolon.type == TOKEN_ERROR) {
+    Token* semicolon = consume(parser, TOKEN_SEMICOLON, "After declare variable must have ';' leh.");
+    if (semicolon->type == TOKEN_ERROR) {
         // If semicolon fails, we might have a valid initializer expression parsed
         freeExpr(initializer); // Clean up the parsed initializer
         return NULL;
     }
-    return newVarStmt(name, initializer);
+    if (declaredType != STATIC_UNKNOWN && initializer == NULL) {
+        // a typed variable can never hold the nil it would start with
+        error(parser, &name, "Got type must give starting value also leh.");
+        return NULL;
+    }
+
+    Stmt* stmt = newVarStmt(poolToken(name), initializer);
+    stmt->as.var.declaredType = declaredType;
+    return stmt;
 }
 
 // block -> "{" declaration* "}" ;
@@ -453,8 +645,9 @@ static StmtList* block(Parser* parser) {
         return NULL;
     }
 
-    StmtList* statements = NULL;
-    StmtList* tail = NULL;
+    StmtListBuilder statements;
+    initStmtListBuilder(&statements);
+    parser->depth++;
 
     // Parse declarations inside the block until '}' or EOF
     while (!check(parser, TOKEN_RIGHT_BRACE) && !isAtEnd(parser)) {
@@ -462,211 +655,170 @@ static StmtList* block(Parser* parser) {
 
         if (parser->hadError) {
             // If declaration failed within the block, free the list built for this block.
-            freeStmtList(statements);
-            statements = NULL; // Mark as freed
+            freeStmtList(buildStmtList(&statements));
             // Don't return yet, try to find the closing brace
             break; // Exit the loop to find '}'
         }
 
         if (decl != NULL) {
-            StmtList* newNode = newStmtList(decl, NULL);
-            if (statements == NULL) {
-                statements = newNode;
-                tail = newNode;
-            } else {
-                tail->next = newNode;
-                tail = newNode;
-            }
+            addStmt(&statements, decl);
         }
     }
 
     consume(parser, TOKEN_RIGHT_BRACE, "After block must close with '}' ok?");
+    parser->depth--;
 
     // If we exited the loop due to an error OR failed to consume '}', cleanup & return NULL
     if (parser->hadError) { // Check error flag *after* trying to consume brace
         // If closingBrace itself caused an error, statements might not be freed yet.
-        // If the error was inside the loop, statements should be NULL now.
-        if (statements != NULL) {
-            freeStmtList(statements);
-        }
+        // If the error was inside the loop, statements is empty now.
+        freeStmtList(buildStmtList(&statements));
         return NULL;
     }
 
-    return statements;
+    return buildStmtList(&statements);
 }
 
 // --- Expression Parsing Rules ---
+// a Pratt parser. every token type has a rule saying how to parse an
+// expression starting with it (prefix), how to continue an expression that it
+// follows (infix), and how tightly that infix form binds. parsePrecedence
+// keeps taking infix operators while they bind at least as tightly as the
+// level it was called with, so a literal or identifier costs one call instead
+// of a trip down every grammar level.
+
+typedef enum {
+    PREC_NONE,
+    PREC_ASSIGNMENT, // =
+    PREC_OR, // or
+    PREC_AND, // and
+    PREC_EQUALITY, // == !=
+    PREC_COMPARISON, // < > <= >=
+    PREC_TERM, // + -
+    PREC_FACTOR, // * /
+    PREC_UNARY, // ! -
+    PREC_CALL, // ()
+    PREC_PRIMARY
+} Precedence;
+
+// canAssign: whether an '=' after this operand may make it an assignment
+typedef Expr* (*PrefixFn)(Parser* parser, bool canAssign);
+typedef Expr* (*InfixFn)(Parser* parser, Expr* left);
+
+typedef struct {
+    PrefixFn prefix;
+    InfixFn infix;
+    Precedence precedence;
+} ParseRule;
+
+static Expr* parsePrecedence(Parser* parser, Precedence precedence);
+static const ParseRule* getRule(TokenType type);
 
 // expression -> assignment ;
 static Expr* expression(Parser* parser) {
-    return assignment(parser); // Use assignment as the top-level expression rule
+    return parsePrecedence(parser, PREC_ASSIGNMENT);
 }
 
-// assignment -> IDENTIFIER "=" assignment | logic_or ;
-// eg: a = b = c;
-static Expr* assignment(Parser* parser) {
-    // Parse the LHS. It might be an identifier, or something else.
-    Expr* expr = or (parser);
-    if (parser->hadError) return NULL;
-
-    if (match(parser, TOKEN_EQUAL)) {
-        Token equals = previous(parser);
-        Expr* value = assignment(parser); // Parse the RHS recursively
-        if (parser->hadError) {
-            freeExpr(expr); // Free the LHS if RHS parsing failed
-            return NULL;
-        }
-
-        if (expr->type == EXPR_VARIABLE) {
-            Token name = expr->as.variable.name;
-            Expr* assignNode = newAssignExpr(name, value);
-            freeExpr(expr); // free the variable expression since we're replacing it
-            return assignNode;
-        } else {
-            error(parser, equals, "Invalid assignment target.");
-            freeExpr(value);
-            freeExpr(expr);
-            return NULL;
-        }
+// primary -> NUMBER | STRING | "true" | "false" | "nil" | IDENTIFIER | "(" expression ")" ;
+static Expr* number(Parser* parser, bool canAssign) {
+    (void)canAssign;
+    return newLiteralNumberExpr(strtod(previous(parser)->start, NULL));
+}
+
+static Expr* string(Parser* parser, bool canAssign) {
+    (void)canAssign;
+    Token* token = previous(parser);
+    int length = token->length - 2; // drop the quotes
+    char* value = (char*)malloc(length + 1);
+    if (value == NULL) {
+        error(parser, token, "Memory error copying string literal.");
+        return NULL;
     }
-
-    // If no '=' was matched, just return the expression parsed by or()
-    return expr;
+    memcpy(value, token->start + 1, length);
+    value[length] = '\0';
+    Expr* literal = newLiteralStringExpr(value);
+    free(value);
+    return literal;
 }
 
-// logic_or -> logic_and ( "or" logic_and )* ;
-static Expr* or (Parser * parser) {
-    Expr* expr = and(parser);
-    if (parser->hadError) return NULL;
-
-    while (match(parser, TOKEN_OR)) {
-        Token oper = previous(parser);
-        Expr* right = and(parser);
-        if (parser->hadError) {
-            freeExpr(expr);
-            return NULL;
-        }
-        expr = newLogicalExpr(expr, oper, right);
+static Expr* literal(Parser* parser, bool canAssign) {
+    (void)canAssign;
+    switch (previous(parser)->type) {
+        case TOKEN_WRONG:
+            return newLiteralBooleanExpr(false);
+        case TOKEN_CORRECT:
+            return newLiteralBooleanExpr(true);
+        default:
+            return newLiteralNilExpr();
     }
-
-    return expr;
 }
 
-// logic_and -> equality ( "and" equality )* ;
-static Expr* and (Parser * parser) {
-    Expr* expr = equality(parser);
-    if (parser->hadError) return NULL;
-
-    while (match(parser, TOKEN_AND)) {
-        Token oper = previous(parser);
-        Expr* right = equality(parser);
-        if (parser->hadError) {
-            freeExpr(expr);
-            return NULL;
-        }
-        expr = newLogicalExpr(expr, oper, right);
+// assignment -> IDENTIFIER "=" assignment | logic_or ;
+// eg: a = b = c;
+static Expr* variable(Parser* parser, bool canAssign) {
+    Token name = *previous(parser);
+    if (canAssign && match(parser, TOKEN_EQUAL)) {
+        Expr* value = parsePrecedence(parser, PREC_ASSIGNMENT); // right associative
+        if (parser->hadError) return NULL;
+        return newAssignExpr(poolToken(name), value);
     }
-
-    return expr;
+    return newVariableExpr(poolToken(name));
 }
 
-// equality -> comparison ( ( "!=" | "==" ) comparison )* ;
-static Expr* equality(Parser* parser) {
-    Expr* expr = comparison(parser);
+static Expr* grouping(Parser* parser, bool canAssign) {
+    (void)canAssign;
+    Expr* expr = expression(parser);
     if (parser->hadError) return NULL;
-
-    while (match(parser, TOKEN_BANG_EQUAL) || match(parser, TOKEN_EQUAL_EQUAL)) {
-        Token operator= previous(parser);
-        Expr* right = comparison(parser);
-        if (parser->hadError) {
-            freeExpr(expr);
-            return NULL;
-        }
-        expr = newBinaryExpr(expr, operator, right);
+    Token* closingParen = consume(parser, TOKEN_RIGHT_PAREN, "After expression must close with ')'.");
+    if (closingParen->type == TOKEN_ERROR) {
+        freeExpr(expr);
+        return NULL;
     }
-    return expr;
+    return newGroupingExpr(expr);
 }
 
-// comparison -> term ( ( ">" | ">=" | "<" | "<=" ) term )* ;
-static Expr* comparison(Parser* parser) {
-    Expr* expr = term(parser);
+// unary -> ( "!" | "-" ) unary | call ;
+static Expr* unary(Parser* parser, bool canAssign) {
+    (void)canAssign;
+    Token oper = *previous(parser);
+    Expr* right = parsePrecedence(parser, PREC_UNARY);
     if (parser->hadError) return NULL;
-
-    while (match(parser, TOKEN_GREATER) || match(parser, TOKEN_GREATER_EQUAL) || match(parser, TOKEN_LESS) || match(parser, TOKEN_LESS_EQUAL)) {
-        Token operator= previous(parser);
-        Expr* right = term(parser);
-        if (parser->hadError) {
-            freeExpr(expr);
-            return NULL;
-        }
-        expr = newBinaryExpr(expr, operator, right);
-    }
-    return expr;
+    return newUnaryExpr(poolToken(oper), right);
 }
 
-// term -> factor ( ( "-" | "+" ) factor )* ;
-static Expr* term(Parser* parser) {
-    Expr* expr = factor(parser);
-    if (parser->hadError) return NULL;
-
-    while (match(parser, TOKEN_MINUS) || match(parser, TOKEN_PLUS)) {
-        Token operator= previous(parser);
-        Expr* right = factor(parser);
-        if (parser->hadError) {
-            freeExpr(expr);
-            return NULL;
-        }
-        expr = newBinaryExpr(expr, operator, right);
+// factor, term, comparison and equality are all left associative:
+// the right operand only takes operators binding tighter than this one
+static Expr* binary(Parser* parser, Expr* left) {
+    Token oper = *previous(parser);
+    Expr* right = parsePrecedence(parser, getRule(oper.type)->precedence + 1);
+    if (parser->hadError) {
+        freeExpr(left);
+        return NULL;
     }
-    return expr;
+    return newBinaryExpr(left, poolToken(oper), right);
 }
 
-// factor -> unary ( ( "/" | "*" ) unary )* ;
-static Expr* factor(Parser* parser) {
-    Expr* expr = unary(parser);
-    if (parser->hadError) return NULL;
-
-    while (match(parser, TOKEN_SLASH) || match(parser, TOKEN_STAR)) {
-        Token operator= previous(parser);
-        Expr* right = unary(parser);
-        if (parser->hadError) {
-            freeExpr(expr);
-            return NULL;
-        }
-        expr = newBinaryExpr(expr, operator, right);
+// logic_or -> logic_and ( "or" logic_and )* ;
+// logic_and -> equality ( "and" equality )* ;
+static Expr* logical(Parser* parser, Expr* left) {
+    Token oper = *previous(parser);
+    Expr* right = parsePrecedence(parser, getRule(oper.type)->precedence + 1);
+    if (parser->hadError) {
+        freeExpr(left);
+        return NULL;
     }
-    return expr;
+    return newLogicalExpr(left, poolToken(oper), right);
 }
 
-// unary -> ( "!" | "-" ) unary | call ;
-static Expr* unary(Parser* parser) {
-    if (match(parser, TOKEN_BANG) || match(parser, TOKEN_MINUS)) {
-        Token operator= previous(parser);
-        Expr* right = unary(parser);
-        if (parser->hadError) return NULL;
-        return newUnaryExpr(operator, right);
+static void freeArguments(Expr** arguments, int arg_count) {
+    for (int i = 0; i < arg_count; i++) {
+        freeExpr(arguments[i]);
     }
-    return call(parser);
+    free(arguments);
 }
 
 // call -> primary ( "(" arguments? ")" )* ;
-static Expr* call(Parser* parser) {
-    Expr* expr = primary(parser);
-    if (parser->hadError) return NULL;
-
-    while (match(parser, TOKEN_LEFT_PAREN)) {
-        expr = finishCall(parser, expr);
-        if (parser->hadError) {
-            freeExpr(expr);
-            return NULL;
-        }
-    }
-
-    return expr;
-}
-
-// Parse arguments for a function call
-static Expr* finishCall(Parser* parser, Expr* callee) {
+static Expr* call(Parser* parser, Expr* callee) {
     Expr** arguments = NULL;
     int arg_count = 0;
 
@@ -674,30 +826,24 @@ static Expr* finishCall(Parser* parser, Expr* callee) {
         do {
             if (arg_count >= 255) {
                 error(parser, peek(parser), "Can't have more than 255 arguments.");
-                for (int i = 0; i < arg_count; i++) {
-                    freeExpr(arguments[i]);
-                }
-                free(arguments);
+                freeArguments(arguments, arg_count);
+                freeExpr(callee);
                 return NULL;
             }
 
             Expr* argument = expression(parser);
             if (parser->hadError) {
-                for (int i = 0; i < arg_count; i++) {
-                    freeExpr(arguments[i]);
-                }
-                free(arguments);
+                freeArguments(arguments, arg_count);
+                freeExpr(callee);
                 return NULL;
             }
 
             Expr** new_args = (Expr**)realloc(arguments, sizeof(Expr*) * (arg_count + 1));
             if (new_args == NULL) {
                 error(parser, peek(parser), "Memory error allocating arguments.");
-                for (int i = 0; i < arg_count; i++) {
-                    freeExpr(arguments[i]);
-                }
-                free(arguments);
+                freeArguments(arguments, arg_count);
                 freeExpr(argument);
+                freeExpr(callee);
                 return NULL;
             }
             arguments = new_args;
@@ -707,61 +853,69 @@ static Expr* finishCall(Parser* parser, Expr* callee) {
         } while (match(parser, TOKEN_COMMA));
     }
 
-    Token paren = consume(parser, TOKEN_RIGHT_PAREN, "After argument list must have ')'.");
+    Token* paren = consume(parser, TOKEN_RIGHT_PAREN, "After argument list must have ')'.");
     if (parser->hadError) {
-        for (int i = 0; i < arg_count; i++) {
-            freeExpr(arguments[i]);
-        }
-        free(arguments);
+        freeArguments(arguments, arg_count);
+        freeExpr(callee);
         return NULL;
     }
 
-    return newCallExpr(callee, paren, arg_count, arguments);
+    Expr* expr = newCallExpr(callee, poolToken(*paren), arg_count, arguments);
+    free(arguments);
+    return expr;
 }
 
-// primary -> NUMBER | STRING | "true" | "false" | "nil" | IDENTIFIER | "(" expression ")" ;
-static Expr* primary(Parser* parser) {
-    if (match(parser, TOKEN_WRONG)) return newLiteralBooleanExpr(false);
-    if (match(parser, TOKEN_CORRECT)) return newLiteralBooleanExpr(true);
-    if (match(parser, TOKEN_NIL)) return newLiteralNilExpr();
-
-    if (match(parser, TOKEN_NUMBER)) {
-        double value = strtod(previous(parser).start, NULL);
-        return newLiteralNumberExpr(value);
-    }
-
-    if (match(parser, TOKEN_STRING)) {
-        const char* strStart = previous(parser).start + 1;
-        int length = previous(parser).length - 2;
-        char* value = (char*)malloc(length + 1);
-        if (value == NULL) {
-            error(parser, previous(parser), "Memory error copying string literal.");
-            return NULL;
-        }
-        strncpy(value, strStart, length);
-        value[length] = '\0';
-        Expr* literal = newLiteralStringExpr(value);
-        free(value);
-        return literal;
+static const ParseRule rules[TOKEN_LAH + 1] = {
+    [TOKEN_LEFT_PAREN] = { grouping, call, PREC_CALL },
+    [TOKEN_MINUS] = { unary, binary, PREC_TERM },
+    [TOKEN_PLUS] = { NULL, binary, PREC_TERM },
+    [TOKEN_SLASH] = { NULL, binary, PREC_FACTOR },
+    [TOKEN_STAR] = { NULL, binary, PREC_FACTOR },
+    [TOKEN_BANG] = { unary, NULL, PREC_NONE },
+    [TOKEN_BANG_EQUAL] = { NULL, binary, PREC_EQUALITY },
+    [TOKEN_EQUAL_EQUAL] = { NULL, binary, PREC_EQUALITY },
+    [TOKEN_GREATER] = { NULL, binary, PREC_COMPARISON },
+    [TOKEN_GREATER_EQUAL] = { NULL, binary, PREC_COMPARISON },
+    [TOKEN_LESS] = { NULL, binary, PREC_COMPARISON },
+    [TOKEN_LESS_EQUAL] = { NULL, binary, PREC_COMPARISON },
+    [TOKEN_IDENTIFIER] = { variable, NULL, PREC_NONE },
+    [TOKEN_STRING] = { string, NULL, PREC_NONE },
+    [TOKEN_NUMBER] = { number, NULL, PREC_NONE },
+    [TOKEN_AND] = { NULL, logical, PREC_AND },
+    [TOKEN_OR] = { NULL, logical, PREC_OR },
+    [TOKEN_WRONG] = { literal, NULL, PREC_NONE },
+    [TOKEN_CORRECT] = { literal, NULL, PREC_NONE },
+    [TOKEN_NIL] = { literal, NULL, PREC_NONE },
+    // everything else can neither start nor continue an expression
+};
+
+static const ParseRule* getRule(TokenType type) {
+    return &rules[type];
+}
+
+static Expr* parsePrecedence(Parser* parser, Precedence precedence) {
+    PrefixFn prefix = getRule(peek(parser)->type)->prefix;
+    if (prefix == NULL) {
+        errorAtCurrent(parser, "Alamak! Expression where?");
+        return NULL;
     }
+    advance(parser);
 
-    if (match(parser, TOKEN_IDENTIFIER)) {
-        // Create a variable expression node using the identifier token
-        return newVariableExpr(previous(parser));
-    }
+    // only the loosest level may turn into an assignment, so `a + b = c` is caught below
+    bool canAssign = precedence <= PREC_ASSIGNMENT;
+    Expr* expr = prefix(parser, canAssign);
+    if (parser->hadError) return NULL;
 
-    if (match(parser, TOKEN_LEFT_PAREN)) {
-        Expr* expr = expression(parser);
+    while (precedence <= getRule(peek(parser)->type)->precedence) {
+        InfixFn infix = getRule(advance(parser)->type)->infix;
+        expr = infix(parser, expr);
         if (parser->hadError) return NULL;
-        Token closingParen = consume(parser, TOKEN_RIGHT_PAREN, "After expression must close with ')'.");
-        if (closingParen.type == TOKEN_ERROR) {
-            freeExpr(expr);
-            return NULL;
-        }
-        return newGroupingExpr(expr);
     }
 
-    // If none of the above match, it's an error
-    errorAtCurrent(parser, "Alamak! Expression where?");
-    return NULL;
-}
\ No newline at end of file
+    if (canAssign && match(parser, TOKEN_EQUAL)) {
+        error(parser, previous(parser), "Invalid assignment target.");
+        freeExpr(expr);
+        return NULL;
+    }
+    return expr;
+}
@@ -5,18 +5,40 @@
 #include "../ast/stmt.h"
 #include "scanner.h"
 
+// tokens kept around: the previous one, the current one and a little slack.
+// must be a power of two.
+#define PARSER_LOOKAHEAD 4
+
+// scanning and parsing happen in one pass: the parser pulls each token from
+// the scanner when it gets to it and keeps only the last few in a ring
 typedef struct {
-    Token* tokens;
-    int current;
-    int count;
+    Scanner* scanner;
+    Token ring[PARSER_LOOKAHEAD];
+    int current; // position of the current token in the whole token stream
     bool hadError;
     bool panicMode;
+    bool lazyBodies; // skip the bodies of top-level functions, see parseFunctionBody
+    int depth; // blocks the current token is inside
 } Parser;
 
-void initParser(Parser* parser, Token* tokens, int count);
+void initParser(Parser* parser, Scanner* scanner);
 
 StmtList* parse(Parser* parser);
 
+// parse just the next top-level declaration, for running a script while it is
+// still being read (--stream). NULL once the input is used up or on a syntax
+// error, see hadParserError.
+Stmt* parseDeclaration(Parser* parser);
+
 bool hadParserError(Parser* parser);
 
+// with lazyBodies set, the parser only matches the braces of a top-level
+// function's body and notes where it starts and what it assigns to. the body
+// is parsed here once the function is first called, so startup only pays for
+// the functions a run actually uses. syntax and resolver errors inside a
+// skipped body show up then too, apart from unbalanced braces and bad
+// characters, which is why sg only skips bodies with --lazy.
+// false after reporting a syntax error.
+bool parseFunctionBody(Stmt* function);
+
 #endif
\ No newline at end of file
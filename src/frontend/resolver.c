@@ -1,135 +1,419 @@
 #include "resolver.h"
 #include "../backend/environment.h"
 #include "../backend/interpreter.h"
+#include "../runtime/memory.h"
 #include "../runtime/object.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+// --- Scopes ---
+// every local in scope sits on one stack, innermost last, and names[] maps
+// each name's symbol to its innermost entry. an entry remembers the one
+// it shadows, so ending a scope pops its entries and puts those back, and a
+// lookup costs the same however many scopes and names there are. both stay
+// allocated between scopes and between runs. globals aren't tracked, the
+// interpreter checks those.
+
 typedef struct {
-    const char* name;
+    Token name; // points into the source, names are never copied
     bool defined;
+    bool ahead; // declared before its statement was reached, see declareAhead
+    StaticType type; // declared type, STATIC_UNKNOWN if not annotated
+    int shadowed; // entry of the same name in an outer scope, -1 if none
 } ScopeEntry;
 
-typedef struct Scope {
-    ScopeEntry* entries;
-    int count;
-    int capacity;
-    struct Scope* next;
-} Scope;
+static ScopeEntry* entries = NULL;
+static int entryCount = 0;
+static int entryCapacity = 0;
+
+// where each open scope's entries and global reads start
+typedef struct {
+    int entries;
+    int reads;
+    bool captured; // some function uses one of its entries as an upvalue
+} ScopeStart;
+
+static ScopeStart* scopeStarts = NULL;
+static int scopeCount = 0;
+static int scopeCapacity = 0;
+
+// reads marked global while some scope was open, see markGlobal
+typedef struct {
+    Expr* expr;
+    int previous; // the read before it with the same name, -1 if none
+} GlobalRead;
+
+static GlobalRead* reads = NULL;
+static int readCount = 0;
+static int readCapacity = 0;
+
+// by symbol, grows as symbols are made
+typedef struct {
+    int innermost; // entry, -1 if no local has that name
+    int latestRead; // in reads, -1 if none
+} NameState;
+
+static NameState* names = NULL;
+static SymbolId nameCapacity = 0;
 
-static Scope* scopeStack = NULL;
+// --- Functions ---
+// the functions being resolved, innermost last. a local of one of them (or
+// of a block outside every function) used from a function inside it becomes
+// an upvalue of that function and of every function in between, the way Lua
+// and clox do it.
+
+typedef struct {
+    int firstEntry; // its parameters and locals start here
+    Upvalue* upvalues; // handed to the statement when it is resolved
+    int upvalueCount;
+    int upvalueCapacity;
+} FunctionScope;
+
+static FunctionScope* functions = NULL;
+static int functionCount = 0;
+static int functionCapacity = 0;
+
+// declared return type of the function being resolved
+static StaticType currentReturnType = STATIC_UNKNOWN;
+
+// loops around the statement being resolved, within its function
+static int loopDepth = 0;
+
+static bool hadError = false;
+
+// the type an expression has no matter what the variables in it hold.
+// the interpreter checks everything this cannot see.
+static StaticType obviousType(Expr* expr) {
+    if (expr == NULL) return STATIC_NIL;
+    switch (expr->type) {
+        case EXPR_LITERAL:
+            switch (expr->as.literal.type) {
+                case TOKEN_NUMBER:
+                    return STATIC_NUMBER;
+                case TOKEN_STRING:
+                    return STATIC_STRING;
+                case TOKEN_CORRECT:
+                case TOKEN_WRONG:
+                    return STATIC_BOOL;
+                case TOKEN_NIL:
+                    return STATIC_NIL;
+                default:
+                    return STATIC_UNKNOWN;
+            }
+        case EXPR_GROUPING:
+            return obviousType(AS_EXPR(expr->as.grouping.expression));
+        case EXPR_UNARY:
+            return TOKEN_AT(expr->as.unary.oper)->type == TOKEN_MINUS ? STATIC_NUMBER : STATIC_BOOL;
+        case EXPR_BINARY:
+            switch (TOKEN_AT(expr->as.binary.oper)->type) {
+                case TOKEN_MINUS:
+                case TOKEN_STAR:
+                case TOKEN_SLASH:
+                    return STATIC_NUMBER;
+                case TOKEN_PLUS:
+                    return STATIC_UNKNOWN;
+                default:
+                    return STATIC_BOOL;
+            }
+        default:
+            return STATIC_UNKNOWN;
+    }
+}
+
+static void checkType(StaticType declared, Expr* value, int line, const char* what) {
+    if (declared == STATIC_UNKNOWN) return;
+    StaticType actual = obviousType(value);
+    if (actual != STATIC_UNKNOWN && actual != declared) {
+        fprintf(stderr, "[line %d] Aiyo problem sia: %s must be %s, but you give %s leh.\n",
+                line, what, staticTypeName(declared), staticTypeName(actual));
+        hadError = true;
+    }
+}
+
+static NameState* nameState(SymbolId symbol) {
+    if (symbol >= nameCapacity) {
+        SymbolId oldCapacity = nameCapacity;
+        nameCapacity = symbolLimit() > 2 * oldCapacity ? symbolLimit() : 2 * oldCapacity;
+        names = GROW_ARRAY(NameState, names, oldCapacity, nameCapacity);
+        for (SymbolId i = oldCapacity; i < nameCapacity; i++) {
+            names[i] = (NameState) { -1, -1 };
+        }
+    }
+    return &names[symbol];
+}
+
+static ScopeEntry* findLocal(Token* name) {
+    if (entryCount == 0 || name->symbol >= nameCapacity) return NULL;
+    int entry = names[name->symbol].innermost;
+    // a variable declared ahead only exists for the functions inside the
+    // scope until its statement runs
+    int ownEntries = functionCount > 0 ? functions[functionCount - 1].firstEntry : 0;
+    while (entry >= ownEntries && entries[entry].ahead) {
+        entry = entries[entry].shadowed;
+    }
+    return entry < 0 ? NULL : &entries[entry];
+}
 
 static void beginScope() {
-    Scope* scope = (Scope*)malloc(sizeof(Scope));
-    scope->count = 0;
-    scope->capacity = 8;
-    scope->entries = (ScopeEntry*)malloc(sizeof(ScopeEntry) * scope->capacity);
-    scope->next = scopeStack;
-    scopeStack = scope;
+    if (scopeCount >= scopeCapacity) {
+        int oldCapacity = scopeCapacity;
+        scopeCapacity = GROW_CAPACITY(oldCapacity);
+        scopeStarts = GROW_ARRAY(ScopeStart, scopeStarts, oldCapacity, scopeCapacity);
+    }
+    scopeStarts[scopeCount++] = (ScopeStart) { entryCount, readCount, false };
+}
+
+// what the interpreter needs to know about the innermost scope to give it
+// a frame, before it ends
+static void recordFrame(int* localCount, bool* captured) {
+    ScopeStart* scope = &scopeStarts[scopeCount - 1];
+    *localCount = entryCount - scope->entries;
+    *captured = scope->captured;
 }
 
 static void endScope() {
-    Scope* top = scopeStack;
-    for (int i = 0; i < top->count; i++) {
+    int start = scopeStarts[--scopeCount].entries;
+    // innermost first, each one puts back the entry it shadowed
+    while (entryCount > start) {
+        ScopeEntry* entry = &entries[--entryCount];
+        names[entry->name.symbol].innermost = entry->shadowed;
     }
-    free(top->entries);
-    scopeStack = top->next;
-    free(top);
-}
 
-static void declare(Token name) {
-    if (scopeStack == NULL) return;
-    for (int i = 0; i < scopeStack->count; i++) {
-        if (strncmp(scopeStack->entries[i].name, name.start, name.length) == 0 && strlen(scopeStack->entries[i].name) == name.length) {
-            fprintf(stderr, "[line %d] Aiyo problem sia: This variable already declare in this scope liao.\n", name.line);
-            return;
+    // outside every scope nothing can be declared local anymore
+    if (scopeCount == 0) {
+        while (readCount > 0) {
+            names[TOKEN_AT(reads[--readCount].expr->as.variable.name)->symbol].latestRead = -1;
         }
     }
-    if (scopeStack->count >= scopeStack->capacity) {
-        scopeStack->capacity *= 2;
-        scopeStack->entries = realloc(scopeStack->entries, sizeof(ScopeEntry) * scopeStack->capacity);
+}
+
+static void declare(Token name, StaticType type) {
+    if (scopeCount == 0) return;
+
+    NameState* state = nameState(name.symbol);
+    if (state->innermost >= scopeStarts[scopeCount - 1].entries && entries[state->innermost].ahead) {
+        // its statement, from now on it's like any other local
+        entries[state->innermost].ahead = false;
+        entries[state->innermost].defined = false;
+        return;
+    }
+    if (state->innermost >= scopeStarts[scopeCount - 1].entries) {
+        fprintf(stderr, "[line %d] Aiyo problem sia: This variable already declare in this scope liao.\n", name.line);
+        hadError = true;
+        return;
     }
-    char* nameCopy = malloc(name.length + 1);
-    if (nameCopy == NULL) {
-        fprintf(stderr, "Memory problem lah: Cannot allocate space for name copy sia.\n");
-        exit(1);
+
+    if (entryCount >= entryCapacity) {
+        int oldCapacity = entryCapacity;
+        entryCapacity = GROW_CAPACITY(oldCapacity);
+        entries = GROW_ARRAY(ScopeEntry, entries, oldCapacity, entryCapacity);
     }
-    memcpy(nameCopy, name.start, name.length);
-    nameCopy[name.length] = '\0';
+    entries[entryCount] = (ScopeEntry) { name, false, false, type, state->innermost };
+    state->innermost = entryCount++;
 
-    scopeStack->entries[scopeStack->count++] = (ScopeEntry) { nameCopy, false };
+    // reads of the name since this scope began took it for a global, but a
+    // function declared among them can run after this and see the local
+    int read = state->latestRead;
+    while (read >= scopeStarts[scopeCount - 1].reads) {
+        reads[read].expr->as.variable.global = false;
+        read = reads[read].previous;
+    }
+    state->latestRead = read;
 }
 
-static void define(Token name) {
-    if (scopeStack == NULL) return;
-    for (int i = 0; i < scopeStack->count; i++) {
-        if (strncmp(scopeStack->entries[i].name, name.start, name.length) == 0 && strlen(scopeStack->entries[i].name) == name.length) {
-            scopeStack->entries[i].defined = true;
-            return;
+// a function in a scope can use the variables and functions declared after
+// it there, e.g. two local functions calling each other. they become its
+// upvalues like the ones declared before it, so every declaration directly
+// in the scope is made before resolving any of it. the interpreter makes
+// their entries too when such a scope starts, see defineAhead.
+static void declareAhead(StmtList* statements) {
+    for (int i = 0; i < STMT_COUNT(statements); i++) {
+        Stmt* stmt = LIST_STMT(statements, i);
+        Token name;
+        StaticType type = STATIC_UNKNOWN;
+        if (stmt->type == STMT_VAR) {
+            name = *TOKEN_AT(stmt->as.var.name);
+            type = stmt->as.var.declaredType;
+        } else if (stmt->type == STMT_FUNCTION) {
+            name = *TOKEN_AT(AS_FUNCTION_STMT(stmt)->name);
+        } else {
+            continue;
         }
+        // the second one is an error once its statement is reached
+        if (nameState(name.symbol)->innermost >= scopeStarts[scopeCount - 1].entries) continue;
+        declare(name, type);
+        entries[entryCount - 1].ahead = true;
+        entries[entryCount - 1].defined = true;
+    }
+}
+
+static void define(Token name) {
+    if (scopeCount == 0) return;
+    ScopeEntry* entry = findLocal(&name);
+    // declared in this scope, an outer one's is a different variable
+    if (entry != NULL && entry - entries >= scopeStarts[scopeCount - 1].entries) {
+        entry->defined = true;
+    }
+}
+
+// --- Global Reads ---
+// a read with no local of its name in scope is of a global, and the
+// interpreter skips the local scopes for it (see findVariable). inside a
+// scope that only holds if no local of that name is declared later in the
+// scope either, so until the outermost scope ends these reads are kept
+// where declare can find and unmark them.
+
+static void markGlobal(Expr* expr) {
+    expr->as.variable.global = true;
+    if (scopeCount == 0) return;
+
+    NameState* state = nameState(TOKEN_AT(expr->as.variable.name)->symbol);
+    if (readCount >= readCapacity) {
+        int oldCapacity = readCapacity;
+        readCapacity = GROW_CAPACITY(oldCapacity);
+        reads = GROW_ARRAY(GlobalRead, reads, oldCapacity, readCapacity);
+    }
+    reads[readCount] = (GlobalRead) { expr, state->latestRead };
+    state->latestRead = readCount++;
+}
+
+// which upvalue of functions[level] the local entry is, made the first time.
+// within one function a name can only mean one variable outside it, so
+// upvalues are told apart by name.
+static int captureVariable(int level, Token* name, int entry) {
+    FunctionScope* scope = &functions[level];
+    for (int i = 0; i < scope->upvalueCount; i++) {
+        if (scope->upvalues[i].name.symbol == name->symbol) return i;
+    }
+
+    Upvalue upvalue = { *name, true, -1 };
+    if (level > 0 && entry < functions[level - 1].firstEntry) {
+        upvalue.local = false;
+        upvalue.index = captureVariable(level - 1, name, entry);
+    } else {
+        // its scope can't be a frame anymore
+        int scope = scopeCount - 1;
+        while (scopeStarts[scope].entries > entry) scope--;
+        scopeStarts[scope].captured = true;
+    }
+
+    // functions[] can't move in the recursion above, nothing is pushed
+    scope = &functions[level];
+    if (scope->upvalueCount >= scope->upvalueCapacity) {
+        int oldCapacity = scope->upvalueCapacity;
+        scope->upvalueCapacity = GROW_CAPACITY(oldCapacity);
+        scope->upvalues = GROW_ARRAY(Upvalue, scope->upvalues, oldCapacity, scope->upvalueCapacity);
     }
+    scope->upvalues[scope->upvalueCount] = upvalue;
+    return scope->upvalueCount++;
+}
+
+// the upvalue a use of a local means in the function it is in, -1 if the
+// local is that function's own
+static int upvalueFor(Token* name, ScopeEntry* entry) {
+    int index = (int)(entry - entries);
+    if (functionCount == 0 || index >= functions[functionCount - 1].firstEntry) return -1;
+    return captureVariable(functionCount - 1, name, index);
 }
 
 static void resolveStmt(Interpreter* interpreter, Stmt* stmt);
 static void resolveExpr(Interpreter* interpreter, Expr* expr);
 
 static void resolveFunction(Interpreter* interpreter, Stmt* function) {
-    declare(function->as.function.name);
-    define(function->as.function.name);
+    declare(*TOKEN_AT(AS_FUNCTION_STMT(function)->name), STATIC_UNKNOWN);
+    define(*TOKEN_AT(AS_FUNCTION_STMT(function)->name));
+    StaticType enclosingReturnType = currentReturnType;
+    currentReturnType = AS_FUNCTION_STMT(function)->returnType;
+    int enclosingLoopDepth = loopDepth;
+    loopDepth = 0; // a jump can't leave the function
     beginScope();
-    for (int i = 0; i < function->as.function.param_count; i++) {
-        declare(function->as.function.params[i]);
-        define(function->as.function.params[i]);
+
+    if (functionCount >= functionCapacity) {
+        int oldCapacity = functionCapacity;
+        functionCapacity = GROW_CAPACITY(oldCapacity);
+        functions = GROW_ARRAY(FunctionScope, functions, oldCapacity, functionCapacity);
     }
-    StmtList* body = function->as.function.body;
-    while (body != NULL) {
-        resolveStmt(interpreter, body->stmt);
-        body = body->next;
+    functions[functionCount++] = (FunctionScope) { entryCount, NULL, 0, 0 };
+    for (int i = 0; i < AS_FUNCTION_STMT(function)->param_count; i++) {
+        StaticType type = AS_FUNCTION_STMT(function)->paramTypes != NULL ? AS_FUNCTION_STMT(function)->paramTypes[i] : STATIC_UNKNOWN;
+        declare(*TOKEN_AT(AS_FUNCTION_STMT(function)->params + i), type);
+        define(*TOKEN_AT(AS_FUNCTION_STMT(function)->params + i));
     }
+    StmtList* body = AS_STMT_LIST(AS_FUNCTION_STMT(function)->body);
+    declareAhead(body);
+    for (int i = 0; i < STMT_COUNT(body); i++) {
+        resolveStmt(interpreter, LIST_STMT(body, i));
+    }
+
+    FunctionScope* scope = &functions[--functionCount];
+    free(AS_FUNCTION_STMT(function)->upvalues); // from an earlier resolve of the same body
+    AS_FUNCTION_STMT(function)->upvalues = scope->upvalues;
+    AS_FUNCTION_STMT(function)->upvalueCount = scope->upvalueCount;
+    recordFrame(&AS_FUNCTION_STMT(function)->localCount, &AS_FUNCTION_STMT(function)->captured);
     endScope();
+    currentReturnType = enclosingReturnType;
+    loopDepth = enclosingLoopDepth;
 }
 
 static void resolveStmt(Interpreter* interpreter, Stmt* stmt) {
     if (stmt == NULL) return; // defensive check
     switch (stmt->type) {
-        case STMT_BLOCK:
+        case STMT_BLOCK: {
+            StmtList* statements = AS_STMT_LIST(stmt->as.block.statements);
             beginScope();
-            for (StmtList* list = stmt->as.block.statements; list != NULL; list = list->next) {
-                resolveStmt(interpreter, list->stmt);
+            declareAhead(statements);
+            for (int i = 0; i < STMT_COUNT(statements); i++) {
+                resolveStmt(interpreter, LIST_STMT(statements, i));
             }
+            recordFrame(&stmt->as.block.localCount, &stmt->as.block.captured);
             endScope();
             break;
+        }
         case STMT_VAR:
-            printf("Resolving var: %.*s\n", stmt->as.var.name.length, stmt->as.var.name.start);
-            declare(stmt->as.var.name);
-            if (stmt->as.var.initializer != NULL) {
-                resolveExpr(interpreter, stmt->as.var.initializer);
+            declare(*TOKEN_AT(stmt->as.var.name), stmt->as.var.declaredType);
+            if (stmt->as.var.initializer != 0) {
+                resolveExpr(interpreter, AS_EXPR(stmt->as.var.initializer));
             }
-            define(stmt->as.var.name);
+            checkType(stmt->as.var.declaredType, AS_EXPR(stmt->as.var.initializer), TOKEN_AT(stmt->as.var.name)->line, "This variable");
+            define(*TOKEN_AT(stmt->as.var.name));
             break;
         case STMT_FUNCTION:
             resolveFunction(interpreter, stmt);
             break;
         case STMT_EXPRESSION:
-            resolveExpr(interpreter, stmt->as.expression.expression);
+            resolveExpr(interpreter, AS_EXPR(stmt->as.expression.expression));
             break;
         case STMT_PRINT:
-            resolveExpr(interpreter, stmt->as.print.expression);
+            resolveExpr(interpreter, AS_EXPR(stmt->as.print.expression));
             break;
         case STMT_IF:
-            resolveExpr(interpreter, stmt->as.ifStmt.condition);
-            resolveStmt(interpreter, stmt->as.ifStmt.thenBranch);
-            if (stmt->as.ifStmt.elseBranch != NULL)
-                resolveStmt(interpreter, stmt->as.ifStmt.elseBranch);
+            resolveExpr(interpreter, AS_EXPR(stmt->as.ifStmt.condition));
+            resolveStmt(interpreter, AS_STMT(stmt->as.ifStmt.thenBranch));
+            if (stmt->as.ifStmt.elseBranch != 0)
+                resolveStmt(interpreter, AS_STMT(stmt->as.ifStmt.elseBranch));
             break;
         case STMT_WHILE:
-            resolveExpr(interpreter, stmt->as.whileStmt.condition);
-            resolveStmt(interpreter, stmt->as.whileStmt.body);
+            resolveExpr(interpreter, AS_EXPR(stmt->as.whileStmt.condition));
+            loopDepth++;
+            resolveStmt(interpreter, AS_STMT(stmt->as.whileStmt.body));
+            loopDepth--;
+            resolveExpr(interpreter, AS_EXPR(stmt->as.whileStmt.increment));
             break;
         case STMT_RETURN:
-            if (stmt->as.return_stmt.value != NULL) {
-                resolveExpr(interpreter, stmt->as.return_stmt.value);
+            if (stmt->as.return_stmt.value != 0) {
+                resolveExpr(interpreter, AS_EXPR(stmt->as.return_stmt.value));
+            }
+            checkType(currentReturnType, AS_EXPR(stmt->as.return_stmt.value), TOKEN_AT(stmt->as.return_stmt.keyword)->line,
+                      "This function's return value");
+            break;
+        case STMT_BREAK:
+        case STMT_CONTINUE:
+            if (loopDepth == 0) {
+                Token* keyword = TOKEN_AT(stmt->as.jump.keyword);
+                fprintf(stderr, "[line %d] Aiyo problem sia: '%.*s' only can use inside a loop leh.\n",
+                        keyword->line, keyword->length, keyword->start);
+                hadError = true;
             }
             break;
     }
@@ -138,39 +422,49 @@ static void resolveStmt(Interpreter* interpreter, Stmt* stmt) {
 static void resolveExpr(Interpreter* interpreter, Expr* expr) {
     if (expr == NULL) return;
     switch (expr->type) {
-        case EXPR_ASSIGN:
-            resolveExpr(interpreter, expr->as.assign.value);
+        case EXPR_ASSIGN: {
+            resolveExpr(interpreter, AS_EXPR(expr->as.assign.value));
+            // globals are only checked when the assignment runs
+            ScopeEntry* entry = findLocal(TOKEN_AT(expr->as.assign.name));
+            if (entry != NULL) {
+                checkType(entry->type, AS_EXPR(expr->as.assign.value), TOKEN_AT(expr->as.assign.name)->line, "This variable");
+                expr->as.assign.upvalue = upvalueFor(TOKEN_AT(expr->as.assign.name), entry);
+            }
             break;
+        }
         case EXPR_LOGICAL:
-            resolveExpr(interpreter, expr->as.logical.left);
-            resolveExpr(interpreter, expr->as.logical.right);
+            resolveExpr(interpreter, AS_EXPR(expr->as.logical.left));
+            resolveExpr(interpreter, AS_EXPR(expr->as.logical.right));
             break;
         case EXPR_BINARY:
-            resolveExpr(interpreter, expr->as.binary.left);
-            resolveExpr(interpreter, expr->as.binary.right);
+        case EXPR_BINARY_VAR_CONST:
+        case EXPR_BINARY_CONST_VAR:
+        case EXPR_BINARY_VAR_VAR:
+            resolveExpr(interpreter, AS_EXPR(expr->as.binary.left));
+            resolveExpr(interpreter, AS_EXPR(expr->as.binary.right));
             break;
         case EXPR_UNARY:
-            resolveExpr(interpreter, expr->as.unary.right);
+            resolveExpr(interpreter, AS_EXPR(expr->as.unary.right));
             break;
         case EXPR_GROUPING:
-            resolveExpr(interpreter, expr->as.grouping.expression);
+            resolveExpr(interpreter, AS_EXPR(expr->as.grouping.expression));
             break;
         case EXPR_CALL:
-            resolveExpr(interpreter, expr->as.call.callee);
+            resolveExpr(interpreter, AS_EXPR(expr->as.call.callee));
             for (int i = 0; i < expr->as.call.arg_count; i++) {
-                resolveExpr(interpreter, expr->as.call.arguments[i]);
+                resolveExpr(interpreter, CALL_ARGUMENT(&expr->as.call, i));
             }
             break;
         case EXPR_VARIABLE: {
-            for (Scope* scope = scopeStack; scope != NULL; scope = scope->next) {
-                for (int i = 0; i < scope->count; i++) {
-                    if (strncmp(scope->entries[i].name, expr->as.variable.name.start, expr->as.variable.name.length) == 0 && strlen(scope->entries[i].name) == expr->as.variable.name.length) {
-                        if (!scope->entries[i].defined) {
-                            fprintf(stderr, "[line %d] Aiyo problem sia: How to read local variable when initializing itself?\n", expr->as.variable.name.line);
-                        }
-                        return;
-                    }
-                }
+            ScopeEntry* entry = findLocal(TOKEN_AT(expr->as.variable.name));
+            if (entry == NULL) {
+                markGlobal(expr);
+            } else if (!entry->defined) {
+                fprintf(stderr, "[line %d] Aiyo problem sia: How to read local variable when initializing itself?\n",
+                        TOKEN_AT(expr->as.variable.name)->line);
+                hadError = true;
+            } else {
+                expr->as.variable.upvalue = upvalueFor(TOKEN_AT(expr->as.variable.name), entry);
             }
             break;
         }
@@ -180,7 +474,30 @@ static void resolveExpr(Interpreter* interpreter, Expr* expr) {
 }
 
 void resolve(Interpreter* interpreter, StmtList* statements) {
-    for (StmtList* current = statements; current != NULL; current = current->next) {
-        resolveStmt(interpreter, current->stmt);
+    hadError = false;
+    for (int i = 0; i < STMT_COUNT(statements); i++) {
+        resolveStmt(interpreter, LIST_STMT(statements, i));
     }
 }
+
+bool hadResolverError() {
+    return hadError;
+}
+
+void freeResolver() {
+    FREE_ARRAY(ScopeEntry, entries, entryCapacity);
+    FREE_ARRAY(ScopeStart, scopeStarts, scopeCapacity);
+    FREE_ARRAY(GlobalRead, reads, readCapacity);
+    FREE_ARRAY(NameState, names, nameCapacity);
+    FREE_ARRAY(FunctionScope, functions, functionCapacity);
+    entries = NULL;
+    scopeStarts = NULL;
+    reads = NULL;
+    names = NULL;
+    functions = NULL;
+    entryCount = entryCapacity = 0;
+    scopeCount = scopeCapacity = 0;
+    readCount = readCapacity = 0;
+    nameCapacity = 0;
+    functionCount = functionCapacity = 0;
+}
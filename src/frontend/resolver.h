@@ -6,5 +6,9 @@
 typedef struct Interpreter Interpreter;
 
 void resolve(Interpreter* interpreter, StmtList* statements);
+bool hadResolverError();
+
+// free the scope stack, which stays allocated between runs
+void freeResolver();
 
 #endif
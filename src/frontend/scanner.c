@@ -1,5 +1,6 @@
 #include <ctype.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -12,6 +13,15 @@ static Token makeToken(Scanner* scanner, TokenType type) {
     token.start = scanner->start;
     token.length = (int)(scanner->current - scanner->start);
     token.line = scanner->line;
+    token.symbol = NO_SYMBOL;
+    return token;
+}
+
+// identifiers are interned as they are scanned, nothing after the scanner
+// looks at their characters to tell names apart
+static Token identifierToken(Scanner* scanner) {
+    Token token = makeToken(scanner, TOKEN_IDENTIFIER);
+    token.symbol = internSymbol(token.start, token.length);
     return token;
 }
 
@@ -19,17 +29,20 @@ static Token errorToken(Scanner* scanner, const char* message) {
     Token token;
     token.type = TOKEN_ERROR;
 
-    // Allocate a copy of the message so it persists
-    char* messageCopy = strdup(message);
+    // Allocate a copy of the message so it persists. no strdup, it is not C99
+    size_t length = strlen(message);
+    char* messageCopy = malloc(length + 1);
     if (messageCopy == NULL) {
         // Fall back to a static message if allocation fails
         token.start = "Memory error";
     } else {
+        memcpy(messageCopy, message, length + 1);
         token.start = messageCopy;
     }
 
     token.length = (int)strlen(token.start);
     token.line = scanner->line;
+    token.symbol = NO_SYMBOL;
     return token;
 }
 
@@ -58,25 +71,215 @@ static char peekNext(Scanner* scanner) {
     return scanner->current[1];
 }
 
+// --- Fast Paths ---
+// whitespace runs, comments and string bodies are skipped in bulk: find the
+// next byte that matters 16 (SSE2) or 32 (AVX2) bytes at a time, counting the
+// newlines passed on the way so line numbers stay exact. picked once by CPUID.
+//
+// loads are aligned, so a block never crosses into the page after the source's
+// NUL terminator. bytes before the start of the first block are masked off.
+// address sanitizer would still see those as out of bounds, so it gets scalar.
+
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define SCANNER_SANITIZED
+#endif
+#endif
+#if defined(__SANITIZE_ADDRESS__)
+#define SCANNER_SANITIZED
+#endif
+
+#if defined(__GNUC__) && defined(__SSE2__) && !defined(SCANNER_SANITIZED)
+#define SCANNER_SIMD
+#include <immintrin.h>
+#endif
+
+// first byte that isn't ' ', '\r', '\t' or '\n'
+typedef const char* (*SkipBlankFn)(const char* p, int* lines);
+// first '\n' or NUL
+typedef const char* (*FindLineEndFn)(const char* p);
+// first '"' or NUL
+typedef const char* (*FindQuoteFn)(const char* p, int* lines);
+
+static bool isBlank(char c) {
+    return c == ' ' || c == '\r' || c == '\t' || c == '\n';
+}
+
+static const char* skipBlankScalar(const char* p, int* lines) {
+    while (isBlank(*p)) {
+        if (*p == '\n') (*lines)++;
+        p++;
+    }
+    return p;
+}
+
+static const char* findLineEndScalar(const char* p) {
+    while (*p != '\n' && *p != '\0') p++;
+    return p;
+}
+
+static const char* findQuoteScalar(const char* p, int* lines) {
+    while (*p != '"' && *p != '\0') {
+        if (*p == '\n') (*lines)++;
+        p++;
+    }
+    return p;
+}
+
+#ifdef SCANNER_SIMD
+
+// bits of a block mask below index
+#define BELOW(index) ((1u << (index)) - 1)
+
+// one block width. VEC, LOAD, SPLAT, EQ, OR and MASK name the intrinsics.
+// each body loops over aligned blocks starting at the one holding p, and
+// stops at the first block with a byte it wants. the NUL always qualifies.
+#define FAST_PATHS(suffix, attr, width, VEC, LOAD, SPLAT, EQ, OR, MASK)      \
+    attr static const char* skipBlank##suffix(const char* p, int* lines) {   \
+        const VEC space = SPLAT(' '), cr = SPLAT('\r');                      \
+        const VEC tab = SPLAT('\t'), nl = SPLAT('\n');                       \
+        unsigned offset = (unsigned)((uintptr_t)p & (width - 1));            \
+        const char* block = p - offset;                                      \
+        unsigned before = BELOW(offset);                                     \
+        for (;;) {                                                           \
+            VEC chunk = LOAD((const VEC*)block);                             \
+            VEC newline = EQ(chunk, nl);                                     \
+            VEC blank = OR(OR(EQ(chunk, space), EQ(chunk, cr)),              \
+                           OR(EQ(chunk, tab), newline));                     \
+            unsigned newlines = (unsigned)MASK(newline) & ~before;           \
+            unsigned stop = ~(unsigned)MASK(blank) & ~before;                \
+            if (width < 32) stop &= 0xFFFFu;                                 \
+            if (stop != 0) {                                                 \
+                int index = __builtin_ctz(stop);                             \
+                *lines += __builtin_popcount(newlines & BELOW(index));       \
+                return block + index;                                        \
+            }                                                                \
+            *lines += __builtin_popcount(newlines);                          \
+            block += width;                                                  \
+            before = 0;                                                      \
+        }                                                                    \
+    }                                                                        \
+                                                                             \
+    attr static const char* findLineEnd##suffix(const char* p) {             \
+        const VEC nl = SPLAT('\n'), nul = SPLAT('\0');                       \
+        unsigned offset = (unsigned)((uintptr_t)p & (width - 1));            \
+        const char* block = p - offset;                                      \
+        unsigned before = BELOW(offset);                                     \
+        for (;;) {                                                           \
+            VEC chunk = LOAD((const VEC*)block);                             \
+            unsigned stop = (unsigned)MASK(OR(EQ(chunk, nl), EQ(chunk, nul))) \
+                            & ~before;                                       \
+            if (stop != 0) return block + __builtin_ctz(stop);               \
+            block += width;                                                  \
+            before = 0;                                                      \
+        }                                                                    \
+    }                                                                        \
+                                                                             \
+    attr static const char* findQuote##suffix(const char* p, int* lines) {   \
+        const VEC quote = SPLAT('"'), nl = SPLAT('\n'), nul = SPLAT('\0');   \
+        unsigned offset = (unsigned)((uintptr_t)p & (width - 1));            \
+        const char* block = p - offset;                                      \
+        unsigned before = BELOW(offset);                                     \
+        for (;;) {                                                           \
+            VEC chunk = LOAD((const VEC*)block);                             \
+            unsigned newlines = (unsigned)MASK(EQ(chunk, nl)) & ~before;     \
+            unsigned stop = (unsigned)MASK(OR(EQ(chunk, quote),              \
+                                              EQ(chunk, nul))) & ~before;    \
+            if (stop != 0) {                                                 \
+                int index = __builtin_ctz(stop);                             \
+                *lines += __builtin_popcount(newlines & BELOW(index));       \
+                return block + index;                                        \
+            }                                                                \
+            *lines += __builtin_popcount(newlines);                          \
+            block += width;                                                  \
+            before = 0;                                                      \
+        }                                                                    \
+    }
+
+// SSE2 is part of x86-64, so it needs no check
+FAST_PATHS(Sse2, , 16, __m128i, _mm_load_si128, _mm_set1_epi8,
+           _mm_cmpeq_epi8, _mm_or_si128, _mm_movemask_epi8)
+FAST_PATHS(Avx2, __attribute__((target("avx2"))), 32, __m256i,
+           _mm256_load_si256, _mm256_set1_epi8, _mm256_cmpeq_epi8,
+           _mm256_or_si256, _mm256_movemask_epi8)
+
+#undef BELOW
+#undef FAST_PATHS
+
+#endif
+
+static SkipBlankFn skipBlankRun = skipBlankScalar;
+static FindLineEndFn findLineEndRun = findLineEndScalar;
+static FindQuoteFn findQuoteRun = findQuoteScalar;
+
+// most runs are a space or an indent, far too short to pay for setting up
+// blocks. look at the first SHORT_RUN bytes one at a time, then go wide.
+#define SHORT_RUN 16
+
+static const char* skipBlank(const char* p, int* lines) {
+    for (const char* end = p + SHORT_RUN; p < end; p++) {
+        if (!isBlank(*p)) return p;
+        if (*p == '\n') (*lines)++;
+    }
+    return skipBlankRun(p, lines);
+}
+
+static const char* findLineEnd(const char* p) {
+    for (const char* end = p + SHORT_RUN; p < end; p++) {
+        if (*p == '\n' || *p == '\0') return p;
+    }
+    return findLineEndRun(p);
+}
+
+static const char* findQuote(const char* p, int* lines) {
+    for (const char* end = p + SHORT_RUN; p < end; p++) {
+        if (*p == '"' || *p == '\0') return p;
+        if (*p == '\n') (*lines)++;
+    }
+    return findQuoteRun(p, lines);
+}
+
+static void pickFastPaths() {
+#ifdef SCANNER_SIMD
+    static bool picked = false;
+    if (picked) return;
+    picked = true;
+
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        skipBlankRun = skipBlankAvx2;
+        findLineEndRun = findLineEndAvx2;
+        findQuoteRun = findQuoteAvx2;
+    } else {
+        skipBlankRun = skipBlankSse2;
+        findLineEndRun = findLineEndSse2;
+        findQuoteRun = findQuoteSse2;
+    }
+#endif
+}
+
+const char* scannerFastPath() {
+    pickFastPaths();
+    if (skipBlankRun == skipBlankScalar) return "scalar";
+#ifdef SCANNER_SIMD
+    if (skipBlankRun == skipBlankAvx2) return "avx2";
+#endif
+    return "sse2";
+}
+
 static void skipWhitespace(Scanner* scanner) {
     for (;;) {
-        char c = peek(scanner);
-        switch (c) {
+        switch (peek(scanner)) {
             case ' ':
             case '\r':
             case '\t':
-                advance(scanner);
-                break;
             case '\n':
-                scanner->line++;
-                advance(scanner);
+                scanner->current = skipBlank(scanner->current, &scanner->line);
                 break;
             case '/':
                 if (peekNext(scanner) == '/') {
                     // A comment goes until the end of the line.
-                    while (peek(scanner) != '\n' && !isAtEnd(scanner)) {
-                        advance(scanner);
-                    }
+                    scanner->current = findLineEnd(scanner->current);
                 } else {
                     return;
                 }
@@ -116,10 +319,7 @@ static Token number(Scanner* scanner) {
 }
 
 static Token string(Scanner* scanner) {
-    while (peek(scanner) != '"' && !isAtEnd(scanner)) {
-        if (peek(scanner) == '\n') scanner->line++;
-        advance(scanner);
-    }
+    scanner->current = findQuote(scanner->current, &scanner->line);
 
     if (isAtEnd(scanner)) return errorToken(scanner, "Unterminated string.");
 
@@ -128,106 +328,46 @@ static Token string(Scanner* scanner) {
     return makeToken(scanner, TOKEN_STRING);
 }
 
-static TokenType checkKeyword(Scanner* scanner, int start, int length,
-                              const char* rest, TokenType type) {
-    if (scanner->current - scanner->start == start + length && memcmp(scanner->start + start, rest, length) == 0) {
-        return type;
-    }
+// --- Keywords ---
 
-    return TOKEN_IDENTIFIER;
-}
-
-static TokenType identifierType(Scanner* scanner) {
-    switch (scanner->start[0]) {
-        case 'a':
-            return checkKeyword(scanner, 1, 2, "nd", TOKEN_AND);
-        case 'c':
-            if (scanner->current - scanner->start > 1) {
-                switch (scanner->start[1]) {
-                    case 'a':
-                        if (scanner->current - scanner->start > 2 && scanner->start[2] == 'n') {
-                            if (scanner->current - scanner->start > 5 && scanner->start[3] == 'n' && scanner->start[4] == 'o' && scanner->start[5] == 't') {
-                                return TOKEN_CANNOT;
-                            }
-                            return TOKEN_CAN;
-                        }
-                        break;
-                    case 'o':
-                        return checkKeyword(scanner, 2, 5, "rrect", TOKEN_CORRECT);
-                    case 'h':
-                        return checkKeyword(scanner, 2, 3, "ope", TOKEN_CHOPE);
-                }
-            }
-            break;
-        case 'd':
-            return checkKeyword(scanner, 2, 1, "o again", TOKEN_DO_AGAIN_FROM);
-        case 'f':
-            if (scanner->current - scanner->start > 1) {
-                switch (scanner->start[1]) {
-                }
-            }
-            break;
-        case 'h':
-            return checkKeyword(scanner, 1, 4, "owdo", TOKEN_HOWDO);
-        case 'k':
-            return checkKeyword(scanner, 2, 3, "eep doing", TOKEN_KEEP_DOING);
-        case 'l':
-            return checkKeyword(scanner, 1, 2, "ah", TOKEN_LAH);
-        case 'n':
-            return checkKeyword(scanner, 1, 2, "il", TOKEN_NIL);
-        case 'o':
-            return checkKeyword(scanner, 1, 1, "r", TOKEN_OR);
-        case 'p':
-            return checkKeyword(scanner, 1, 4, "rint", TOKEN_PRINT);
-        case 'r':
-            return checkKeyword(scanner, 1, 5, "eturn", TOKEN_RETURN);
-        case 's':
-            return checkKeyword(scanner, 1, 4, "uper", TOKEN_SUPER);
-        case 't':
-            return checkKeyword(scanner, 1, 3, "his", TOKEN_THIS);
-        case 'w':
-            return checkKeyword(scanner, 1, 4, "rong", TOKEN_WRONG);
-    }
+typedef struct {
+    const char* phrase; // multi-word keywords are separated by single spaces
+    int wordLength; // of the first word
+    int phraseLength;
+    TokenType type;
+} Keyword;
 
-    return TOKEN_IDENTIFIER;
-}
+// the keywords table and KEYWORD_HASH, generated at build time from
+// keywords.def (see tools/genkeywords.c). every keyword has a slot of its own.
+#include "keywords.h"
 
 static Token identifier(Scanner* scanner) {
     while (isAlphaNumeric(peek(scanner)))
         advance(scanner);
 
-    return makeToken(scanner, identifierType(scanner));
+    int length = (int)(scanner->current - scanner->start);
+    const Keyword* keyword = &keywords[KEYWORD_HASH(scanner->start, length)];
+    if (keyword->wordLength != length || memcmp(scanner->start, keyword->phrase, length) != 0) {
+        return identifierToken(scanner);
+    }
+
+    if (keyword->phraseLength > length) {
+        // only a keyword with the rest of its words after it, strncmp stops at the end of the source
+        if (strncmp(scanner->start, keyword->phrase, keyword->phraseLength) != 0 || isAlphaNumeric(scanner->start[keyword->phraseLength])) {
+            return identifierToken(scanner);
+        }
+        scanner->current = scanner->start + keyword->phraseLength;
+    }
+    return makeToken(scanner, keyword->type);
 }
 
-static Token scanToken(Scanner* scanner) {
+Token scanToken(Scanner* scanner) {
     skipWhitespace(scanner);
 
     scanner->start = scanner->current;
 
     if (isAtEnd(scanner)) return makeToken(scanner, TOKEN_EOF);
 
-    // check for multi-word keywords
-    const char* curr = scanner->current;
-    int remaining = 0;
-
-    remaining = 0;
-    while (curr[remaining] != '\0')
-        remaining++;
-
-    if (remaining >= 10 && strncmp(curr, "keep", 4) == 0 && curr[4] == ' ' && strncmp(curr + 5, "doing", 5) == 0 && (curr[10] == '\0' || !isAlphaNumeric(curr[10]))) {
-        scanner->current += 10;
-        return makeToken(scanner, TOKEN_KEEP_DOING);
-    }
-
-    remaining = 0;
-    while (curr[remaining] != '\0')
-        remaining++;
-
-    if (remaining >= 13 && strncmp(curr, "do", 2) == 0 && curr[2] == ' ' && strncmp(curr + 3, "again", 5) == 0 && curr[8] == ' ' && strncmp(curr + 9, "from", 4) == 0 && (curr[13] == '\0' || !isAlphaNumeric(curr[13]))) {
-        scanner->current += 13;
-        return makeToken(scanner, TOKEN_DO_AGAIN_FROM);
-    }
-
     char c = advance(scanner);
 
     if (isAlpha(c)) return identifier(scanner);
@@ -246,6 +386,8 @@ static Token scanToken(Scanner* scanner) {
             return makeToken(scanner, TOKEN_SEMICOLON);
         case ',':
             return makeToken(scanner, TOKEN_COMMA);
+        case ':':
+            return makeToken(scanner, TOKEN_COLON);
         case '.':
             return makeToken(scanner, TOKEN_DOT);
         case '-':
@@ -277,29 +419,7 @@ void initScanner(Scanner* scanner, const char* source) {
     scanner->start = source;
     scanner->current = source;
     scanner->line = 1;
-}
-
-Token* scanTokens(Scanner* scanner, int* tokenCount) {
-    // Preallocate some tokens to start with
-    int capacity = 8;
-    Token* tokens = (Token*)malloc(sizeof(Token) * capacity);
-    int count = 0;
-
-    for (;;) {
-        // Resize array if needed
-        if (count >= capacity) {
-            capacity = capacity * 2;
-            tokens = (Token*)realloc(tokens, sizeof(Token) * capacity);
-        }
-
-        Token token = scanToken(scanner);
-        tokens[count++] = token;
-
-        if (token.type == TOKEN_EOF) break;
-    }
-
-    *tokenCount = count;
-    return tokens;
+    pickFastPaths();
 }
 
 void printToken(Token token) {
@@ -321,6 +441,9 @@ void printToken(Token token) {
         case TOKEN_COMMA:
             printf("COMMA");
             break;
+        case TOKEN_COLON:
+            printf("COLON");
+            break;
         case TOKEN_DOT:
             printf("DOT");
             break;
@@ -420,6 +543,12 @@ void printToken(Token token) {
         case TOKEN_KEEP_DOING:
             printf("KEEP DOING");
             break;
+        case TOKEN_CABUT:
+            printf("CABUT");
+            break;
+        case TOKEN_CARRY_ON:
+            printf("CARRY ON");
+            break;
         case TOKEN_ERROR:
             printf("ERROR");
             break;
@@ -441,12 +570,9 @@ void printToken(Token token) {
     printf("\n");
 }
 
-void freeTokens(Token* tokens, int tokenCount) {
-    for (int i = 0; i < tokenCount; i++) {
-        if (tokens[i].type == TOKEN_ERROR) {
-            // Free the allocated error message
-            free((void*)tokens[i].start);
-        }
+void freeToken(Token token) {
+    if (token.type == TOKEN_ERROR) {
+        // Free the allocated error message
+        free((void*)token.start);
     }
-    free(tokens);
 }
@@ -3,6 +3,8 @@
 
 #include <stdbool.h>
 
+#include "symbol.h"
+
 // Token types
 typedef enum {
     // Single-character tokens
@@ -11,6 +13,7 @@ typedef enum {
     TOKEN_LEFT_BRACE,
     TOKEN_RIGHT_BRACE,
     TOKEN_COMMA,
+    TOKEN_COLON,
     TOKEN_DOT,
     TOKEN_MINUS,
     TOKEN_PLUS,
@@ -50,6 +53,8 @@ typedef enum {
     TOKEN_CORRECT,
     TOKEN_CHOPE,
     TOKEN_KEEP_DOING,
+    TOKEN_CABUT,
+    TOKEN_CARRY_ON,
 
     TOKEN_ERROR,
     TOKEN_EOF,
@@ -63,6 +68,7 @@ typedef struct {
     const char* start;
     unsigned int length;
     int line;
+    SymbolId symbol; // identifiers only, NO_SYMBOL for everything else
 } Token;
 
 // Scanner structure
@@ -75,11 +81,16 @@ typedef struct {
 // Initialize scanner with source code
 void initScanner(Scanner* scanner, const char* source);
 
-// Scan all tokens from the source
-Token* scanTokens(Scanner* scanner, int* tokenCount);
+// Scan the next token. tokens are pulled one at a time by the parser, the
+// source is never turned into a token array up front.
+Token scanToken(Scanner* scanner);
+
+// Which bulk skipping path the scanner picked for this CPU: "avx2", "sse2"
+// or "scalar"
+const char* scannerFastPath();
 
-// Free tokens array and any dynamically allocated error messages
-void freeTokens(Token* tokens, int tokenCount);
+// Free the dynamically allocated message of an error token, if it is one
+void freeToken(Token token);
 
 // Get a human-readable representation of token type
 const char* tokenTypeToString(TokenType type);
@@ -0,0 +1,126 @@
+// mmap, madvise and MAP_ANONYMOUS are not C99
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../runtime/memory.h"
+#include "source.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SOURCE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// --- Streaming Reads ---
+
+// path is only for the error message, NULL to stay quiet
+
+static bool readStream(Source* source, FILE* file, const char* path) {
+    size_t capacity = 0;
+    size_t length = 0;
+    char* buffer = NULL;
+
+    for (;;) {
+        // always leave room for the terminator
+        if (capacity - length < 2) {
+            size_t oldCapacity = capacity;
+            capacity = oldCapacity < 4096 ? 4096 : GROW_CAPACITY(oldCapacity);
+            buffer = GROW_ARRAY(char, buffer, oldCapacity, capacity);
+        }
+        size_t bytesRead = fread(buffer + length, 1, capacity - length - 1, file);
+        length += bytesRead;
+        if (bytesRead == 0) break;
+    }
+
+    if (ferror(file)) {
+        if (path != NULL) fprintf(stderr, "Aiyo, cannot read file \"%s\" lah.\n", path);
+        FREE_ARRAY(char, buffer, capacity);
+        return false;
+    }
+
+    buffer[length] = '\0';
+    source->text = buffer;
+    source->length = length;
+    source->mappedSize = 0;
+    return true;
+}
+
+// --- Mapping ---
+
+#ifdef SOURCE_MMAP
+
+// map a regular file followed by at least one zero byte. false if it can't
+// be mapped, the caller reads it instead.
+static bool mapFile(Source* source, int fd) {
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size <= 0) return false;
+
+    size_t length = (size_t)info.st_size;
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t mappedSize = (length / page + 1) * page; // room for the terminator
+
+    // reserve zeroed pages for the whole range, then put the file over the
+    // front of it. the file's last page is zero-filled past its end, and if
+    // the file fills it exactly, the reserved page after it is still zero.
+    char* base = mmap(NULL, mappedSize, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) return false;
+    if (mmap(base, length, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(base, mappedSize);
+        return false;
+    }
+    // the scanner reads it front to back once
+    madvise(base, length, MADV_SEQUENTIAL);
+
+    source->text = base;
+    source->length = length;
+    source->mappedSize = mappedSize;
+    return true;
+}
+
+#endif
+
+// map file, or read it if that doesn't work. closes file.
+static bool loadFile(Source* source, FILE* file, const char* path) {
+#ifdef SOURCE_MMAP
+    if (mapFile(source, fileno(file))) {
+        fclose(file); // the mapping stays valid without the descriptor
+        return true;
+    }
+#endif
+
+    bool loaded = readStream(source, file, path);
+    fclose(file);
+    return loaded;
+}
+
+bool loadSource(Source* source, const char* path) {
+    if (strcmp(path, "-") == 0) return readStream(source, stdin, "<stdin>");
+
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "Alamak, cannot open file \"%s\" sia.\n", path);
+        return false;
+    }
+    return loadFile(source, file, path);
+}
+
+bool loadSourceQuietly(Source* source, const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) return false;
+    return loadFile(source, file, NULL);
+}
+
+void freeSource(Source* source) {
+#ifdef SOURCE_MMAP
+    if (source->mappedSize > 0) munmap((void*)source->text, source->mappedSize);
+#endif
+    if (source->mappedSize == 0) FREE_ARRAY(char, (char*)source->text, source->length + 1);
+    source->text = NULL;
+    source->length = 0;
+    source->mappedSize = 0;
+}
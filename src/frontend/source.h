@@ -0,0 +1,30 @@
+#ifndef sg_source_h
+#define sg_source_h
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// a script's text, loaded for the scanner. tokens and AST nodes point straight
+// into it, so it has to outlive them. text is always NUL-terminated.
+//
+// regular files are mmapped read-only instead of copied into a buffer; the
+// page after the file is mapped too so the terminator is there even when the
+// file ends exactly on a page boundary. anything that can't be mapped (stdin,
+// pipes, empty files) is read in chunks into a growing buffer.
+typedef struct {
+    const char* text;
+    size_t length;
+    size_t mappedSize; // 0 if text is a heap buffer
+} Source;
+
+// load path, or standard input if path is "-". prints why and returns false
+// if that doesn't work.
+bool loadSource(Source* source, const char* path);
+
+// the same for files that may well not be there, like caches: no messages,
+// and no "-" for stdin
+bool loadSourceQuietly(Source* source, const char* path);
+
+void freeSource(Source* source);
+
+#endif
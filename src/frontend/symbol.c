@@ -0,0 +1,91 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "../runtime/memory.h"
+#include "symbol.h"
+
+typedef struct {
+    char* chars;
+    unsigned length;
+    uint32_t hash;
+} Symbol;
+
+// symbols[id] is the name of id, symbols[0] stays unused for NO_SYMBOL
+static Symbol* symbols = NULL;
+static uint32_t symbolCount = 0;
+static uint32_t symbolCapacity = 0;
+
+// open addressing with linear probing, a power of two at most half full.
+// slots hold symbols, NO_SYMBOL when empty.
+static SymbolId* slots = NULL;
+static uint32_t slotCapacity = 0;
+
+// FNV-1a
+static uint32_t hashName(const char* chars, unsigned length) {
+    uint32_t hash = 2166136261u;
+    for (unsigned i = 0; i < length; i++) {
+        hash ^= (uint8_t)chars[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void growSlots() {
+    uint32_t capacity = slotCapacity < 64 ? 64 : slotCapacity * 2;
+    SymbolId* grown = ALLOCATE(SymbolId, capacity);
+    memset(grown, 0, sizeof(SymbolId) * capacity);
+    for (uint32_t id = 1; id < symbolCount; id++) {
+        uint32_t index = symbols[id].hash & (capacity - 1);
+        while (grown[index] != NO_SYMBOL) index = (index + 1) & (capacity - 1);
+        grown[index] = id;
+    }
+    FREE_ARRAY(SymbolId, slots, slotCapacity);
+    slots = grown;
+    slotCapacity = capacity;
+}
+
+SymbolId internSymbol(const char* chars, unsigned length) {
+    if (symbolCount == 0) symbolCount = 1;
+    if ((symbolCount + 1) * 2 > slotCapacity) growSlots();
+
+    uint32_t hash = hashName(chars, length);
+    uint32_t index = hash & (slotCapacity - 1);
+    for (; slots[index] != NO_SYMBOL; index = (index + 1) & (slotCapacity - 1)) {
+        Symbol* symbol = &symbols[slots[index]];
+        if (symbol->hash == hash && symbol->length == length && memcmp(symbol->chars, chars, length) == 0) {
+            return slots[index];
+        }
+    }
+
+    if (symbolCount >= symbolCapacity) {
+        symbolCapacity = GROW_CAPACITY(symbolCapacity);
+        symbols = GROW_ARRAY(Symbol, symbols, symbolCount, symbolCapacity);
+    }
+    char* copy = ALLOCATE(char, length + 1);
+    memcpy(copy, chars, length);
+    copy[length] = '\0';
+    symbols[symbolCount] = (Symbol) { copy, length, hash };
+    slots[index] = symbolCount;
+    return symbolCount++;
+}
+
+const char* symbolName(SymbolId symbol) {
+    return symbol != NO_SYMBOL && symbol < symbolCount ? symbols[symbol].chars : "";
+}
+
+SymbolId symbolLimit() {
+    return symbolCount == 0 ? 1 : symbolCount;
+}
+
+void freeSymbols() {
+    for (uint32_t id = 1; id < symbolCount; id++) {
+        FREE(char, symbols[id].chars);
+    }
+    FREE_ARRAY(Symbol, symbols, symbolCapacity);
+    FREE_ARRAY(SymbolId, slots, slotCapacity);
+    symbols = NULL;
+    slots = NULL;
+    symbolCount = 0;
+    symbolCapacity = 0;
+    slotCapacity = 0;
+}
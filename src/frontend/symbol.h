@@ -0,0 +1,27 @@
+#ifndef sg_symbol_h
+#define sg_symbol_h
+
+#include <stdint.h>
+
+// interned identifiers. the scanner turns every identifier into a symbol, a
+// small number that is the same for the same name everywhere in the process,
+// so later stages compare names as integers. symbols are dense (1, 2, 3...),
+// tables can be indexed by them directly.
+typedef uint32_t SymbolId;
+
+// not a symbol, for tokens that are not identifiers
+#define NO_SYMBOL 0
+
+// the symbol for a name, made the first time the name is seen
+SymbolId internSymbol(const char* chars, unsigned length);
+
+// the name of a symbol, NUL terminated. good until freeSymbols.
+const char* symbolName(SymbolId symbol);
+
+// every symbol so far is below this
+SymbolId symbolLimit();
+
+// forget every symbol, once no token or environment needs them anymore
+void freeSymbols();
+
+#endif
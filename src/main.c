@@ -2,73 +2,140 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
+#include "ast/pool.h"
+#include "backend/closure.h"
 #include "backend/environment.h"
+#include "backend/image.h"
 #include "backend/interpreter.h"
+#include "frontend/cache.h"
+#include "frontend/optimizer.h"
 #include "frontend/parser.h"
 #include "frontend/resolver.h"
 #include "frontend/scanner.h"
+#include "frontend/source.h"
+#include "runtime/memo.h"
+#include "runtime/memory.h"
 #include "runtime/object.h"
 
 static bool hadScanParseError = false;
 
+// command-line switches
+static bool dumpOptimizations = false;
+static bool memoize = false;
+static Engine engine = ENGINE_TREE;
+static bool timePhases = false;
+static bool stream = false;
+static bool useCache = true;
+static bool lazy = false;
+static const char* snapshotPath = NULL;
+static const char* imagePath = NULL;
+
 // static void report(int line, const char* where, const char* message) {
 //     fprintf(stderr, "[line %d] Aiyo problem sia%s: %s\n", line, where ? where : "",
 //             message);
 //     hadScanParseError = true;
 // }
 
-static void run(const char* source);
+// whether the parser may skip function bodies until they are called, see
+// parseFunctionBody
+static bool lazyBodies = false;
+
+// the program whose skipped bodies loadBody parses
+static StmtList* program = NULL;
+
+static bool loadBody(Stmt* function);
+static void run(const char* source, const char* cachePath);
+static void runStream(const char* source);
+static void execute(const char* source, StmtList* statements);
 static void runFile(const char* path);
 static void runPrompt(void);
 
+static void usage(void) {
+    printf("Usage: sg [--dump-opt] [--memoize] [--engine=tree|closure] [--time-phases] [--stream] [--no-cache]\n"
+           "          [--lazy] [--snapshot image | --image image] [script | -]\n");
+    exit(64); // EX_USAGE
+}
+
 int main(int argc, char* argv[]) {
+    const char* path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--dump-opt") == 0) {
+            dumpOptimizations = true;
+        } else if (strcmp(argv[i], "--memoize") == 0) {
+            memoize = true;
+        } else if (strcmp(argv[i], "--engine=tree") == 0) {
+            engine = ENGINE_TREE;
+        } else if (strcmp(argv[i], "--engine=closure") == 0) {
+            engine = ENGINE_CLOSURE;
+        } else if (strcmp(argv[i], "--time-phases") == 0) {
+            timePhases = true;
+        } else if (strcmp(argv[i], "--stream") == 0) {
+            stream = true;
+        } else if (strcmp(argv[i], "--no-cache") == 0) {
+            useCache = false;
+        } else if (strcmp(argv[i], "--lazy") == 0) {
+            lazy = true;
+        } else if (strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc) {
+            snapshotPath = argv[++i];
+        } else if (strcmp(argv[i], "--image") == 0 && i + 1 < argc) {
+            imagePath = argv[++i];
+        } else if (strncmp(argv[i], "--", 2) == 0 || path != NULL) {
+            usage();
+        } else {
+            path = argv[i];
+        }
+    }
+    // a snapshot is of what a script left behind
+    if (snapshotPath != NULL && path == NULL) usage();
+    // only when asked for: errors in a skipped body are not reported until
+    // the function is called, after whatever ran before that. --dump-opt
+    // shows what the optimizer did to every function, and --memoize needs
+    // them all to tell which are pure. the REPL frees each line's nodes before
+    // the functions in it are called.
+    lazyBodies = lazy && !dumpOptimizations && !memoize && path != NULL;
+
     initInterpreter(); // Initialize global environment, etc.
+    // a function is pure only if nothing rebinds what it calls, and the REPL
+    // can't know what a later line will rebind
+    setMemoization(memoize && path != NULL);
+    setEngine(engine);
+    setBodyLoader(loadBody);
+    if (imagePath != NULL && !loadImage(imagePath)) exit(74); // EX_IOERR
+    // the REPL frees the AST after every line, bodies parsed later with it
+    if (imagePath != NULL && path == NULL && !loadImageBodies()) exit(65); // EX_DATAERR
 
-    if (argc > 2) {
-        printf("Usage: sg [script]\n");
-        exit(64); // EX_USAGE
-    } else if (argc == 2) {
-        runFile(argv[1]);
+    if (path != NULL) {
+        runFile(path);
     } else {
         runPrompt();
     }
 
     freeInterpreter(); // Clean up global environment
+    freeImage();
+    freeResolver();
+    freeSymbols(); // last, names of everything above point in here
     return 0;
 }
 
 static void runFile(const char* path) {
-    FILE* file = fopen(path, "rb");
-    if (file == NULL) {
-        fprintf(stderr, "Alamak, cannot open file \"%s\" sia.\n", path);
-        exit(74); // EX_IOERR
-    }
-
-    fseek(file, 0L, SEEK_END);
-    size_t fileSize = ftell(file);
-    rewind(file);
-
-    char* buffer = (char*)malloc(fileSize + 1);
-    if (buffer == NULL) {
-        fprintf(stderr, "Wah, not enough memory to read \"%s\" leh.\n", path);
-        fclose(file);
-        exit(74); // EX_IOERR or EX_OSERR
-    }
+    Source source;
+    if (!loadSource(&source, path)) exit(74); // EX_IOERR
 
-    size_t bytesRead = fread(buffer, sizeof(char), fileSize, file);
-    if (bytesRead < fileSize && ferror(file)) {
-        fprintf(stderr, "Aiyo, cannot read file \"%s\" lah.\n", path);
-        free(buffer);
-        fclose(file);
-        exit(74); // EX_IOERR
+    if (stream) {
+        runStream(source.text);
+    } else if (useCache && !dumpOptimizations && imagePath == NULL && strcmp(path, "-") != 0) {
+        // --dump-opt wants to see the optimizer at work, not its saved result.
+        // after --image the optimizer also looks at the image's functions,
+        // which a cache knows nothing about.
+        char* cachePath = cachePathFor(path);
+        run(source.text, cachePath);
+        FREE(char, cachePath);
+    } else {
+        run(source.text, NULL);
     }
-
-    buffer[bytesRead] = '\0';
-    fclose(file);
-
-    run(buffer);
-    free(buffer);
+    freeSource(&source);
 
     if (hadScanParseError) exit(65); // EX_DATAERR
     if (hadRuntimeError()) exit(70); // EX_SOFTWARE
@@ -90,49 +157,204 @@ static void runPrompt(void) {
             break;
         }
 
-        run(line); // Execute the line
+        run(line, NULL); // Execute the line
 
         hadScanParseError = false;
     }
 }
 
-static void run(const char* source) {
-    Scanner scanner;
-    initScanner(&scanner, source);
-    int tokenCount = 0;
-    Token* tokens = scanTokens(&scanner, &tokenCount);
+// --time-phases: how long each step of run() took, on stderr. bytes > 0 also
+// gives the throughput over the source.
+static void printPhase(const char* phase, clock_t elapsed, size_t bytes) {
+    if (!timePhases) return;
+    double seconds = (double)elapsed / CLOCKS_PER_SEC;
+    if (bytes > 0 && seconds > 0) {
+        fprintf(stderr, "[time] %-9s %9.3f ms %9.1f MB/s\n", phase, seconds * 1000, bytes / seconds / 1e6);
+    } else {
+        fprintf(stderr, "[time] %-9s %9.3f ms\n", phase, seconds * 1000);
+    }
+}
+
+static void reportPhase(const char* phase, clock_t since, size_t bytes) {
+    printPhase(phase, clock() - since, bytes);
+}
 
-    // TODO: Check for scanner errors if scanTokens indicates them
+// --snapshot: save the globals a script left behind, if it ran to the end.
+// function declarations point into the AST, so this comes before freeing it.
+static void snapshot(const char* source) {
+    if (snapshotPath == NULL || hadScanParseError || hadRuntimeError()) return;
+    if (!saveImage(snapshotPath, source, strlen(source))) exit(74); // EX_IOERR
+}
 
+// time spent in loadBody, which --time-phases counts as running
+static clock_t lazyTime = 0;
+static int bodiesLoaded = 0;
+
+// the BodyLoader: the front end for one function body the parser skipped,
+// when it is first called
+static bool loadBody(Stmt* function) {
+    clock_t phaseStart = clock();
+    bool loaded = parseFunctionBody(function);
+    if (loaded) {
+        NodeIndex declaration = nodeIndex(function);
+        resolve(NULL, newStmtList(&declaration, 1));
+        loaded = !hadResolverError();
+    }
+    // --stream runs no optimizer, see runStream
+    if (loaded && !stream) optimizeFunction(function, program);
+    lazyTime += clock() - phaseStart;
+    bodiesLoaded++;
+    return loaded;
+}
+
+// cachePath is where the front end's output for source is saved, NULL to
+// not use a cache
+static void run(const char* source, const char* cachePath) {
+    size_t sourceLength = strlen(source);
+    clock_t phaseStart = clock();
+
+    if (cachePath != NULL) {
+        StmtList* statements = loadCache(cachePath, source, sourceLength, lazyBodies);
+        if (statements != NULL) {
+            reportPhase("load", phaseStart, sourceLength);
+            execute(source, statements);
+            return;
+        }
+    }
+
+    // the parser pulls tokens from the scanner as it goes, this times both
+    Scanner scanner;
+    initScanner(&scanner, source);
     Parser parser;
-    initParser(&parser, tokens, tokenCount);
+    initParser(&parser, &scanner);
+    parser.lazyBodies = lazyBodies;
     StmtList* statements = parse(&parser);
+    reportPhase("parse", phaseStart, sourceLength);
 
     // debugging
     if (statements == NULL) {
         // printf("Parser returned NULL (parse error or empty input).\n");
-        freeTokens(tokens, tokenCount);
+        if (hadParserError(&parser)) hadScanParseError = true;
+        freeAstPool(); // nodes of statements that failed to parse
         return;
     }
 
+    phaseStart = clock();
     resolve(NULL, statements);
-    // Stop if there was a syntax error during parsing.
-    if (hadParserError(&parser)) {
+    reportPhase("resolve", phaseStart, 0);
+    // Stop if there was a syntax error during parsing, or a type mismatch the resolver can already see.
+    if (hadParserError(&parser) || hadResolverError()) {
         hadScanParseError = true;
         freeStmtList(statements);
-        freeTokens(tokens, tokenCount);
+        freeAstPool();
         return;
     }
 
     if (hadRuntimeError()) {
         freeStmtList(statements);
-        freeTokens(tokens, tokenCount);
+        freeAstPool();
         return;
     }
 
+    phaseStart = clock();
+    statements = optimize(statements, dumpOptimizations);
+    reportPhase("optimize", phaseStart, 0);
+
+    if (cachePath != NULL) {
+        phaseStart = clock();
+        saveCache(cachePath, source, sourceLength, statements, lazyBodies);
+        reportPhase("save", phaseStart, 0);
+    }
+
+    execute(source, statements);
+}
+
+// run what the front end made of source, then free it
+static void execute(const char* source, StmtList* statements) {
+    clock_t phaseStart = clock();
+    program = statements;
     interpretStatements(statements);
+    reportPhase("run", phaseStart, 0);
+    if (lazyTime > 0) printPhase("lazy", lazyTime, 0); // bodies parsed as they were called, part of run
+    if (memoize && dumpOptimizations) printMemoStats();
+    snapshot(source);
 
-    // clean up
+    // clean up. compiled code points into the AST, so it goes first
+    freeCompiledCode();
     freeStmtList(statements);
-    freeTokens(tokens, tokenCount);
+    program = NULL;
+    freeOptimizer();
+    freeAstPool();
+}
+
+// --stream: parse, resolve and run one top-level declaration at a time, and
+// free its nodes before reading the next. output starts as soon as the first
+// statement is read, and the AST only ever holds the current statement plus
+// the ones declaring functions, which function objects still point into.
+//
+// the optimizer doesn't run here. its analyses assume they see the whole
+// program: every function a loop could call, every assignment to a global.
+static void runStream(const char* source) {
+    size_t sourceLength = strlen(source);
+    clock_t streamStart = clock();
+    clock_t parseTime = 0, resolveTime = 0, runTime = 0, firstRun = 0;
+    bool ranFirst = false;
+
+    Scanner scanner;
+    initScanner(&scanner, source);
+    Parser parser;
+    initParser(&parser, &scanner);
+
+    for (;;) {
+        PoolMark mark = poolMark();
+        int loadedBefore = bodiesLoaded;
+
+        clock_t phaseStart = clock();
+        Stmt* stmt = parseDeclaration(&parser);
+        parseTime += clock() - phaseStart;
+        if (stmt == NULL) {
+            if (hadParserError(&parser)) hadScanParseError = true;
+            poolRelease(mark); // nodes of a statement that failed to parse
+            break;
+        }
+        NodeIndex declaration = nodeIndex(stmt);
+        StmtList* statements = newStmtList(&declaration, 1);
+
+        phaseStart = clock();
+        resolve(NULL, statements);
+        resolveTime += clock() - phaseStart;
+        if (hadResolverError()) {
+            hadScanParseError = true;
+            freeStmtList(statements);
+            poolRelease(mark);
+            break;
+        }
+
+        phaseStart = clock();
+        interpretStatements(statements);
+        runTime += clock() - phaseStart;
+        if (!ranFirst) {
+            firstRun = clock() - streamStart;
+            ranFirst = true;
+        }
+
+        // compiled code points into the statement. function bodies are
+        // compiled again on their next call. bodies of functions from an
+        // image parsed while it ran went in the pool after mark, so they keep
+        // it alive too.
+        freeCompiledCode();
+        if (!declaresFunction(stmt) && bodiesLoaded == loadedBefore) {
+            freeStmtList(statements);
+            poolRelease(mark);
+        }
+        if (hadRuntimeError()) break;
+    }
+
+    printPhase("parse", parseTime, sourceLength);
+    printPhase("resolve", resolveTime, 0);
+    printPhase("run", runTime, 0);
+    printPhase("first", firstRun, 0); // from the start until the first statement had run
+
+    snapshot(source);
+    freeAstPool(); // the function declarations kept above
 }
@@ -0,0 +1,197 @@
+#include "memo.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "memory.h"
+
+static MemoTable* allTables = NULL;
+
+MemoTable* newMemoTable(const char* name, int length, int arity) {
+    MemoTable* table = ALLOCATE(MemoTable, 1);
+    table->name = ALLOCATE(char, length + 1);
+    memcpy(table->name, name, length);
+    table->name[length] = '\0';
+    table->arity = arity;
+    table->count = 0;
+
+    // keep the load factor at or below one half once full
+    table->bucketCount = 8;
+    while (table->bucketCount < MEMO_CAPACITY * 2) {
+        table->bucketCount *= 2;
+    }
+    table->buckets = ALLOCATE(MemoEntry*, table->bucketCount);
+    for (int i = 0; i < table->bucketCount; i++) {
+        table->buckets[i] = NULL;
+    }
+    table->newest = NULL;
+    table->oldest = NULL;
+
+    table->hits = 0;
+    table->misses = 0;
+    table->evictions = 0;
+
+    table->next = allTables;
+    allTables = table;
+    return table;
+}
+
+// --- Keys ---
+
+static uint32_t hashBytes(uint32_t hash, const void* bytes, size_t length) {
+    // FNV-1a
+    const unsigned char* p = (const unsigned char*)bytes;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= p[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static uint32_t hashArgs(Value* args, int arity) {
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < arity; i++) {
+        Value value = args[i];
+        hash = hashBytes(hash, &value.type, sizeof(value.type));
+        switch (value.type) {
+            case VAL_BOOL:
+                hash = hashBytes(hash, &value.as.boolean, sizeof(bool));
+                break;
+            case VAL_NIL:
+                break;
+            case VAL_NUMBER: {
+                // -0 and 0 compare equal, so they must hash the same
+                double number = AS_NUMBER(value) == 0 ? 0 : AS_NUMBER(value);
+                hash = hashBytes(hash, &number, sizeof(double));
+                break;
+            }
+            case VAL_OBJ:
+                if (IS_STRING(value)) {
+                    hash = hashBytes(hash, AS_STRING(value)->chars, AS_STRING(value)->length);
+                } else {
+                    hash = hashBytes(hash, &value.as.obj, sizeof(Obj*));
+                }
+                break;
+        }
+    }
+    return hash;
+}
+
+// like valuesEqual, but other objects are compared by identity
+static bool keyEquals(Value a, Value b) {
+    if (IS_OBJ(a) && IS_OBJ(b) && !(IS_STRING(a) && IS_STRING(b))) {
+        return AS_OBJ(a) == AS_OBJ(b);
+    }
+    return valuesEqual(a, b);
+}
+
+static bool argsEqual(Value* a, Value* b, int arity) {
+    for (int i = 0; i < arity; i++) {
+        if (!keyEquals(a[i], b[i])) return false;
+    }
+    return true;
+}
+
+// --- LRU List ---
+
+static void unlinkEntry(MemoTable* table, MemoEntry* entry) {
+    if (entry->newer != NULL) {
+        entry->newer->older = entry->older;
+    } else {
+        table->newest = entry->older;
+    }
+    if (entry->older != NULL) {
+        entry->older->newer = entry->newer;
+    } else {
+        table->oldest = entry->newer;
+    }
+}
+
+static void pushNewest(MemoTable* table, MemoEntry* entry) {
+    entry->newer = NULL;
+    entry->older = table->newest;
+    if (table->newest != NULL) table->newest->newer = entry;
+    table->newest = entry;
+    if (table->oldest == NULL) table->oldest = entry;
+}
+
+// --- Lookup and Insertion ---
+
+bool memoGet(MemoTable* table, Value* args, Value* outResult) {
+    uint32_t hash = hashArgs(args, table->arity);
+    MemoEntry* entry = table->buckets[hash & (table->bucketCount - 1)];
+    for (; entry != NULL; entry = entry->chain) {
+        if (entry->hash == hash && argsEqual(entry->args, args, table->arity)) {
+            // move to the front of the lru list
+            unlinkEntry(table, entry);
+            pushNewest(table, entry);
+            *outResult = entry->result;
+            table->hits++;
+            return true;
+        }
+    }
+    table->misses++;
+    return false;
+}
+
+static void removeFromBucket(MemoTable* table, MemoEntry* entry) {
+    MemoEntry** slot = &table->buckets[entry->hash & (table->bucketCount - 1)];
+    while (*slot != entry) {
+        slot = &(*slot)->chain;
+    }
+    *slot = entry->chain;
+}
+
+void memoSet(MemoTable* table, Value* args, Value result) {
+    MemoEntry* entry;
+    if (table->count >= MEMO_CAPACITY) {
+        // reuse the least recently used entry
+        entry = table->oldest;
+        unlinkEntry(table, entry);
+        removeFromBucket(table, entry);
+        table->evictions++;
+    } else {
+        entry = (MemoEntry*)reallocate(NULL, sizeof(MemoEntry) + sizeof(Value) * table->arity);
+        table->count++;
+    }
+
+    entry->hash = hashArgs(args, table->arity);
+    entry->result = result;
+    memcpy(entry->args, args, sizeof(Value) * table->arity);
+
+    MemoEntry** bucket = &table->buckets[entry->hash & (table->bucketCount - 1)];
+    entry->chain = *bucket;
+    *bucket = entry;
+    pushNewest(table, entry);
+}
+
+// --- Stats and Cleanup ---
+
+void printMemoStats() {
+    for (MemoTable* table = allTables; table != NULL; table = table->next) {
+        long calls = table->hits + table->misses;
+        fprintf(stderr, "memo: %s: %ld hits, %ld misses (%.1f%% hit rate), %d cached, %ld evicted\n",
+                table->name, table->hits, table->misses,
+                calls > 0 ? 100.0 * table->hits / calls : 0.0,
+                table->count, table->evictions);
+    }
+}
+
+void freeMemoTables() {
+    MemoTable* table = allTables;
+    while (table != NULL) {
+        MemoTable* next = table->next;
+        MemoEntry* entry = table->newest;
+        while (entry != NULL) {
+            MemoEntry* older = entry->older;
+            FREE(MemoEntry, entry);
+            entry = older;
+        }
+        FREE_ARRAY(MemoEntry*, table->buckets, table->bucketCount);
+        FREE(char, table->name);
+        FREE(MemoTable, table);
+        table = next;
+    }
+    allTables = NULL;
+}
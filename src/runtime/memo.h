@@ -0,0 +1,53 @@
+#ifndef sg_memo_h
+#define sg_memo_h
+
+#include "object.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// max number of cached results per function, least recently used go first
+#define MEMO_CAPACITY 1024
+
+typedef struct MemoEntry MemoEntry;
+
+struct MemoEntry {
+    uint32_t hash;
+    Value result;
+    MemoEntry* chain; // next entry in the same bucket
+    MemoEntry* newer; // lru list, towards most recently used
+    MemoEntry* older; // lru list, towards least recently used
+    Value args[]; // arity argument values, the key
+};
+
+typedef struct MemoTable {
+    char* name; // function name, for stats
+    int arity;
+    int count;
+    int bucketCount; // power of two
+    MemoEntry** buckets;
+    MemoEntry* newest;
+    MemoEntry* oldest;
+
+    long hits;
+    long misses;
+    long evictions;
+
+    struct MemoTable* next; // every table is kept on one list for stats and cleanup
+} MemoTable;
+
+// create a memo table for a function taking arity arguments
+MemoTable* newMemoTable(const char* name, int length, int arity);
+
+// look up a cached result for these arguments. counts a hit or a miss.
+bool memoGet(MemoTable* table, Value* args, Value* outResult);
+
+// remember a result, evicting the least recently used one when full
+void memoSet(MemoTable* table, Value* args, Value result);
+
+// print hit/miss counters of every table to stderr
+void printMemoStats();
+
+// free every memo table created so far
+void freeMemoTables();
+
+#endif
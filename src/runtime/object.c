@@ -48,14 +48,15 @@ void printObject(Value value) {
             break;
         case OBJ_FUNCTION: {
             ObjFunction* function = AS_FUNCTION(value);
-            printf("<fn %.*s>",
-                   function->declaration->as.function.name.length,
-                   function->declaration->as.function.name.start);
+            printf("<fn %s>", symbolName(TOKEN_AT(AS_FUNCTION_STMT(function->declaration)->name)->symbol));
             break;
         }
         case OBJ_NATIVE:
             printf("<native fn>");
             break;
+        case OBJ_UPVALUE:
+            printf("upvalue");
+            break;
     }
 }
 
@@ -101,15 +102,33 @@ bool valuesEqual(Value a, Value b) {
     }
 }
 
-ObjFunction* newFunction(Stmt* declaration, Environment* closure) {
+ObjFunction* newFunction(Stmt* declaration) {
     ObjFunction* function = (ObjFunction*)allocateObject(sizeof(ObjFunction), OBJ_FUNCTION);
     if (function == NULL) return NULL;
     function->declaration = declaration;
-    function->closure = closure;
-    function->arity = declaration->as.function.param_count;
+    function->arity = AS_FUNCTION_STMT(declaration)->param_count;
+    function->upvalueCount = AS_FUNCTION_STMT(declaration)->upvalueCount;
+    function->upvalues = NULL;
+    if (function->upvalueCount > 0) {
+        function->upvalues = ALLOCATE(ObjUpvalue*, function->upvalueCount);
+        for (int i = 0; i < function->upvalueCount; i++) {
+            function->upvalues[i] = NULL;
+        }
+    }
+    function->memo = NULL;
     return function;
 }
 
+ObjUpvalue* newUpvalue(Value* location, StaticType type, int slot) {
+    ObjUpvalue* upvalue = (ObjUpvalue*)allocateObject(sizeof(ObjUpvalue), OBJ_UPVALUE);
+    upvalue->location = location;
+    upvalue->closed = NIL_VAL;
+    upvalue->type = type;
+    upvalue->slot = slot;
+    upvalue->next = NULL;
+    return upvalue;
+}
+
 ObjNative* newNative(int arity, Value (*function)(struct Interpreter*, int, Value*)) {
     ObjNative* native = (ObjNative*)allocateObject(sizeof(ObjNative), OBJ_NATIVE);
     native->arity = arity;
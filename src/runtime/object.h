@@ -10,6 +10,7 @@ typedef struct Obj Obj;
 typedef struct Interpreter Interpreter;
 struct Environment;
 typedef struct Environment Environment;
+typedef struct MemoTable MemoTable;
 
 typedef enum {
     VAL_BOOL,
@@ -31,7 +32,8 @@ typedef struct {
 typedef enum {
     OBJ_FUNCTION,
     OBJ_NATIVE,
-    OBJ_STRING
+    OBJ_STRING,
+    OBJ_UPVALUE
 } ObjType;
 
 struct Obj {
@@ -44,11 +46,28 @@ typedef struct {
     char* chars;
 } ObjString;
 
+// a variable a function captured from around it (see Upvalue in stmt.h).
+// while the scope it was declared in runs it is open: location points at the
+// variable's entry there, so both see the same value. when the scope ends
+// the value moves into closed and location points there instead.
+typedef struct ObjUpvalue {
+    Obj obj;
+    Value* location;
+    Value closed;
+    StaticType type; // the variable's declared type, for assignments
+    int slot; // while open: its entry, kept in case the entries move
+    struct ObjUpvalue* next; // the other open ones of the same scope
+} ObjUpvalue;
+
+// functions only keep the variables they use from around them. everything
+// else they name is their own or a global.
 typedef struct {
     Obj obj;
     int arity;
     Stmt* declaration;
-    Environment* closure;
+    ObjUpvalue** upvalues; // as declaration's upvalues say
+    int upvalueCount;
+    MemoTable* memo; // cached results, only for pure functions under --memoize
 } ObjFunction;
 
 typedef struct {
@@ -96,8 +115,9 @@ void printValue(Value value);
 // Function to check equality (needed later for interpreter)
 bool valuesEqual(Value a, Value b);
 
-// Function object constructors
-ObjFunction* newFunction(Stmt* declaration, Environment* closure);
+// Function object constructors. the caller fills in the upvalues.
+ObjFunction* newFunction(Stmt* declaration);
+ObjUpvalue* newUpvalue(Value* location, StaticType type, int slot);
 ObjNative* newNative(int arity, Value (*function)(struct Interpreter*, int, Value*));
 
 Obj* allocateObject(size_t size, ObjType type);
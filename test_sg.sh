@@ -0,0 +1,141 @@
+#!/bin/sh
+# runs every program in tests/ the ways sing can run it and checks they all
+# behave like a plain run with no cache: the same output, errors and exit
+# status. that run has to match the .out file next to the test, which holds
+# what the // Expected: comments say, so a bug every mode shares still fails.
+# tests/image/ is run from a heap image of its prelude.
+# usage: ./test_sg.sh [path to sing]
+SING=${1:-build/sing}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+failures=0
+
+# run sing with the given arguments, output and exit status into file $1
+run() {
+    out=$1
+    shift
+    "$SING" "$@" > "$out" 2>&1
+    echo "exit $?" >> "$out"
+}
+
+# run sing with the given arguments, only its errors and exit status into $1
+errors() {
+    out=$1
+    shift
+    "$SING" "$@" 2>&1 > /dev/null | cat > "$out"
+    "$SING" "$@" > /dev/null 2>&1
+    echo "exit $?" >> "$out"
+}
+
+# compare the reference run against the expected output in file $1
+expect() {
+    if ! cmp -s "$1" "$WORK/reference"; then
+        echo "FAIL $test (expected output)"
+        diff "$1" "$WORK/reference" | head -10
+        failures=$((failures + 1))
+    fi
+}
+
+# compare a run's result against the test's reference run
+check() {
+    name=$1
+    if ! cmp -s "$WORK/reference" "$WORK/$name"; then
+        echo "FAIL $test ($name)"
+        diff "$WORK/reference" "$WORK/$name" | head -10
+        failures=$((failures + 1))
+    fi
+}
+
+for test in tests/*.sg; do
+    cache=${test}c
+    rm -f "$cache"
+    run "$WORK/reference" --no-cache "$test"
+    expect "${test%.sg}.out"
+    rejected=false
+    if grep -q "Aiyo problem sia" "$WORK/reference"; then
+        rejected=true
+        # nothing runs unless the front end accepts the whole script
+        if [ -n "$("$SING" --no-cache "$test" 2> /dev/null)" ]; then
+            echo "FAIL $test (ran despite errors)"
+            failures=$((failures + 1))
+        fi
+    fi
+
+    # the first run saves a cache, the second runs from it. both have to match,
+    # including what the optimizer left behind ($temps, skipped bodies, jumps)
+    run "$WORK/cold" "$test"
+    check cold
+    run "$WORK/cached" "$test"
+    check cached
+    if ! $rejected && ! "$SING" --time-phases "$test" 2>&1 > /dev/null | grep -q "\[time\] load"; then
+        echo "FAIL $test (cache not used)"
+        failures=$((failures + 1))
+    fi
+
+    # --lazy only reports errors in a function body once it is called, so it
+    # can only match scripts the front end accepts. it has to take the cache
+    # the runs above saved, and a normal run must not take the one it saves,
+    # which holds bodies nothing checked yet
+    if ! $rejected; then
+        run "$WORK/lazy" --lazy "$test"
+        check lazy
+    fi
+    rm -f "$cache"
+    run "$WORK/lazy-cold" --lazy "$test"
+    $rejected || check lazy-cold
+    run "$WORK/lazy-cached" --lazy "$test"
+    $rejected || check lazy-cached
+    run "$WORK/after-lazy" "$test"
+    check after-lazy
+    rm -f "$cache"
+
+    run "$WORK/closure" --no-cache --engine=closure "$test"
+    check closure
+    run "$WORK/memoize" --no-cache --memoize "$test"
+    check memoize
+
+    # streaming runs each statement before parsing the next, so a script the
+    # front end rejects prints whatever came before the error. the errors and
+    # exit status still have to match
+    if $rejected; then
+        errors "$WORK/reference" --no-cache "$test"
+        errors "$WORK/stream" --stream "$test"
+    else
+        run "$WORK/stream" --stream "$test"
+    fi
+    check stream
+done
+
+# a prelude saved with --snapshot and loaded with --image has to leave main.sg
+# the same globals as running the prelude in front of it
+test=tests/image/main.sg
+prelude=tests/image/prelude.sg
+cat "$prelude" "$test" | "$SING" - > "$WORK/both" 2>&1
+echo "exit $?" >> "$WORK/both"
+"$SING" --no-cache "$prelude" > "$WORK/prelude" 2>&1
+tail -n +"$(($(wc -l < "$WORK/prelude") + 1))" "$WORK/both" > "$WORK/reference"
+expect tests/image/main.out
+run "$WORK/snapshot" --no-cache --snapshot "$WORK/prelude.img" "$prelude"
+if ! grep -q "exit 0" "$WORK/snapshot"; then
+    echo "FAIL $prelude (snapshot)"
+    failures=$((failures + 1))
+fi
+run "$WORK/image" --image "$WORK/prelude.img" "$test"
+check image
+run "$WORK/image-closure" --engine=closure --image "$WORK/prelude.img" "$test"
+check image-closure
+
+# the REPL runs every line as a program of its own, so a later line can
+# rebind what a function called earlier calls. --memoize must not hand back
+# what it returned before
+test=tests/repl/rebind.sg
+"$SING" < "$test" > "$WORK/reference" 2>&1
+expect tests/repl/rebind.out
+"$SING" --memoize < "$test" > "$WORK/repl-memoize" 2>&1
+check repl-memoize
+
+if [ "$failures" -ne 0 ]; then
+    echo "$failures failed"
+    exit 1
+fi
+echo "all tests passed"
@@ -0,0 +1,127 @@
+// generates the scanner's keyword table from src/frontend/keywords.def.
+// finds a hash over (first letter, last letter, length) of each keyword's
+// first word that puts every keyword in its own slot of a power-of-two
+// table, so the scanner needs one hash and one memcmp per identifier.
+//
+// usage: genkeywords keywords.def > keywords.h
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_KEYWORDS 64
+#define MAX_TABLE 256
+#define MAX_MULTIPLIER 64
+
+typedef struct {
+    char phrase[64];
+    int wordLength; // first word only, that is what the scanner hashes
+    int phraseLength;
+    char token[64];
+} Keyword;
+
+static Keyword keywords[MAX_KEYWORDS];
+static int keywordCount = 0;
+
+static unsigned hashOf(Keyword* keyword, unsigned first, unsigned last, unsigned length, unsigned mask) {
+    unsigned char* word = (unsigned char*)keyword->phrase;
+    return (word[0] * first + word[keyword->wordLength - 1] * last + keyword->wordLength * length) & mask;
+}
+
+static bool collides(unsigned first, unsigned last, unsigned length, unsigned mask) {
+    bool used[MAX_TABLE] = { false };
+    for (int i = 0; i < keywordCount; i++) {
+        unsigned slot = hashOf(&keywords[i], first, last, length, mask);
+        if (used[slot]) return true;
+        used[slot] = true;
+    }
+    return false;
+}
+
+static void readKeywords(FILE* file) {
+    char line[256];
+    int lineNumber = 0;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        lineNumber++;
+        line[strcspn(line, "#\r\n")] = '\0';
+
+        // the token is the last field, everything before it the spelling
+        char* end = line + strlen(line);
+        while (end > line && (end[-1] == ' ' || end[-1] == '\t')) end--;
+        *end = '\0';
+        if (end == line) continue;
+        char* token = strrchr(line, ' ');
+        char* tab = strrchr(line, '\t');
+        if (tab > token) token = tab;
+        if (token == NULL) {
+            fprintf(stderr, "keywords.def:%d: expected a keyword and a token\n", lineNumber);
+            exit(1);
+        }
+        *token++ = '\0';
+        end = token - 1;
+        while (end > line && (end[-1] == ' ' || end[-1] == '\t')) end--;
+        *end = '\0';
+
+        if (keywordCount == MAX_KEYWORDS || strlen(line) >= sizeof(keywords[0].phrase)) {
+            fprintf(stderr, "keywords.def:%d: too many or too long keywords\n", lineNumber);
+            exit(1);
+        }
+        Keyword* keyword = &keywords[keywordCount];
+        strcpy(keyword->phrase, line);
+        strcpy(keyword->token, token);
+        keyword->phraseLength = (int)strlen(line);
+        keyword->wordLength = (int)strcspn(line, " ");
+
+        for (int i = 0; i < keywordCount; i++) {
+            if (keywords[i].wordLength == keyword->wordLength && memcmp(keywords[i].phrase, keyword->phrase, keyword->wordLength) == 0) {
+                fprintf(stderr, "keywords.def:%d: '%s' starts with the same word as '%s'\n", lineNumber, keyword->phrase, keywords[i].phrase);
+                exit(1);
+            }
+        }
+        keywordCount++;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: genkeywords keywords.def > keywords.h\n");
+        return 64;
+    }
+    FILE* file = fopen(argv[1], "r");
+    if (file == NULL) {
+        fprintf(stderr, "genkeywords: cannot open %s\n", argv[1]);
+        return 74;
+    }
+    readKeywords(file);
+    fclose(file);
+
+    // smallest table first, then the smallest multipliers that work
+    for (unsigned size = 16; size <= MAX_TABLE; size *= 2) {
+        if (size < (unsigned)keywordCount) continue;
+        for (unsigned first = 1; first < MAX_MULTIPLIER; first++) {
+            for (unsigned last = 1; last < MAX_MULTIPLIER; last++) {
+                for (unsigned length = 0; length < MAX_MULTIPLIER; length++) {
+                    if (collides(first, last, length, size - 1)) continue;
+
+                    printf("// generated by tools/genkeywords.c from src/frontend/keywords.def, do not edit\n\n");
+                    printf("#define KEYWORD_TABLE_SIZE %u\n\n", size);
+                    printf("// start and length of the identifier just scanned, length > 0\n");
+                    printf("#define KEYWORD_HASH(start, length) \\\n");
+                    printf("    ((((unsigned char)(start)[0]) * %uu + ((unsigned char)(start)[(length) - 1]) * %uu + (unsigned)(length) * %uu) & %uu)\n\n",
+                           first, last, length, size - 1);
+                    printf("static const Keyword keywords[KEYWORD_TABLE_SIZE] = {\n");
+                    for (int i = 0; i < keywordCount; i++) {
+                        Keyword* keyword = &keywords[i];
+                        printf("    [%u] = { \"%s\", %d, %d, %s },\n", hashOf(keyword, first, last, length, size - 1),
+                               keyword->phrase, keyword->wordLength, keyword->phraseLength, keyword->token);
+                    }
+                    printf("};\n");
+                    return 0;
+                }
+            }
+        }
+    }
+    fprintf(stderr, "genkeywords: no collision-free hash found\n");
+    return 1;
+}